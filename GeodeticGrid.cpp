@@ -0,0 +1,89 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "GeodeticGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/constants.hpp>
+
+// keeps tiles that only touch at an edge apart
+static const double EDGE_EPSILON = 1e-9;
+
+// map y, 1 at the top, of a latitude in radians
+static double mapY(double latitude) {
+    return std::log(std::tan(glm::quarter_pi<double>() + latitude / 2)) / glm::pi<double>();
+}
+
+static double latitudeAt(double mapY) {
+    return std::atan(std::sinh(glm::pi<double>() * mapY));
+}
+
+// first and last row between two edges, given in rows from the top
+static std::pair<uint32_t, uint32_t> rowSpan(double from, double to, uint32_t rows) {
+    const double last = static_cast<double>(rows) - 1;
+    return {
+            static_cast<uint32_t>(std::clamp(std::floor(from + EDGE_EPSILON), 0., last)),
+            static_cast<uint32_t>(std::clamp(std::ceil(to - EDGE_EPSILON) - 1, 0., last)),
+    };
+}
+
+uint32_t geodeticLayerFor(uint32_t mapLayer) {
+    return mapLayer > 0 ? mapLayer - 1 : 0;
+}
+
+std::vector<TileKey> geodeticTilesCovering(const TileKey &mapTile) {
+    const uint32_t layer = geodeticLayerFor(mapTile.layer);
+    const uint32_t rows = 1U << layer;
+    const double mapTiles = static_cast<double>(1U << mapTile.layer);
+    const auto rowOf = [&](double y) {
+        return (.5 - latitudeAt(y) / glm::pi<double>()) * rows;
+    };
+    const auto [firstRow, lastRow] = rowSpan(rowOf(1 - 2 * mapTile.row / mapTiles),
+                                             rowOf(1 - 2 * (mapTile.row + 1) / mapTiles), rows);
+    // a map tile is as wide as a source tile, but the one of layer 0 spans both hemispheres
+    const uint32_t firstColumn = mapTile.layer > 0 ? mapTile.column : 0;
+    const uint32_t lastColumn = mapTile.layer > 0 ? mapTile.column : 1;
+
+    std::vector<TileKey> tiles;
+    for (uint32_t row = firstRow; row <= lastRow; row++) {
+        for (uint32_t column = firstColumn; column <= lastColumn; column++) {
+            tiles.push_back({layer, row, column});
+        }
+    }
+    return tiles;
+}
+
+std::vector<TileKey> mapTilesShowing(const TileKey &geodeticTile) {
+    const double rows = static_cast<double>(1U << geodeticTile.layer);
+    const double top = glm::half_pi<double>() - glm::pi<double>() * geodeticTile.row / rows;
+    const double bottom = glm::half_pi<double>() - glm::pi<double>() * (geodeticTile.row + 1) / rows;
+    // the map ends where its y reaches 1
+    const double maxLatitude = latitudeAt(1);
+    if (bottom >= maxLatitude || top <= -maxLatitude) {
+        return {};
+    }
+
+    std::vector<TileKey> tiles;
+    for (uint32_t mapLayer: {geodeticTile.layer + 1, 0U}) {
+        if (geodeticLayerFor(mapLayer) != geodeticTile.layer) {
+            continue;
+        }
+        const uint32_t mapTiles = 1U << mapLayer;
+        const auto rowOf = [&](double latitude) {
+            return (1 - mapY(std::clamp(latitude, -maxLatitude, maxLatitude))) / 2 * mapTiles;
+        };
+        const auto [firstRow, lastRow] = rowSpan(rowOf(top), rowOf(bottom), mapTiles);
+        const uint32_t column = mapLayer > 0 ? geodeticTile.column : 0;
+        for (uint32_t row = firstRow; row <= lastRow; row++) {
+            tiles.push_back({mapLayer, row, column});
+        }
+    }
+    return tiles;
+}
+
+uint32_t geodeticSlot(const TileKey &geodeticTile) {
+    // the tiles of a map tile are neighbours, so their parities differ
+    return (geodeticTile.row & 1) * 2 + (geodeticTile.column & 1);
+}
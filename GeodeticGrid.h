@@ -0,0 +1,37 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_GEODETICGRID_H
+#define MAPENGINE_GEODETICGRID_H
+
+#include <cstdint>
+#include <vector>
+
+#include "TileKey.h"
+
+// Tiles of an EPSG:4326 (plate carrée) pyramid, drawn into the Web Mercator map tiles. Layer n has 2^(n+1)
+// columns and 2^n rows of tiles 180 / 2^n degrees square, row 0 at the north pole and column 0 at the
+// antimeridian.
+
+/**
+ * @return layer of the source tiles drawn into map tiles of this layer, same resolution at the equator
+ */
+uint32_t geodeticLayerFor(uint32_t mapLayer);
+
+/**
+ * Selects the source tiles a map tile shows, at most two.
+ */
+std::vector<TileKey> geodeticTilesCovering(const TileKey &mapTile);
+
+/**
+ * @return map tiles showing the source tile, none when it lies beyond the latitudes the map reaches
+ */
+std::vector<TileKey> mapTilesShowing(const TileKey &geodeticTile);
+
+/**
+ * @return which of a map tile's texture slots holds the source tile, tile_instanced.frag picks it the same way
+ */
+uint32_t geodeticSlot(const TileKey &geodeticTile);
+
+#endif //MAPENGINE_GEODETICGRID_H
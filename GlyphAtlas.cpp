@@ -0,0 +1,176 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#define STB_TRUETYPE_IMPLEMENTATION
+
+#include "GlyphAtlas.h"
+
+#include <stb_truetype.h>
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+#include <limits>
+
+static std::vector<uint32_t> decodeUtf8(const std::string &text) {
+    std::vector<uint32_t> codepoints;
+    codepoints.reserve(text.size());
+    for (size_t i = 0; i < text.size();) {
+        auto c = static_cast<unsigned char>(text[i]);
+        uint32_t codepoint;
+        size_t length;
+        if (c < 0x80) {
+            codepoint = c;
+            length = 1;
+        } else if ((c & 0xE0) == 0xC0) {
+            codepoint = c & 0x1F;
+            length = 2;
+        } else if ((c & 0xF0) == 0xE0) {
+            codepoint = c & 0x0F;
+            length = 3;
+        } else {
+            codepoint = c & 0x07;
+            length = 4;
+        }
+        if (i + length > text.size()) {
+            break;
+        }
+        for (size_t j = 1; j < length; j++) {
+            codepoint = (codepoint << 6) | (static_cast<unsigned char>(text[i + j]) & 0x3F);
+        }
+        codepoints.push_back(codepoint);
+        i += length;
+    }
+    return codepoints;
+}
+
+GlyphAtlas::GlyphAtlas() : pixels(ATLAS_SIZE * ATLAS_SIZE, 0) {
+}
+
+GlyphAtlas::~GlyphAtlas() = default;
+
+uint32_t GlyphAtlas::addFont(const char *path) {
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open font " + std::string(path) + "!");
+    }
+    Font font;
+    font.data.resize(file.tellg());
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(font.data.data()), static_cast<std::streamsize>(font.data.size()));
+
+    font.info = std::make_unique<stbtt_fontinfo>();
+    if (!stbtt_InitFont(font.info.get(), font.data.data(), stbtt_GetFontOffsetForIndex(font.data.data(), 0))) {
+        throw std::runtime_error("failed to read font " + std::string(path) + "!");
+    }
+    font.scale = stbtt_ScaleForPixelHeight(font.info.get(), BASE_SIZE);
+    int ascent, descent, lineGap;
+    stbtt_GetFontVMetrics(font.info.get(), &ascent, &descent, &lineGap);
+    font.ascent = static_cast<float>(ascent) * font.scale;
+    font.descent = static_cast<float>(descent) * font.scale;
+
+    fonts.push_back(std::move(font));
+    return static_cast<uint32_t>(fonts.size() - 1);
+}
+
+uint32_t GlyphAtlas::glyphFor(uint32_t fontId, uint32_t codepoint) {
+    const uint64_t key = (static_cast<uint64_t>(fontId) << 32) | codepoint;
+    if (auto it = glyphIndices.find(key); it != glyphIndices.end()) {
+        return it->second;
+    }
+
+    const Font &font = fonts[fontId];
+    Glyph glyph{};
+    glyph.index = stbtt_FindGlyphIndex(font.info.get(), static_cast<int>(codepoint));
+    int advance, leftSideBearing;
+    stbtt_GetGlyphHMetrics(font.info.get(), glyph.index, &advance, &leftSideBearing);
+    glyph.advance = static_cast<float>(advance) * font.scale;
+
+    int width = 0, height = 0, xOffset = 0, yOffset = 0;
+    unsigned char *sdf = stbtt_GetGlyphSDF(font.info.get(), font.scale, glyph.index, PADDING, 128, SDF_SCALE,
+                                           &width, &height, &xOffset, &yOffset);
+    // shelf packing, one pixel gap so that linear filtering does not bleed
+    if (sdf && shelfX + width + 1 > ATLAS_SIZE) {
+        shelfX = 0;
+        shelfY += shelfHeight + 1;
+        shelfHeight = 0;
+    }
+    if (sdf && shelfY + height > ATLAS_SIZE) {
+        // the glyph is kept without an image, like a space, so that labels still lay out
+        stbtt_FreeSDF(sdf, nullptr);
+        sdf = nullptr;
+        if (!full) {
+            std::cout << "Glyph atlas is full, new glyphs are not drawn" << std::endl;
+            full = true;
+        }
+    }
+    if (sdf) {
+        for (int row = 0; row < height; row++) {
+            std::copy_n(sdf + row * width, width, pixels.begin() + (shelfY + row) * ATLAS_SIZE + shelfX);
+        }
+        stbtt_FreeSDF(sdf, nullptr);
+
+        if (dirtyBegin == dirtyEnd) {
+            dirtyBegin = shelfY;
+            dirtyEnd = shelfY + height;
+        } else {
+            dirtyBegin = std::min(dirtyBegin, shelfY);
+            dirtyEnd = std::max(dirtyEnd, shelfY + static_cast<uint32_t>(height));
+        }
+
+        glyph.uv = glm::vec4(shelfX, shelfY, shelfX + width, shelfY + height) / static_cast<float>(ATLAS_SIZE);
+        glyph.size = glm::vec2(width, height);
+        glyph.bearing = glm::vec2(xOffset, yOffset);
+        shelfX += width + 1;
+        shelfHeight = std::max(shelfHeight, static_cast<uint32_t>(height));
+    }
+
+    glyphs.push_back(glyph);
+    const auto index = static_cast<uint32_t>(glyphs.size() - 1);
+    glyphIndices.emplace(key, index);
+    return index;
+}
+
+const ShapedRun &GlyphAtlas::shape(const std::string &text, uint32_t font, float size) {
+    RunKey key{text, font, size};
+    if (auto it = runs.find(key); it != runs.end()) {
+        return it->second;
+    }
+
+    const float scale = size / BASE_SIZE;
+    ShapedRun run;
+    float pen = 0;
+    int previous = -1;
+    for (uint32_t codepoint: decodeUtf8(text)) {
+        const uint32_t index = glyphFor(font, codepoint);
+        const Glyph &glyph = glyphs[index];
+        if (previous >= 0) {
+            pen += static_cast<float>(stbtt_GetGlyphKernAdvance(fonts[font].info.get(), previous, glyph.index)) *
+                   fonts[font].scale;
+        }
+        if (glyph.size.x > 0) {
+            run.glyphs.push_back({index, (glm::vec2(pen, 0) + glyph.bearing) * scale, glyph.size * scale});
+        }
+        pen += glyph.advance;
+        previous = glyph.index;
+    }
+
+    // center on the anchor
+    const float top = -fonts[font].ascent * scale;
+    const float bottom = -fonts[font].descent * scale;
+    run.size = glm::vec2(pen * scale, bottom - top);
+    const glm::vec2 center(run.size.x / 2, (top + bottom) / 2);
+    for (auto &glyph: run.glyphs) {
+        glyph.offset -= center;
+    }
+
+    return runs.emplace(std::move(key), std::move(run)).first->second;
+}
+
+std::pair<uint32_t, uint32_t> GlyphAtlas::takeDirtyRows() {
+    std::pair<uint32_t, uint32_t> rows{dirtyBegin, dirtyEnd};
+    dirtyBegin = dirtyEnd = 0;
+    return rows;
+}
@@ -0,0 +1,117 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_GLYPHATLAS_H
+#define MAPENGINE_GLYPHATLAS_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+struct stbtt_fontinfo;
+
+struct ShapedGlyph {
+    uint32_t glyph; // GlyphAtlas::getGlyph
+    glm::vec2 offset; // top left corner relative to the run center, pixels
+    glm::vec2 size; // pixels
+};
+
+struct ShapedRun {
+    std::vector<ShapedGlyph> glyphs;
+    glm::vec2 size; // pixels
+};
+
+/**
+ * Signed distance field glyphs of every font packed into one single channel atlas.
+ *
+ * Glyphs are rasterized once at BASE_SIZE, on first use, and scaled on the GPU. Distance 0 is at 128,
+ * each 1/SDF_SCALE step is one pixel at BASE_SIZE.
+ * Glyphs that no longer fit into the atlas keep their metrics but are not drawn.
+ */
+class GlyphAtlas {
+public:
+    static const uint32_t ATLAS_SIZE = 2048;
+    static const int BASE_SIZE = 32;
+    static const int PADDING = 4;
+    static constexpr float SDF_SCALE = 128.f / PADDING;
+
+    struct Glyph {
+        glm::vec4 uv; // u0, v0, u1, v1
+        glm::vec2 size; // pixels at BASE_SIZE, includes padding
+        glm::vec2 bearing; // top left corner relative to the pen, pixels at BASE_SIZE
+        float advance; // pixels at BASE_SIZE
+        int index; // glyph index in the font
+    };
+
+    GlyphAtlas();
+    ~GlyphAtlas();
+
+    /**
+     * @return font id
+     * @throws std::runtime_error naming the file when it is missing or not a TrueType font
+     */
+    uint32_t addFont(const char *path);
+
+    /**
+     * Shapes a UTF-8 string, rasterizing missing glyphs. Runs are cached per (text, font, size).
+     */
+    const ShapedRun &shape(const std::string &text, uint32_t font, float size);
+
+    const Glyph &getGlyph(uint32_t glyph) const {
+        return glyphs[glyph];
+    }
+
+    const std::vector<uint8_t> &getPixels() const {
+        return pixels;
+    }
+
+    /**
+     * Rows changed since the last call, empty range if none.
+     */
+    std::pair<uint32_t, uint32_t> takeDirtyRows();
+
+private:
+    struct Font {
+        std::vector<unsigned char> data;
+        std::unique_ptr<stbtt_fontinfo> info;
+        float scale; // BASE_SIZE pixels per font unit
+        float ascent;
+        float descent;
+    };
+
+    struct RunKey {
+        std::string text;
+        uint32_t font;
+        float size;
+
+        bool operator==(const RunKey &other) const = default;
+    };
+
+    struct RunKeyHash {
+        size_t operator()(const RunKey &key) const {
+            return std::hash<std::string>()(key.text) ^ (std::hash<float>()(key.size) * 31 + key.font);
+        }
+    };
+
+    std::vector<Font> fonts;
+    std::vector<Glyph> glyphs;
+    std::unordered_map<uint64_t, uint32_t> glyphIndices; // font << 32 | codepoint
+    std::unordered_map<RunKey, ShapedRun, RunKeyHash> runs;
+
+    std::vector<uint8_t> pixels;
+    uint32_t shelfX = 0;
+    uint32_t shelfY = 0;
+    uint32_t shelfHeight = 0;
+    uint32_t dirtyBegin = 0;
+    uint32_t dirtyEnd = 0;
+    bool full = false; // logged once
+
+    uint32_t glyphFor(uint32_t font, uint32_t codepoint);
+};
+
+
+#endif //MAPENGINE_GLYPHATLAS_H
@@ -0,0 +1,529 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "HttpTileSource.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+using SocketHandle = SOCKET;
+static const SocketHandle NO_SOCKET = INVALID_SOCKET;
+#else
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+using SocketHandle = int;
+static const SocketHandle NO_SOCKET = -1;
+#endif
+
+// larger bodies are rejected, guards against broken length headers
+static const size_t MAX_BODY_SIZE = 64 << 20;
+static const size_t MAX_LINE_LENGTH = 64 << 10;
+// idle connections are dropped before common servers close their end, 5 s for Apache
+static const std::chrono::seconds IDLE_CONNECTION_TIMEOUT{4};
+// max-age of responses that do not give one, revalidated on every fetch
+static const std::chrono::seconds EXPIRED{0};
+
+// Failures another attempt may not run into: timeouts, dropped connections, overloaded servers
+struct RetryableError : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+static void closeSocket(SocketHandle handle) {
+#ifdef _WIN32
+    closesocket(handle);
+#else
+    close(handle);
+#endif
+}
+
+static void setBlocking(SocketHandle handle, bool blocking) {
+#ifdef _WIN32
+    u_long nonBlocking = blocking ? 0 : 1;
+    ioctlsocket(handle, FIONBIO, &nonBlocking);
+#else
+    const int flags = fcntl(handle, F_GETFL, 0);
+    fcntl(handle, F_SETFL, blocking ? flags & ~O_NONBLOCK : flags | O_NONBLOCK);
+#endif
+}
+
+// Waits for a non-blocking connect to finish
+static bool waitConnected(SocketHandle handle, std::chrono::milliseconds timeout) {
+#ifdef _WIN32
+    if (WSAGetLastError() != WSAEWOULDBLOCK) {
+        return false;
+    }
+    WSAPOLLFD poll{handle, POLLOUT, 0};
+    if (WSAPoll(&poll, 1, static_cast<INT>(timeout.count())) != 1) {
+        return false;
+    }
+    int length = sizeof(int);
+#else
+    if (errno != EINPROGRESS) {
+        return false;
+    }
+    pollfd poll{handle, POLLOUT, 0};
+    if (::poll(&poll, 1, static_cast<int>(timeout.count())) != 1) {
+        return false;
+    }
+    socklen_t length = sizeof(int);
+#endif
+    int error = 0;
+    getsockopt(handle, SOL_SOCKET, SO_ERROR, reinterpret_cast<char *>(&error), &length);
+    return error == 0;
+}
+
+class Socket {
+    SocketHandle handle = NO_SOCKET;
+
+public:
+    Socket(const std::string &host, const std::string &port, std::chrono::milliseconds timeout) {
+#ifdef _WIN32
+        static std::once_flag started;
+        std::call_once(started, []() {
+            WSADATA data;
+            WSAStartup(MAKEWORD(2, 2), &data);
+        });
+#endif
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo *addresses;
+        if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0) {
+            throw RetryableError("failed to resolve tile server!");
+        }
+        for (addrinfo *address = addresses; address && handle == NO_SOCKET; address = address->ai_next) {
+            SocketHandle candidate = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+            if (candidate == NO_SOCKET) {
+                continue;
+            }
+            setBlocking(candidate, false);
+            if (connect(candidate, address->ai_addr, static_cast<int>(address->ai_addrlen)) == 0 ||
+                waitConnected(candidate, timeout)) {
+                setBlocking(candidate, true);
+                handle = candidate;
+            } else {
+                closeSocket(candidate);
+            }
+        }
+        freeaddrinfo(addresses);
+        if (handle == NO_SOCKET) {
+            throw RetryableError("failed to connect to tile server!");
+        }
+
+#ifdef _WIN32
+        DWORD time = static_cast<DWORD>(timeout.count());
+#else
+        timeval time{static_cast<time_t>(timeout.count() / 1000),
+                     static_cast<suseconds_t>(timeout.count() % 1000 * 1000)};
+#endif
+        setsockopt(handle, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char *>(&time), sizeof(time));
+        setsockopt(handle, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char *>(&time), sizeof(time));
+        // pipelined requests are small and must not wait for the previous one's acknowledgement
+        int noDelay = 1;
+        setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&noDelay), sizeof(noDelay));
+    }
+
+    ~Socket() {
+        closeSocket(handle);
+    }
+
+    Socket(const Socket &) = delete;
+    Socket &operator=(const Socket &) = delete;
+
+    void send(const std::string &data) {
+#ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;
+#else
+        const int flags = 0;
+#endif
+        for (size_t sent = 0; sent < data.size();) {
+            const auto result = ::send(handle, data.data() + sent, static_cast<int>(data.size() - sent), flags);
+            if (result <= 0) {
+                throw RetryableError("failed to send tile request!");
+            }
+            sent += static_cast<size_t>(result);
+        }
+    }
+
+    /**
+     * @return bytes received, 0 when the server closed the connection
+     */
+    size_t receive(char *buffer, size_t size) {
+        const auto result = recv(handle, buffer, static_cast<int>(size), 0);
+        if (result < 0) {
+            throw RetryableError("failed to receive tile!");
+        }
+        return static_cast<size_t>(result);
+    }
+};
+
+struct HttpTileSource::Connection {
+    Socket socket;
+    std::string buffer; // received but not parsed yet, pipelined responses may arrive together
+
+    // requests are sent in ticket order and their responses read in the same order
+    std::mutex sendMutex;
+    uint64_t sent = 0;
+    std::mutex turnMutex;
+    std::condition_variable turn;
+    uint64_t received = 0;
+    bool broken = false;
+
+    // guarded by connectionMutex of the source
+    unsigned waiting = 0;
+    std::chrono::steady_clock::time_point lastUsed = std::chrono::steady_clock::now();
+
+    Connection(const std::string &host, const std::string &port, std::chrono::milliseconds timeout)
+            : socket(host, port, timeout) {
+    }
+
+    bool isBroken() {
+        std::lock_guard lock(turnMutex);
+        return broken;
+    }
+
+    void breakOff() {
+        {
+            std::lock_guard lock(turnMutex);
+            broken = true;
+        }
+        turn.notify_all();
+    }
+
+    bool fill() {
+        char chunk[16384];
+        const size_t size = socket.receive(chunk, sizeof(chunk));
+        buffer.append(chunk, size);
+        return size > 0;
+    }
+
+    std::string readLine() {
+        size_t end;
+        while ((end = buffer.find("\r\n")) == std::string::npos) {
+            if (buffer.size() > MAX_LINE_LENGTH) {
+                throw std::runtime_error("malformed tile response!");
+            }
+            if (!fill()) {
+                throw RetryableError("tile server closed the connection!");
+            }
+        }
+        std::string line = buffer.substr(0, end);
+        buffer.erase(0, end + 2);
+        return line;
+    }
+
+    void readBytes(size_t size, std::vector<uint8_t> &out) {
+        while (buffer.size() < size) {
+            if (!fill()) {
+                throw RetryableError("tile server closed the connection!");
+            }
+        }
+        out.insert(out.end(), buffer.begin(), buffer.begin() + static_cast<ptrdiff_t>(size));
+        buffer.erase(0, size);
+    }
+};
+
+static std::string lowercase(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return text;
+}
+
+static void replaceAll(std::string &text, const std::string &pattern, const std::string &value) {
+    for (size_t at = text.find(pattern); at != std::string::npos; at = text.find(pattern, at + value.size())) {
+        text.replace(at, pattern.size(), value);
+    }
+}
+
+HttpTileSource::HttpTileSource(const std::string &urlTemplate, uint32_t layerCount, HttpOptions options)
+        : layerCount(layerCount), options(options) {
+    const std::string scheme = "http://";
+    if (urlTemplate.compare(0, scheme.size(), scheme) != 0) {
+        throw std::runtime_error("tile URL must be plain http!");
+    }
+    const size_t pathStart = urlTemplate.find('/', scheme.size());
+    const std::string authority = urlTemplate.substr(scheme.size(), pathStart - scheme.size());
+    pathTemplate = pathStart == std::string::npos ? "/" : urlTemplate.substr(pathStart);
+    const size_t colon = authority.rfind(':');
+    host = authority.substr(0, colon);
+    port = colon == std::string::npos ? "80" : authority.substr(colon + 1);
+}
+
+HttpTileSource::~HttpTileSource() = default;
+
+std::shared_ptr<HttpTileSource::Connection> HttpTileSource::acquire() {
+    std::unique_lock lock(connectionMutex);
+    while (true) {
+        const auto now = std::chrono::steady_clock::now();
+        std::erase_if(connections, [&](const std::shared_ptr<Connection> &connection) {
+            return connection->waiting == 0 &&
+                   (connection->isBroken() || now - connection->lastUsed > IDLE_CONNECTION_TIMEOUT);
+        });
+
+        std::shared_ptr<Connection> leastBusy;
+        for (const auto &connection: connections) {
+            if (connection->waiting < options.pipelineDepth && !connection->isBroken() &&
+                (!leastBusy || connection->waiting < leastBusy->waiting)) {
+                leastBusy = connection;
+            }
+        }
+        // an idle connection first, then a new one, and pipelining only at the connection limit
+        if (leastBusy && leastBusy->waiting == 0) {
+            leastBusy->waiting++;
+            return leastBusy;
+        }
+        if (connections.size() + connecting < options.maxConnections) {
+            connecting++;
+            lock.unlock();
+            std::shared_ptr<Connection> connection;
+            try {
+                connection = std::make_shared<Connection>(host, port, options.timeout);
+            } catch (...) {
+                lock.lock();
+                connecting--;
+                connectionAvailable.notify_one();
+                throw;
+            }
+            lock.lock();
+            connecting--;
+            connection->waiting++;
+            connections.push_back(connection);
+            return connection;
+        }
+        if (leastBusy) {
+            leastBusy->waiting++;
+            return leastBusy;
+        }
+        connectionAvailable.wait(lock);
+    }
+}
+
+void HttpTileSource::release(const std::shared_ptr<Connection> &connection) {
+    {
+        std::lock_guard lock(connectionMutex);
+        connection->waiting--;
+        connection->lastUsed = std::chrono::steady_clock::now();
+    }
+    connectionAvailable.notify_one();
+}
+
+HttpTileSource::Response HttpTileSource::request(Connection &connection, const std::string &request) {
+    uint64_t ticket;
+    {
+        std::lock_guard lock(connection.sendMutex);
+        ticket = connection.sent++;
+        try {
+            connection.socket.send(request);
+        } catch (...) {
+            connection.breakOff();
+            throw;
+        }
+    }
+    {
+        std::unique_lock lock(connection.turnMutex);
+        connection.turn.wait(lock, [&]() { return connection.broken || connection.received == ticket; });
+        if (connection.broken) {
+            throw RetryableError("tile server connection broke!");
+        }
+    }
+
+    // only the request whose turn it is reads
+    Response response;
+    try {
+        const std::string statusLine = connection.readLine();
+        if (statusLine.compare(0, 7, "HTTP/1.") != 0 || statusLine.size() < 12) {
+            throw std::runtime_error("malformed tile response!");
+        }
+        response.status = std::stoi(statusLine.substr(9, 3));
+        // HTTP/1.0 closes unless asked to keep alive
+        response.close = statusLine[7] == '0';
+
+        std::optional<size_t> contentLength;
+        bool chunked = false;
+        for (std::string line = connection.readLine(); !line.empty(); line = connection.readLine()) {
+            const size_t colon = line.find(':');
+            if (colon == std::string::npos) {
+                continue;
+            }
+            const std::string name = lowercase(line.substr(0, colon));
+            const size_t valueStart = line.find_first_not_of(" \t", colon + 1);
+            const std::string value = valueStart == std::string::npos ? "" : line.substr(valueStart);
+            if (name == "content-length") {
+                contentLength = std::stoull(value);
+            } else if (name == "transfer-encoding") {
+                chunked = lowercase(value).find("chunked") != std::string::npos;
+            } else if (name == "connection") {
+                response.close = lowercase(value).find("close") != std::string::npos;
+            } else if (name == "etag") {
+                response.etag = value;
+            } else if (name == "last-modified") {
+                response.lastModified = value;
+            } else if (name == "cache-control") {
+                const std::string directives = lowercase(value);
+                response.noStore = directives.find("no-store") != std::string::npos;
+                if (response.noStore || directives.find("no-cache") != std::string::npos) {
+                    response.maxAge = EXPIRED;
+                } else if (size_t maxAge = directives.find("max-age="); maxAge != std::string::npos) {
+                    response.maxAge = std::chrono::seconds(std::stoll(directives.substr(maxAge + 8)));
+                }
+            }
+        }
+
+        if (response.status == 204 || response.status == 304) {
+            // no body
+        } else if (chunked) {
+            for (size_t size = std::stoull(connection.readLine(), nullptr, 16); size > 0;
+                 size = std::stoull(connection.readLine(), nullptr, 16)) {
+                if (response.body.size() + size > MAX_BODY_SIZE) {
+                    throw std::runtime_error("tile response is too large!");
+                }
+                connection.readBytes(size, response.body);
+                connection.readLine();
+            }
+            // trailers
+            while (!connection.readLine().empty());
+        } else if (contentLength) {
+            if (*contentLength > MAX_BODY_SIZE) {
+                throw std::runtime_error("tile response is too large!");
+            }
+            connection.readBytes(*contentLength, response.body);
+        } else {
+            // the body ends with the connection
+            while (connection.fill()) {
+                if (connection.buffer.size() > MAX_BODY_SIZE) {
+                    throw std::runtime_error("tile response is too large!");
+                }
+            }
+            response.body.assign(connection.buffer.begin(), connection.buffer.end());
+            connection.buffer.clear();
+            response.close = true;
+        }
+    } catch (std::logic_error &) {
+        connection.breakOff();
+        throw std::runtime_error("malformed tile response!");
+    } catch (...) {
+        connection.breakOff();
+        throw;
+    }
+
+    {
+        std::lock_guard lock(connection.turnMutex);
+        connection.received++;
+        // requests pipelined behind this one are answered by nobody
+        connection.broken = connection.broken || response.close;
+    }
+    connection.turn.notify_all();
+    return response;
+}
+
+void HttpTileSource::remember(const TileKey &key, const Response &response, std::vector<uint8_t> bytes) {
+    std::lock_guard lock(validatedMutex);
+    if (auto old = validated.find(key); old != validated.end()) {
+        validatedBytes -= old->second.bytes.size();
+        validatedUses.erase(old->second.use);
+        validated.erase(old);
+    }
+    if (response.noStore ||
+        (response.etag.empty() && response.lastModified.empty() && response.maxAge.value_or(EXPIRED) == EXPIRED)) {
+        return;
+    }
+    validatedBytes += bytes.size();
+    validatedUses.push_front(key);
+    validated.emplace(key, Validated{response.etag, response.lastModified, std::move(bytes),
+                                     std::chrono::steady_clock::now() + response.maxAge.value_or(EXPIRED),
+                                     validatedUses.begin()});
+    while (validatedBytes > options.revalidationBudget && !validatedUses.empty()) {
+        auto evicted = validated.find(validatedUses.back());
+        validatedBytes -= evicted->second.bytes.size();
+        validated.erase(evicted);
+        validatedUses.pop_back();
+    }
+}
+
+std::optional<std::vector<uint8_t>> HttpTileSource::fetch(const TileKey &key) {
+    std::string path = pathTemplate;
+    replaceAll(path, "{z}", std::to_string(key.layer));
+    replaceAll(path, "{x}", std::to_string(key.column));
+    replaceAll(path, "{y}", std::to_string(key.row));
+    const std::string head = "GET " + path + " HTTP/1.1\r\nHost: " + host + (port == "80" ? "" : ":" + port) +
+                                "\r\nUser-Agent: MapEngine\r\n";
+
+    std::string conditions;
+    {
+        std::lock_guard lock(validatedMutex);
+        if (auto known = validated.find(key); known != validated.end()) {
+            validatedUses.splice(validatedUses.begin(), validatedUses, known->second.use);
+            if (std::chrono::steady_clock::now() < known->second.expires) {
+                return known->second.bytes;
+            }
+            if (!known->second.etag.empty()) {
+                conditions += "If-None-Match: " + known->second.etag + "\r\n";
+            }
+            if (!known->second.lastModified.empty()) {
+                conditions += "If-Modified-Since: " + known->second.lastModified + "\r\n";
+            }
+        }
+    }
+
+    for (unsigned attempt = 0;; attempt++) {
+        try {
+            auto connection = acquire();
+            Response response;
+            try {
+                response = request(*connection, head + conditions + "\r\n");
+            } catch (...) {
+                release(connection);
+                throw;
+            }
+            release(connection);
+
+            if (response.status == 200) {
+                remember(key, response, response.body);
+                return std::move(response.body);
+            }
+            if (response.status == 304) {
+                std::lock_guard lock(validatedMutex);
+                if (auto known = validated.find(key); known != validated.end()) {
+                    known->second.expires = std::chrono::steady_clock::now() + response.maxAge.value_or(EXPIRED);
+                    return known->second.bytes;
+                }
+                // evicted meanwhile, ask for the body
+                conditions.clear();
+                attempt--;
+                continue;
+            }
+            if (response.status == 404 || response.status == 410 || response.status == 204) {
+                return std::nullopt;
+            }
+            if (response.status == 429 || response.status >= 500) {
+                throw RetryableError("tile server is busy!");
+            }
+            throw std::runtime_error("tile request failed with status " + std::to_string(response.status) + "!");
+        } catch (RetryableError &error) {
+            if (attempt >= options.retries) {
+                throw std::runtime_error(std::string("failed to fetch tile, ") + error.what());
+            }
+            // jitter keeps the loader threads from retrying in lockstep
+            thread_local std::mt19937 random(std::random_device{}());
+            const double jitter = std::uniform_real_distribution<double>(.5, 1)(random);
+            std::this_thread::sleep_for(options.backoff * (1u << std::min(attempt, 16u)) * jitter);
+        }
+    }
+}
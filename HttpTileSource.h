@@ -0,0 +1,109 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_HTTPTILESOURCE_H
+#define MAPENGINE_HTTPTILESOURCE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "TileSource.h"
+
+struct HttpOptions {
+    unsigned maxConnections = 4; // per host
+    unsigned pipelineDepth = 4; // requests waiting on one connection, 1 disables pipelining
+    std::chrono::milliseconds timeout{5000}; // connect, and each send or receive
+    unsigned retries = 3;
+    std::chrono::milliseconds backoff{200}; // before the first retry, doubled for each further one
+    size_t revalidationBudget = 64 << 20; // bytes of fetched tiles kept for conditional requests
+};
+
+/**
+ * Tiles from an HTTP/1.1 tile server. Connections are kept alive and shared by the loader threads. When every
+ * connection the host allows is open, requests are pipelined on the least busy one.
+ *
+ * Fetched tiles are kept with their ETag or Last-Modified, and fetching one again sends a conditional request
+ * that a 304 answers without the body. Tiles within their Cache-Control max-age are not requested at all, and
+ * no-store ones are not kept.
+ *
+ * Timeouts, dropped connections, 429 and 5xx responses are retried with exponential backoff. 404, 410 and 204
+ * mean the server has no such tile.
+ */
+class HttpTileSource : public TileSource {
+    struct Connection;
+
+    struct Response {
+        int status = 0;
+        std::vector<uint8_t> body;
+        std::string etag;
+        std::string lastModified;
+        std::optional<std::chrono::seconds> maxAge;
+        bool noStore = false;
+        bool close = false;
+    };
+
+    struct Validated {
+        std::string etag;
+        std::string lastModified;
+        std::vector<uint8_t> bytes;
+        std::chrono::steady_clock::time_point expires;
+        std::list<TileKey>::iterator use;
+    };
+
+    std::string host;
+    std::string port;
+    std::string pathTemplate;
+    uint32_t layerCount;
+    HttpOptions options;
+
+    std::mutex connectionMutex;
+    std::condition_variable connectionAvailable;
+    std::vector<std::shared_ptr<Connection>> connections;
+    unsigned connecting = 0;
+
+    std::mutex validatedMutex;
+    std::unordered_map<TileKey, Validated> validated;
+    std::list<TileKey> validatedUses; // most recently used first
+    size_t validatedBytes = 0;
+
+    std::shared_ptr<Connection> acquire();
+    void release(const std::shared_ptr<Connection> &connection);
+    Response request(Connection &connection, const std::string &request);
+    void remember(const TileKey &key, const Response &response, std::vector<uint8_t> bytes);
+
+public:
+    /**
+     * @param urlTemplate plain http URL where {z} is replaced by the layer, {x} by the column and {y} by the row,
+     * e.g. http://localhost:8080/tiles/{z}/{x}/{y}.png
+     * @param layerCount layers the server has tiles for
+     */
+    HttpTileSource(const std::string &urlTemplate, uint32_t layerCount, HttpOptions options = {});
+    ~HttpTileSource() override;
+
+    HttpTileSource(const HttpTileSource &) = delete;
+    HttpTileSource &operator=(const HttpTileSource &) = delete;
+
+    uint32_t getLayerCount() const override {
+        return layerCount;
+    }
+
+    /**
+     * @return enough fetches to fill the pipeline of every connection
+     */
+    unsigned getConcurrency() const override {
+        return options.maxConnections * options.pipelineDepth;
+    }
+
+    /**
+     * @throws std::runtime_error when the server cannot be reached or keeps failing after the retries
+     */
+    std::optional<std::vector<uint8_t>> fetch(const TileKey &key) override;
+};
+
+#endif //MAPENGINE_HTTPTILESOURCE_H
@@ -0,0 +1,196 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "Input.h"
+
+#include <cmath>
+#include <utility>
+
+// decay rate of the glide velocity, per second
+static const float FLING_FRICTION = 4;
+// slower drags and glides stop, pixels per second
+static const float MIN_FLING_SPEED = 20;
+// a drag held still for longer than this before release does not glide, seconds
+static const double FLING_RELEASE_TIME = .05;
+// time constant of the drag velocity average, seconds
+static const float VELOCITY_SMOOTHING = .03f;
+// time constant of the eased zoom, seconds
+static const float ZOOM_TIME = .08f;
+// scale factor of one scroll step
+static const float ZOOM_STEP = .9f;
+// degrees of pitch of one scroll step
+static const float TILT_STEP = 5;
+
+Input::Input(GLFWwindow *window, View *view, std::function<void(MapVec position, float radius)> onPick,
+             std::function<void(int key)> onKey)
+        : window(window), view(view), onPick(std::move(onPick)), onKey(std::move(onKey)) {
+    if (!window) {
+        return;
+    }
+    glfwSetWindowUserPointer(window, this);
+    glfwSetKeyCallback(window, [](GLFWwindow *window, int key, int scancode, int action, int mods) {
+        auto input = static_cast<Input *>(glfwGetWindowUserPointer(window));
+        input->receive({.type = InputEventType::Key, .action = static_cast<uint8_t>(action),
+                        .mods = static_cast<uint16_t>(mods), .code = key});
+    });
+
+    glfwSetCursorPosCallback(window, [](GLFWwindow *window, double xpos, double ypos) {
+        auto input = static_cast<Input *>(glfwGetWindowUserPointer(window));
+        input->receive({.type = InputEventType::CursorPos,
+                        .x = static_cast<float>(xpos), .y = static_cast<float>(ypos)});
+    });
+
+    glfwSetMouseButtonCallback(window, [](GLFWwindow *window, int button, int action, int mods) {
+        auto input = static_cast<Input *>(glfwGetWindowUserPointer(window));
+        double winX, winY;
+        glfwGetCursorPos(window, &winX, &winY);
+        input->receive({.type = InputEventType::MouseButton, .action = static_cast<uint8_t>(action),
+                        .mods = static_cast<uint16_t>(mods), .code = button,
+                        .x = static_cast<float>(winX), .y = static_cast<float>(winY)});
+    });
+
+    glfwSetScrollCallback(window, [](GLFWwindow *window, double xoffset, double yoffset) {
+        auto input = static_cast<Input *>(glfwGetWindowUserPointer(window));
+        double winX, winY;
+        glfwGetCursorPos(window, &winX, &winY);
+        const bool shift = glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS;
+        const bool control = glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS;
+        input->receive({.type = InputEventType::Scroll,
+                        .mods = static_cast<uint16_t>((shift ? GLFW_MOD_SHIFT : 0) | (control ? GLFW_MOD_CONTROL : 0)),
+                        .x = static_cast<float>(winX), .y = static_cast<float>(winY),
+                        .scroll = static_cast<float>(yoffset)});
+    });
+}
+
+Input::~Input() {
+    if (!window) {
+        return;
+    }
+    glfwSetKeyCallback(window, nullptr);
+    glfwSetCursorPosCallback(window, nullptr);
+    glfwSetMouseButtonCallback(window, nullptr);
+    glfwSetScrollCallback(window, nullptr);
+    glfwSetWindowUserPointer(window, nullptr);
+}
+
+void Input::receive(InputEvent event) {
+    event.time = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    handle(event);
+}
+
+void Input::handle(const InputEvent &event) {
+    if (recorder) {
+        recorder->write(event);
+    }
+    const double time = event.time / 1e6;
+    switch (event.type) {
+        case InputEventType::Key:
+            if (event.code == GLFW_KEY_ESCAPE && event.action == GLFW_PRESS) {
+                if (window) {
+                    glfwSetWindowShouldClose(window, GLFW_TRUE);
+                }
+            } else if (event.action == GLFW_PRESS && onKey) {
+                onKey(event.code);
+            }
+            break;
+        case InputEventType::CursorPos:
+            if (lastMousePos.has_value() && leftButtonDown) {
+                auto &mousePos = lastMousePos.value();
+                dragDelta += WindowVec(event.x - mousePos.winX, event.y - mousePos.winY);
+                lastDragTime = time;
+                stampEvent();
+            }
+            lastMousePos = {event.x, event.y};
+            break;
+        case InputEventType::MouseButton:
+            if (event.code == GLFW_MOUSE_BUTTON_LEFT && event.action == GLFW_PRESS) {
+                leftButtonDown = true;
+                flinging = false;
+                velocity = WindowVec(0);
+            } else if (event.code == GLFW_MOUSE_BUTTON_LEFT && event.action == GLFW_RELEASE) {
+                leftButtonDown = false;
+                flinging = time - lastDragTime < FLING_RELEASE_TIME && glm::length(velocity) > MIN_FLING_SPEED;
+            } else if (event.code == GLFW_MOUSE_BUTTON_RIGHT && event.action == GLFW_PRESS && onPick) {
+                onPick(view->windowToMap(event.x, event.y), view->windowToMapLength(PICK_RADIUS));
+            }
+            break;
+        case InputEventType::Scroll:
+            stampEvent();
+            if (event.mods & GLFW_MOD_SHIFT) {
+                pendingRotation += glm::radians(event.scroll * 4);
+                rotationAnchor = {event.x, event.y};
+            } else if (event.mods & GLFW_MOD_CONTROL) {
+                pendingPitch += glm::radians(event.scroll * TILT_STEP);
+            } else {
+                pendingZoom += event.scroll * std::log(ZOOM_STEP);
+                zoomAnchor = {event.x, event.y};
+            }
+            break;
+        case InputEventType::Frame:
+            advance(event.x);
+            break;
+    }
+}
+
+void Input::record(InputRecorder *inputRecorder) {
+    recorder = inputRecorder;
+}
+
+void Input::update(float dt) {
+    receive({.type = InputEventType::Frame, .x = dt});
+}
+
+void Input::advance(float dt) {
+    if (pendingRotation != 0 || pendingPitch != 0 || pendingZoom != 0 || dragDelta != WindowVec(0) || flinging) {
+        view->stopFlight();
+    }
+
+    if (pendingPitch != 0) {
+        view->tilt(pendingPitch);
+        pendingPitch = 0;
+    }
+
+    if (pendingRotation != 0) {
+        view->rotate(pendingRotation, static_cast<float>(rotationAnchor.winX), static_cast<float>(rotationAnchor.winY));
+        pendingRotation = 0;
+    }
+
+    if (pendingZoom != 0) {
+        // exponential ease, the last tiny remainder is applied at once
+        float step = pendingZoom * (1 - std::exp(-dt / ZOOM_TIME));
+        if (std::abs(pendingZoom - step) < 1e-3f) {
+            step = pendingZoom;
+        }
+        view->zoom(std::exp(step), static_cast<float>(zoomAnchor.winX), static_cast<float>(zoomAnchor.winY));
+        pendingZoom -= step;
+    }
+
+    if (dragDelta != WindowVec(0)) {
+        view->translate(dragDelta.x, dragDelta.y);
+        if (dt > 0) {
+            const float weight = 1 - std::exp(-dt / VELOCITY_SMOOTHING);
+            velocity += (dragDelta / dt - velocity) * weight;
+        }
+        dragDelta = WindowVec(0);
+    } else if (flinging) {
+        view->translate(velocity.x * dt, velocity.y * dt);
+        velocity *= std::exp(-FLING_FRICTION * dt);
+        flinging = glm::length(velocity) > MIN_FLING_SPEED;
+    }
+}
+
+bool Input::isAnimating() const {
+    return flinging || pendingZoom != 0;
+}
+
+void Input::stampEvent() {
+    if (!eventTime) {
+        eventTime = std::chrono::steady_clock::now();
+    }
+}
+
+std::optional<std::chrono::steady_clock::time_point> Input::takeEventTime() {
+    return std::exchange(eventTime, std::nullopt);
+}
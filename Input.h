@@ -7,58 +7,102 @@
 
 #include <GLFW/glfw3.h>
 #include <optional>
+#include <functional>
+#include <chrono>
 
 #include "View.h"
+#include "InputRecording.h"
+
+// cursor distance in pixels that still counts as a hit
+static const float PICK_RADIUS = 5;
+
+/**
+ * Collects GLFW input between frames and applies it to the view once per frame, however many events the mouse
+ * delivered. Releasing a drag keeps the map gliding with the drag's velocity, and scrolling zooms smoothly
+ * towards its target scale. Scrolling with shift held rotates the map, with control held it tilts the camera.
+ *
+ * Events, frames included, all go through handle(), so a recorded session fed back to it moves the view the
+ * same way again whatever the replay's frame rate.
+ */
+class Input {
+    // disable copying
+    Input(const Input&);
+    Input& operator=(const Input&);
 
-void handleInput(GLFWwindow *window, View* view) {
     struct MousePos {
         double winX;
         double winY;
     };
-    struct WindowContext {
-        View* view{};
-        std::optional<MousePos> lastMousePos;
-    };
 
-    auto* windowContext = new WindowContext;
-    windowContext->view = view;
-
-    glfwSetWindowUserPointer(window, windowContext);
-    glfwSetKeyCallback(window, [](GLFWwindow *window, int key, int scancode, int action, int mods) {
-        if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
-            glfwSetWindowShouldClose(window, GLFW_TRUE);
-    });
-
-    glfwSetCursorPosCallback(window, [](GLFWwindow *window, double xpos, double ypos) {
-        auto context = static_cast<WindowContext *>(glfwGetWindowUserPointer(window));
-        double winX, winY;
-        glfwGetCursorPos(window, &winX, &winY);
-        if (context->lastMousePos.has_value() && GLFW_PRESS == glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT)) {
-            auto &mousePos = context->lastMousePos.value();
-            context->view->translate(static_cast<float>(winX - mousePos.winX),
-                                     static_cast<float>(winY - mousePos.winY));
-        }
-        context->lastMousePos = {winX, winY};
-    });
-
-    glfwSetScrollCallback(window, [](GLFWwindow *window, double xoffset, double yoffset) {
-        auto context = static_cast<WindowContext *>(glfwGetWindowUserPointer(window));
-        float scaleFactor = 1 - static_cast<float>(yoffset) * .1f;
-
-        double winX, winY;
-        glfwGetCursorPos(window, &winX, &winY);
-        if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS) {
-            context->view->rotate(static_cast<float>(glm::radians(yoffset * 4)), static_cast<float>(winX), static_cast<float>(winY));
-        }
-        else {
-            context->view->zoom(scaleFactor, static_cast<float>(winX), static_cast<float>(winY));
-        }
-    });
-
-    glfwSetWindowCloseCallback(window, [](GLFWwindow* window){
-        auto context = static_cast<WindowContext *>(glfwGetWindowUserPointer(window));
-        delete context;
-    });
-}
+    GLFWwindow *window;
+    View *view;
+    InputRecorder *recorder = nullptr;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::function<void(MapVec position, float radius)> onPick;
+    std::function<void(int key)> onKey;
+
+    // accumulated since the last update
+    std::optional<MousePos> lastMousePos;
+    bool leftButtonDown = false;
+    WindowVec dragDelta{0};
+    float pendingRotation = 0;
+    MousePos rotationAnchor{};
+    float pendingPitch = 0;
+
+    // drag velocity in pixels per second, kept gliding after the drag is released
+    WindowVec velocity{0};
+    double lastDragTime = 0;
+    bool flinging = false;
+
+    // log of the scale factor still to be applied
+    float pendingZoom = 0;
+    MousePos zoomAnchor{};
+
+    // when the oldest input that moves the view arrived, GLFW has no timestamps of its own
+    std::optional<std::chrono::steady_clock::time_point> eventTime;
+
+    void stampEvent();
+    // stamps a live event with the time since start
+    void receive(InputEvent event);
+    void advance(float dt);
+
+public:
+    /**
+     * @param window nullptr takes events from handle() only, e.g. for a replay
+     * @param onPick called on right click with the cursor position and pick radius in map units
+     * @param onKey called with the GLFW key code of other key presses than escape
+     */
+    Input(GLFWwindow *window, View *view, std::function<void(MapVec position, float radius)> onPick = nullptr,
+          std::function<void(int key)> onKey = nullptr);
+    ~Input();
+
+    /**
+     * Applies the input collected since the last call and advances the animations. Input stops a flight of
+     * the view.
+     *
+     * @param dt seconds since the last frame
+     */
+    void update(float dt);
+
+    /**
+     * Applies one event, a frame event does what update() does.
+     */
+    void handle(const InputEvent &event);
+
+    /**
+     * Writes every event handled from now on, nullptr stops. The recorder must outlive the recording.
+     */
+    void record(InputRecorder *inputRecorder);
+
+    /**
+     * @return true while the view moves without input, frames should not wait for events
+     */
+    bool isAnimating() const;
+
+    /**
+     * @return arrival of the oldest input that moved the view since the last call, nullopt if there was none
+     */
+    std::optional<std::chrono::steady_clock::time_point> takeEventTime();
+};
 
 #endif //MAPENGINE_INPUT_H
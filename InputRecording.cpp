@@ -0,0 +1,95 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "InputRecording.h"
+
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+static const uint32_t RECORDING_VERSION = 2;
+// bytes as written, fields are packed whatever the struct layout
+static const size_t HEADER_SIZE = 16;
+static const size_t EVENT_SIZE = 28;
+
+static void putLittleEndian(uint8_t *bytes, uint64_t value, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        bytes[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+static uint64_t getLittleEndian(const uint8_t *bytes, size_t size) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < size; i++) {
+        value |= uint64_t{bytes[i]} << (8 * i);
+    }
+    return value;
+}
+
+static void encodeEvent(const InputEvent &event, uint8_t *bytes) {
+    putLittleEndian(bytes, event.time, 8);
+    bytes[8] = static_cast<uint8_t>(event.type);
+    bytes[9] = event.action;
+    putLittleEndian(bytes + 10, event.mods, 2);
+    putLittleEndian(bytes + 12, static_cast<uint32_t>(event.code), 4);
+    putLittleEndian(bytes + 16, std::bit_cast<uint32_t>(event.x), 4);
+    putLittleEndian(bytes + 20, std::bit_cast<uint32_t>(event.y), 4);
+    putLittleEndian(bytes + 24, std::bit_cast<uint32_t>(event.scroll), 4);
+}
+
+static InputEvent decodeEvent(const uint8_t *bytes) {
+    if (bytes[8] > static_cast<uint8_t>(InputEventType::Frame)) {
+        throw std::runtime_error("failed to read input recording!");
+    }
+    return {
+            .time = getLittleEndian(bytes, 8),
+            .type = static_cast<InputEventType>(bytes[8]),
+            .action = bytes[9],
+            .mods = static_cast<uint16_t>(getLittleEndian(bytes + 10, 2)),
+            .code = static_cast<int32_t>(static_cast<uint32_t>(getLittleEndian(bytes + 12, 4))),
+            .x = std::bit_cast<float>(static_cast<uint32_t>(getLittleEndian(bytes + 16, 4))),
+            .y = std::bit_cast<float>(static_cast<uint32_t>(getLittleEndian(bytes + 20, 4))),
+            .scroll = std::bit_cast<float>(static_cast<uint32_t>(getLittleEndian(bytes + 24, 4))),
+    };
+}
+
+InputRecorder::InputRecorder(const std::string &path, uint32_t windowWidth, uint32_t windowHeight)
+        : file(path, std::ios::binary | std::ios::trunc) {
+    uint8_t header[HEADER_SIZE];
+    std::memcpy(header, "MREC", 4);
+    putLittleEndian(header + 4, RECORDING_VERSION, 4);
+    putLittleEndian(header + 8, windowWidth, 4);
+    putLittleEndian(header + 12, windowHeight, 4);
+    file.write(reinterpret_cast<const char *>(header), HEADER_SIZE);
+    if (!file) {
+        throw std::runtime_error("failed to create input recording!");
+    }
+}
+
+void InputRecorder::write(InputEvent event) {
+    if (!started) {
+        startTime = event.time;
+        started = true;
+    }
+    event.time -= startTime;
+    uint8_t bytes[EVENT_SIZE];
+    encodeEvent(event, bytes);
+    file.write(reinterpret_cast<const char *>(bytes), EVENT_SIZE);
+}
+
+InputRecording readInputRecording(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    uint8_t header[HEADER_SIZE];
+    if (!file.read(reinterpret_cast<char *>(header), HEADER_SIZE) || std::memcmp(header, "MREC", 4) != 0 ||
+        getLittleEndian(header + 4, 4) != RECORDING_VERSION) {
+        throw std::runtime_error("failed to read input recording!");
+    }
+    InputRecording recording{static_cast<uint32_t>(getLittleEndian(header + 8, 4)),
+                             static_cast<uint32_t>(getLittleEndian(header + 12, 4))};
+    uint8_t bytes[EVENT_SIZE];
+    while (file.read(reinterpret_cast<char *>(bytes), EVENT_SIZE)) {
+        recording.events.push_back(decodeEvent(bytes));
+    }
+    return recording;
+}
@@ -0,0 +1,67 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_INPUTRECORDING_H
+#define MAPENGINE_INPUTRECORDING_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/*
+ * Recording layout, little endian and without padding:
+ *   header  "MREC", u32 version, u32 window width, u32 window height
+ *   events  until the end of the file, each u64 time, u8 type, u8 action, u16 mods, i32 code, f32 x, f32 y,
+ *           f32 scroll
+ */
+
+enum class InputEventType : uint8_t {
+    CursorPos,
+    MouseButton,
+    Scroll,
+    Key,
+    Frame, // Input::update() ran, the views were animated and a frame rendered
+};
+
+struct InputEvent {
+    uint64_t time; // microseconds since the first event
+    InputEventType type;
+    uint8_t action; // GLFW_PRESS or GLFW_RELEASE
+    uint16_t mods; // GLFW_MOD_* held
+    int32_t code; // GLFW key or mouse button
+    float x; // cursor position, frames keep their dt in seconds here
+    float y;
+    float scroll; // vertical scroll offset
+};
+
+/**
+ * Writes the events of a session as they happen.
+ */
+class InputRecorder {
+    std::ofstream file;
+    bool started = false;
+    uint64_t startTime = 0;
+
+public:
+    InputRecorder(const std::string &path, uint32_t windowWidth, uint32_t windowHeight);
+
+    /**
+     * @param event time in microseconds on any clock, rebased to the first event written
+     */
+    void write(InputEvent event);
+};
+
+struct InputRecording {
+    uint32_t windowWidth;
+    uint32_t windowHeight;
+    std::vector<InputEvent> events;
+};
+
+/**
+ * @throws std::runtime_error when the file is not a recording
+ */
+InputRecording readInputRecording(const std::string &path);
+
+#endif //MAPENGINE_INPUTRECORDING_H
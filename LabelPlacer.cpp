@@ -0,0 +1,148 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "LabelPlacer.h"
+
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+std::vector<MapBox> LabelPlacer::anchorBoxes(const std::vector<LabelCandidate> &candidates) {
+    std::vector<MapBox> boxes(candidates.size());
+    for (size_t i = 0; i < candidates.size(); i++) {
+        boxes[i] = {candidates[i].anchor, candidates[i].anchor};
+    }
+    return boxes;
+}
+
+LabelPlacer::LabelPlacer(ThreadPool &pool, std::vector<LabelCandidate> candidates, float cellSize, float margin)
+        : pool(&pool),
+          candidates(std::move(candidates)),
+          index(anchorBoxes(this->candidates), &pool),
+          cellSize(cellSize),
+          margin(margin) {
+    priorityOrder.resize(this->candidates.size());
+    std::iota(priorityOrder.begin(), priorityOrder.end(), 0);
+    std::stable_sort(priorityOrder.begin(), priorityOrder.end(), [&](uint32_t a, uint32_t b) {
+        return this->candidates[a].priority > this->candidates[b].priority;
+    });
+    rank.resize(priorityOrder.size());
+    for (uint32_t i = 0; i < priorityOrder.size(); i++) {
+        rank[priorityOrder[i]] = i;
+    }
+}
+
+LabelPlacer::~LabelPlacer() {
+    std::unique_lock lock(mutex);
+    pending.reset();
+    idle.wait(lock, [this]() { return !running; });
+}
+
+bool LabelPlacer::covers(const ViewSnapshot &placed, const ViewSnapshot &view) const {
+    if (!placed.sameScale(view)) {
+        return false;
+    }
+    WindowVec offset = placed.mapToWindow(view.center) - placed.windowSize * .5f;
+    return std::abs(offset.x) <= margin * placed.windowSize.x && std::abs(offset.y) <= margin * placed.windowSize.y;
+}
+
+void LabelPlacer::update(const ViewSnapshot &view) {
+    {
+        std::lock_guard lock(mutex);
+        if (requested.has_value() && covers(*requested, view)) {
+            return;
+        }
+        requested = view;
+        if (running) {
+            pending = view;
+            return;
+        }
+        running = true;
+    }
+    schedule(view);
+}
+
+void LabelPlacer::schedule(const ViewSnapshot &view) {
+    pool->submit([this, view]() {
+        ViewSnapshot next = view;
+        while (true) {
+            placement.store(place(next));
+
+            std::lock_guard lock(mutex);
+            if (!pending.has_value()) {
+                running = false;
+                idle.notify_all();
+                return;
+            }
+            next = *pending;
+            pending.reset();
+        }
+    });
+}
+
+std::shared_ptr<const LabelPlacement> LabelPlacer::place(const ViewSnapshot &view) const {
+    auto result = std::make_shared<LabelPlacement>();
+    result->view = view;
+
+    // candidates anchored inside the window and margin, in priority order
+    OrientedBox area = view.viewBox();
+    area.halfExtent *= 1 + 2 * margin;
+    std::vector<uint32_t> ids;
+    index.query(area, ids);
+    for (auto &id: ids) {
+        id = rank[id];
+    }
+    std::sort(ids.begin(), ids.end());
+
+    // screen space collision grid over the same area
+    const WindowVec origin = -view.windowSize * margin;
+    const WindowVec extent = view.windowSize * (1 + 2 * margin);
+    const int columns = std::max(1, static_cast<int>(std::ceil(extent.x / cellSize)));
+    const int rows = std::max(1, static_cast<int>(std::ceil(extent.y / cellSize)));
+    std::vector<std::vector<uint32_t>> cells(static_cast<size_t>(columns * rows));
+
+    struct Box {
+        WindowVec min;
+        WindowVec max;
+    };
+    std::vector<Box> placedBoxes;
+
+    for (uint32_t r: ids) {
+        const uint32_t id = priorityOrder[r];
+        const LabelCandidate &candidate = candidates[id];
+        const WindowVec position = view.mapToWindow(candidate.anchor) - origin;
+        const Box box{position - candidate.size * .5f, position + candidate.size * .5f};
+
+        const int x0 = std::clamp(static_cast<int>(box.min.x / cellSize), 0, columns - 1);
+        const int x1 = std::clamp(static_cast<int>(box.max.x / cellSize), 0, columns - 1);
+        const int y0 = std::clamp(static_cast<int>(box.min.y / cellSize), 0, rows - 1);
+        const int y1 = std::clamp(static_cast<int>(box.max.y / cellSize), 0, rows - 1);
+
+        bool collides = false;
+        for (int y = y0; y <= y1 && !collides; y++) {
+            for (int x = x0; x <= x1 && !collides; x++) {
+                for (uint32_t other: cells[y * columns + x]) {
+                    const Box &o = placedBoxes[other];
+                    if (box.min.x < o.max.x && box.max.x > o.min.x && box.min.y < o.max.y && box.max.y > o.min.y) {
+                        collides = true;
+                        break;
+                    }
+                }
+            }
+        }
+        if (collides) {
+            continue;
+        }
+
+        const auto boxIndex = static_cast<uint32_t>(placedBoxes.size());
+        placedBoxes.push_back(box);
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                cells[y * columns + x].push_back(boxIndex);
+            }
+        }
+        result->placed.push_back(id);
+    }
+    return result;
+}
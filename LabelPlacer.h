@@ -0,0 +1,92 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_LABELPLACER_H
+#define MAPENGINE_LABELPLACER_H
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <optional>
+
+#include "View.h"
+#include "RTree.h"
+#include "ThreadPool.h"
+
+struct LabelCandidate {
+    MapVec anchor;
+    WindowVec size; // pixels, centered on the anchor
+    float priority; // higher is placed first
+};
+
+struct LabelPlacement {
+    ViewSnapshot view; // view the placement was computed for
+    std::vector<uint32_t> placed; // candidate ids in priority order
+};
+
+/**
+ * Places labels without overlap in screen space.
+ *
+ * Placement runs on the thread pool against a snapshot of the view, so update() never blocks the frame.
+ * It covers the window plus a margin; while the camera only translates inside that margin the previous
+ * placement is reused as is.
+ */
+class LabelPlacer {
+public:
+    /**
+     * @param candidates label id is the index in this vector
+     * @param cellSize collision grid cell side in pixels
+     * @param margin extra area placed around the window, fraction of the window size
+     */
+    LabelPlacer(ThreadPool &pool, std::vector<LabelCandidate> candidates, float cellSize = 64, float margin = .25f);
+
+    // waits for a running placement
+    ~LabelPlacer();
+
+    /**
+     * Schedules a new placement unless the latest one still applies to view.
+     */
+    void update(const ViewSnapshot &view);
+
+    /**
+     * @return latest finished placement, may be for an older view. nullptr before the first one
+     */
+    std::shared_ptr<const LabelPlacement> getPlacement() const {
+        return placement.load();
+    }
+
+    const LabelCandidate &getCandidate(uint32_t id) const {
+        return candidates[id];
+    }
+
+private:
+    ThreadPool *pool;
+    std::vector<LabelCandidate> candidates;
+    std::vector<uint32_t> priorityOrder;
+    std::vector<uint32_t> rank; // position in priorityOrder
+    RTree index;
+    float cellSize;
+    float margin;
+
+    std::atomic<std::shared_ptr<const LabelPlacement>> placement;
+
+    std::mutex mutex;
+    std::condition_variable idle;
+    std::optional<ViewSnapshot> requested; // view of the latest scheduled placement
+    std::optional<ViewSnapshot> pending; // waiting for the running placement to finish
+    bool running = false;
+
+    static std::vector<MapBox> anchorBoxes(const std::vector<LabelCandidate> &candidates);
+
+    bool covers(const ViewSnapshot &placed, const ViewSnapshot &view) const;
+
+    void schedule(const ViewSnapshot &view);
+
+    std::shared_ptr<const LabelPlacement> place(const ViewSnapshot &view) const;
+};
+
+
+#endif //MAPENGINE_LABELPLACER_H
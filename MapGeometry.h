@@ -0,0 +1,143 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_MAPGEOMETRY_H
+#define MAPENGINE_MAPGEOMETRY_H
+
+#include <array>
+#include <cmath>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+typedef glm::vec2 MapVec;
+typedef glm::vec2 WindowVec;
+
+// Axis aligned box in map units
+struct MapBox {
+    MapVec min;
+    MapVec max;
+
+    bool contains(MapVec p) const {
+        return p.x >= min.x && p.x <= max.x && p.y >= min.y && p.y <= max.y;
+    }
+
+    bool intersects(const MapBox &other) const {
+        return min.x <= other.max.x && max.x >= other.min.x && min.y <= other.max.y && max.y >= other.min.y;
+    }
+
+    // squared distance from p to the closest point of the box
+    float distance2(MapVec p) const {
+        float dx = std::max(std::max(min.x - p.x, 0.f), p.x - max.x);
+        float dy = std::max(std::max(min.y - p.y, 0.f), p.y - max.y);
+        return dx * dx + dy * dy;
+    }
+
+    std::array<MapVec, 4> corners() const {
+        return {min, MapVec(max.x, min.y), max, MapVec(min.x, max.y)};
+    }
+};
+
+// Rotated rectangle in map units, e.g. the area covered by the window
+struct OrientedBox {
+    MapVec center;
+    MapVec axisX; // unit vector, window horizontal direction
+    MapVec axisY; // unit vector, window vertical direction
+    MapVec halfExtent;
+
+    bool contains(MapVec p) const {
+        MapVec d = p - center;
+        return std::abs(glm::dot(d, axisX)) <= halfExtent.x && std::abs(glm::dot(d, axisY)) <= halfExtent.y;
+    }
+
+    bool contains(const MapBox &box) const {
+        const auto boxCorners = box.corners();
+        return std::all_of(boxCorners.begin(), boxCorners.end(), [&](MapVec c) { return contains(c); });
+    }
+
+    // separating axis test
+    bool intersects(const MapBox &box) const {
+        MapBox bounds = boundingBox();
+        if (!bounds.intersects(box)) {
+            return false;
+        }
+        MapVec boxCenter = (box.min + box.max) * .5f;
+        MapVec boxHalf = (box.max - box.min) * .5f;
+        MapVec d = boxCenter - center;
+        const MapVec axes[2] = {axisX, axisY};
+        const float radii[2] = {halfExtent.x, halfExtent.y};
+        for (int i = 0; i < 2; i++) {
+            float boxRadius = boxHalf.x * std::abs(axes[i].x) + boxHalf.y * std::abs(axes[i].y);
+            if (std::abs(glm::dot(d, axes[i])) > boxRadius + radii[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool intersects(MapVec p, float radius) const {
+        MapVec d = p - center;
+        float dx = std::max(std::abs(glm::dot(d, axisX)) - halfExtent.x, 0.f);
+        float dy = std::max(std::abs(glm::dot(d, axisY)) - halfExtent.y, 0.f);
+        return dx * dx + dy * dy <= radius * radius;
+    }
+
+    OrientedBox expanded(float margin) const {
+        return {center, axisX, axisY, halfExtent + MapVec(margin, margin)};
+    }
+
+    std::array<MapVec, 4> corners() const {
+        MapVec x = axisX * halfExtent.x;
+        MapVec y = axisY * halfExtent.y;
+        return {center - x - y, center + x - y, center + x + y, center - x + y};
+    }
+
+    MapBox boundingBox() const {
+        MapVec extent(
+                halfExtent.x * std::abs(axisX.x) + halfExtent.y * std::abs(axisY.x),
+                halfExtent.x * std::abs(axisX.y) + halfExtent.y * std::abs(axisY.y)
+        );
+        return {center - extent, center + extent};
+    }
+};
+
+// Convex quadrilateral in map units, e.g. the area a pitched view shows
+struct MapQuad {
+    std::array<MapVec, 4> corners; // in order around the quad
+
+    MapBox boundingBox() const {
+        MapBox box{corners[0], corners[0]};
+        for (MapVec c: corners) {
+            box.min = glm::min(box.min, c);
+            box.max = glm::max(box.max, c);
+        }
+        return box;
+    }
+
+    // separating axis test, the box's axes and the quad's edge normals
+    bool intersects(const MapBox &box) const {
+        if (!boundingBox().intersects(box)) {
+            return false;
+        }
+        MapVec boxCenter = (box.min + box.max) * .5f;
+        MapVec boxHalf = (box.max - box.min) * .5f;
+        for (int i = 0; i < 4; i++) {
+            MapVec edge = corners[(i + 1) % 4] - corners[i];
+            MapVec normal(-edge.y, edge.x);
+            float boxRadius = boxHalf.x * std::abs(normal.x) + boxHalf.y * std::abs(normal.y);
+            float boxProjection = glm::dot(boxCenter, normal);
+            float quadMin = glm::dot(corners[0], normal);
+            float quadMax = quadMin;
+            for (MapVec c: corners) {
+                quadMin = std::min(quadMin, glm::dot(c, normal));
+                quadMax = std::max(quadMax, glm::dot(c, normal));
+            }
+            if (boxProjection + boxRadius < quadMin || boxProjection - boxRadius > quadMax) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+#endif //MAPENGINE_MAPGEOMETRY_H
@@ -0,0 +1,77 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "MappedFile.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string &path) {
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                       FILE_FLAG_RANDOM_ACCESS, nullptr);
+    LARGE_INTEGER fileSize;
+    if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize)) {
+        throw std::runtime_error("failed to open mapped file!");
+    }
+    size = static_cast<size_t>(fileSize.QuadPart);
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        throw std::runtime_error("failed to map file!");
+    }
+    data = static_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!data) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        throw std::runtime_error("failed to map file!");
+    }
+}
+
+MappedFile::~MappedFile() {
+    UnmapViewOfFile(data);
+    CloseHandle(mapping);
+    CloseHandle(file);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string &path) {
+    int descriptor = open(path.c_str(), O_RDONLY);
+    struct stat status{};
+    if (descriptor < 0) {
+        throw std::runtime_error("failed to open mapped file!");
+    }
+    if (fstat(descriptor, &status) != 0) {
+        close(descriptor);
+        throw std::runtime_error("failed to open mapped file!");
+    }
+    size = static_cast<size_t>(status.st_size);
+    void *address = mmap(nullptr, size, PROT_READ, MAP_SHARED, descriptor, 0);
+    // the mapping keeps the file open
+    close(descriptor);
+    if (address == MAP_FAILED) {
+        throw std::runtime_error("failed to map file!");
+    }
+    // tiles read scattered rows, read-ahead would mostly fetch pixels of other tiles
+    madvise(address, size, MADV_RANDOM);
+    data = static_cast<const uint8_t *>(address);
+}
+
+MappedFile::~MappedFile() {
+    munmap(const_cast<uint8_t *>(data), size);
+}
+
+#endif
@@ -0,0 +1,40 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_MAPPEDFILE_H
+#define MAPENGINE_MAPPEDFILE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+/**
+ * Read-only memory mapping of a whole file. Pages are read from disk when first touched, so files far larger
+ * than RAM can be mapped.
+ */
+class MappedFile {
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void *file = nullptr;
+    void *mapping = nullptr;
+#endif
+
+public:
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const uint8_t *getData() const {
+        return data;
+    }
+
+    size_t getSize() const {
+        return size;
+    }
+};
+
+#endif //MAPENGINE_MAPPEDFILE_H
@@ -0,0 +1,132 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "MappedImageSource.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "PpmHeader.h"
+
+MappedImageSource::MappedImageSource(const std::string &ppmPath, size_t cacheBudget)
+        : file(ppmPath), channels(3), cacheBudget(cacheBudget) {
+    std::ifstream in(ppmPath, std::ios::binary);
+    const PpmHeader header = readPpmHeader(in);
+    pixels = file.getData() + header.dataOffset;
+    width = header.width;
+    height = header.height;
+    init();
+}
+
+MappedImageSource::MappedImageSource(const std::string &rawPath, uint32_t width, uint32_t height,
+                                     uint32_t channels, size_t cacheBudget)
+        : file(rawPath), pixels(file.getData()), width(width), height(height), channels(channels),
+          cacheBudget(cacheBudget) {
+    if (channels != 3 && channels != 4) {
+        throw std::runtime_error("failed to map image, expected RGB or RGBA pixels!");
+    }
+    init();
+}
+
+void MappedImageSource::init() {
+    if (static_cast<size_t>(pixels - file.getData()) + size_t{width} * height * channels > file.getSize()) {
+        throw std::runtime_error("failed to map image, file is smaller than its pixels!");
+    }
+    baseLayer = pyramidBaseLayer(width, height);
+}
+
+std::optional<std::vector<uint8_t>> MappedImageSource::fetch(const TileKey &key) {
+    if (key.layer > baseLayer) {
+        return std::nullopt;
+    }
+    Tile tile = generate(key);
+    if (!tile) {
+        return std::nullopt;
+    }
+    return tile->pixels;
+}
+
+std::optional<TileImage> MappedImageSource::decode(const std::vector<uint8_t> &bytes) const {
+    if (bytes.size() != size_t{TILE_SIZE} * TILE_SIZE * 4) {
+        return std::nullopt;
+    }
+    return TileImage{TILE_SIZE, TILE_SIZE, bytes};
+}
+
+MappedImageSource::Tile MappedImageSource::generate(const TileKey &key) {
+    // tiles beyond the image
+    const uint64_t footprint = uint64_t{TILE_SIZE} << (baseLayer - key.layer);
+    if (key.row * footprint >= height || key.column * footprint >= width) {
+        return nullptr;
+    }
+    if (key.layer == baseLayer) {
+        return readBase(key.row, key.column);
+    }
+
+    {
+        std::lock_guard lock(mutex);
+        auto cached = cache.find(key);
+        if (cached != cache.end()) {
+            uses.splice(uses.begin(), uses, cached->second.use);
+            return cached->second.tile;
+        }
+    }
+
+    // concurrent fetches of the same tile may both generate it, the second result is dropped
+    Tile tile = reduce(key);
+
+    std::lock_guard lock(mutex);
+    if (!cache.contains(key)) {
+        uses.push_front(key);
+        cache.emplace(key, Cached{tile, uses.begin()});
+        cacheBytes += tile->pixels.size();
+        while (cacheBytes > cacheBudget && uses.size() > 1) {
+            auto evicted = cache.find(uses.back());
+            cacheBytes -= evicted->second.tile->pixels.size();
+            cache.erase(evicted);
+            uses.pop_back();
+        }
+    }
+    return tile;
+}
+
+MappedImageSource::Tile MappedImageSource::readBase(uint32_t row, uint32_t column) const {
+    const uint32_t x0 = column * TILE_SIZE;
+    const uint32_t y0 = row * TILE_SIZE;
+    const uint32_t tileWidth = std::min(TILE_SIZE, width - x0);
+    const uint32_t tileHeight = std::min(TILE_SIZE, height - y0);
+
+    // pixels beyond the image edge stay transparent
+    auto tile = std::make_shared<TileImage>(
+            TileImage{TILE_SIZE, TILE_SIZE, std::vector<uint8_t>(size_t{TILE_SIZE} * TILE_SIZE * 4)});
+    for (uint32_t y = 0; y < tileHeight; y++) {
+        const uint8_t *in = pixels + (size_t{y0 + y} * width + x0) * channels;
+        uint8_t *out = tile->pixels.data() + size_t{y} * TILE_SIZE * 4;
+        if (channels == 4) {
+            std::memcpy(out, in, size_t{tileWidth} * 4);
+            continue;
+        }
+        for (uint32_t x = 0; x < tileWidth; x++) {
+            out[x * 4] = in[x * 3];
+            out[x * 4 + 1] = in[x * 3 + 1];
+            out[x * 4 + 2] = in[x * 3 + 2];
+            out[x * 4 + 3] = 255;
+        }
+    }
+    return tile;
+}
+
+MappedImageSource::Tile MappedImageSource::reduce(const TileKey &key) {
+    auto tile = std::make_shared<TileImage>(
+            TileImage{TILE_SIZE, TILE_SIZE, std::vector<uint8_t>(size_t{TILE_SIZE} * TILE_SIZE * 4)});
+    for (uint32_t quadrant = 0; quadrant < 4; quadrant++) {
+        const uint32_t dx = quadrant % 2, dy = quadrant / 2;
+        if (Tile child = generate({key.layer + 1, key.row * 2 + dy, key.column * 2 + dx})) {
+            downsampleInto(*child, *tile, dx, dy);
+        }
+    }
+    return tile;
+}
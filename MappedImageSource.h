@@ -0,0 +1,82 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_MAPPEDIMAGESOURCE_H
+#define MAPENGINE_MAPPEDIMAGESOURCE_H
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "TileSource.h"
+#include "MappedFile.h"
+
+/**
+ * Tiles cut on demand from one memory-mapped uncompressed image, with no pyramid built beforehand. Only the
+ * pages a tile covers are read.
+ *
+ * The base layer holds the image unscaled. Every layer above it is box filtered from its children, like a mip
+ * chain, so the first fetch of a coarse tile reads all the pages under it once. Generated coarse tiles are kept in
+ * a byte-budgeted cache, which the next coarser layers are built from.
+ *
+ * Fetched tiles are raw RGBA8 pixels, which decode() takes as they are. They are not worth an encoded RAM cache.
+ */
+class MappedImageSource : public TileSource {
+    using Tile = std::shared_ptr<const TileImage>;
+
+    struct Cached {
+        Tile tile;
+        std::list<TileKey>::iterator use;
+    };
+
+    MappedFile file;
+    const uint8_t *pixels;
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;
+    uint32_t baseLayer;
+
+    std::mutex mutex;
+    std::unordered_map<TileKey, Cached> cache;
+    std::list<TileKey> uses; // most recently used first
+    size_t cacheBytes = 0;
+    size_t cacheBudget;
+
+    void init();
+    Tile generate(const TileKey &key);
+    Tile readBase(uint32_t row, uint32_t column) const;
+    Tile reduce(const TileKey &key);
+
+public:
+    /**
+     * Maps a binary PPM.
+     *
+     * @param cacheBudget bytes of generated coarse tiles to keep
+     */
+    explicit MappedImageSource(const std::string &ppmPath, size_t cacheBudget = 256 << 20);
+
+    /**
+     * Maps headerless interleaved 8 bit pixels, rows top to bottom.
+     *
+     * @param channels 3 for RGB, 4 for RGBA
+     * @param cacheBudget bytes of generated coarse tiles to keep
+     */
+    MappedImageSource(const std::string &rawPath, uint32_t width, uint32_t height, uint32_t channels,
+                      size_t cacheBudget = 256 << 20);
+
+    uint32_t getLayerCount() const override {
+        return baseLayer + 1;
+    }
+
+    bool isEncodedCacheable() const override {
+        return false;
+    }
+
+    std::optional<std::vector<uint8_t>> fetch(const TileKey &key) override;
+
+    std::optional<TileImage> decode(const std::vector<uint8_t> &bytes) const override;
+};
+
+#endif //MAPENGINE_MAPPEDIMAGESOURCE_H
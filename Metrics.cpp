@@ -0,0 +1,206 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "Metrics.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+Histogram::Histogram(std::vector<double> bounds)
+        : bounds(std::move(bounds)), buckets(new std::atomic<uint64_t>[this->bounds.size() + 1]) {
+    for (size_t i = 0; i <= this->bounds.size(); i++) {
+        buckets[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void Histogram::observe(double value) {
+    // a handful of bounds, a linear scan beats a binary search
+    size_t bucket = 0;
+    while (bucket < bounds.size() && value > bounds[bucket]) {
+        bucket++;
+    }
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+std::vector<uint64_t> Histogram::getBuckets() const {
+    std::vector<uint64_t> counts(bounds.size() + 1);
+    for (size_t i = 0; i < counts.size(); i++) {
+        counts[i] = buckets[i].load(std::memory_order_relaxed);
+    }
+    return counts;
+}
+
+MetricsRegistry::Metric &MetricsRegistry::add(const std::string &name, const std::string &help, Type type,
+                                              MetricLabels labels) {
+    auto family = std::find_if(families.begin(), families.end(), [&](const Family &f) {
+        return f.name == name;
+    });
+    if (family == families.end()) {
+        families.push_back({name, help, type});
+        family = families.end() - 1;
+    } else if (family->type != type) {
+        throw std::runtime_error("metric " + name + " registered with another type!");
+    }
+    for (const auto &metric: metrics) {
+        if (families[metric.family].name == name && metric.labels == labels) {
+            throw std::runtime_error("metric " + name + " registered twice!");
+        }
+    }
+    metrics.push_back({static_cast<size_t>(family - families.begin()), std::move(labels)});
+    return metrics.back();
+}
+
+Counter &MetricsRegistry::counter(const std::string &name, const std::string &help, MetricLabels labels) {
+    std::lock_guard lock(mutex);
+    Metric &metric = add(name, help, Type::Counter, std::move(labels));
+    metric.counter = std::make_unique<Counter>();
+    return *metric.counter;
+}
+
+Gauge &MetricsRegistry::gauge(const std::string &name, const std::string &help, MetricLabels labels) {
+    std::lock_guard lock(mutex);
+    Metric &metric = add(name, help, Type::Gauge, std::move(labels));
+    metric.gauge = std::make_unique<Gauge>();
+    return *metric.gauge;
+}
+
+Histogram &MetricsRegistry::histogram(const std::string &name, const std::string &help, std::vector<double> bounds,
+                                      MetricLabels labels) {
+    std::lock_guard lock(mutex);
+    Metric &metric = add(name, help, Type::Histogram, std::move(labels));
+    metric.histogram = std::make_unique<Histogram>(std::move(bounds));
+    return *metric.histogram;
+}
+
+void MetricsRegistry::counterCallback(const std::string &name, const std::string &help, std::function<double()> read,
+                                      MetricLabels labels) {
+    std::lock_guard lock(mutex);
+    add(name, help, Type::Counter, std::move(labels)).read = std::move(read);
+}
+
+void MetricsRegistry::gaugeCallback(const std::string &name, const std::string &help, std::function<double()> read,
+                                    MetricLabels labels) {
+    std::lock_guard lock(mutex);
+    add(name, help, Type::Gauge, std::move(labels)).read = std::move(read);
+}
+
+static std::string formatValue(double value) {
+    if (value == std::numeric_limits<double>::infinity()) {
+        return "+Inf";
+    }
+    std::ostringstream ss;
+    ss.precision(15);
+    ss << value;
+    return ss.str();
+}
+
+void MetricsRegistry::collectFamily(size_t family, std::vector<MetricSample> &samples) const {
+    const std::string &name = families[family].name;
+    for (const auto &metric: metrics) {
+        if (metric.family != family) {
+            continue;
+        }
+        if (metric.counter) {
+            samples.push_back({name, metric.labels, static_cast<double>(metric.counter->get())});
+        } else if (metric.gauge) {
+            samples.push_back({name, metric.labels, metric.gauge->get()});
+        } else if (metric.histogram) {
+            const auto &bounds = metric.histogram->getBounds();
+            const auto buckets = metric.histogram->getBuckets();
+            uint64_t cumulative = 0;
+            for (size_t i = 0; i < buckets.size(); i++) {
+                cumulative += buckets[i];
+                MetricLabels labels = metric.labels;
+                labels.emplace_back("le", formatValue(i < bounds.size() ? bounds[i] :
+                                                      std::numeric_limits<double>::infinity()));
+                samples.push_back({name + "_bucket", std::move(labels), static_cast<double>(cumulative)});
+            }
+            samples.push_back({name + "_sum", metric.labels, metric.histogram->getSum()});
+            samples.push_back({name + "_count", metric.labels, static_cast<double>(cumulative)});
+        } else {
+            samples.push_back({name, metric.labels, metric.read()});
+        }
+    }
+}
+
+std::vector<MetricSample> MetricsRegistry::collect() const {
+    std::lock_guard lock(mutex);
+    std::vector<MetricSample> samples;
+    for (size_t f = 0; f < families.size(); f++) {
+        collectFamily(f, samples);
+    }
+    return samples;
+}
+
+std::optional<double> MetricsRegistry::value(const std::string &name, const MetricLabels &labels) const {
+    for (const auto &sample: collect()) {
+        if (sample.name == name && sample.labels == labels) {
+            return sample.value;
+        }
+    }
+    return std::nullopt;
+}
+
+static void writeLabels(std::ostream &out, const MetricLabels &labels) {
+    if (labels.empty()) {
+        return;
+    }
+    out << '{';
+    for (size_t i = 0; i < labels.size(); i++) {
+        out << (i ? "," : "") << labels[i].first << "=\"";
+        for (char c: labels[i].second) {
+            if (c == '\\' || c == '"') {
+                out << '\\' << c;
+            } else if (c == '\n') {
+                out << "\\n";
+            } else {
+                out << c;
+            }
+        }
+        out << '"';
+    }
+    out << '}';
+}
+
+std::string MetricsRegistry::exportText() const {
+    std::lock_guard lock(mutex);
+    std::ostringstream out;
+    std::vector<MetricSample> samples;
+    for (size_t f = 0; f < families.size(); f++) {
+        const Family &family = families[f];
+        out << "# HELP " << family.name << ' ' << family.help << '\n';
+        out << "# TYPE " << family.name << ' '
+            << (family.type == Type::Counter ? "counter" : family.type == Type::Gauge ? "gauge" : "histogram")
+            << '\n';
+        samples.clear();
+        collectFamily(f, samples);
+        for (const auto &sample: samples) {
+            out << sample.name;
+            writeLabels(out, sample.labels);
+            out << ' ' << formatValue(sample.value) << '\n';
+        }
+    }
+    return out.str();
+}
+
+void MetricsRegistry::writeFile(const std::string &path) const {
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file << exportText();
+        if (!file) {
+            throw std::runtime_error("failed to write metrics!");
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        throw std::runtime_error("failed to replace metrics file!");
+    }
+}
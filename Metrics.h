@@ -0,0 +1,159 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_METRICS_H
+#define MAPENGINE_METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// label name and value pairs, e.g. {{"tier", "gpu"}}
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+class Counter {
+    std::atomic<uint64_t> value{0};
+
+public:
+    void add(uint64_t n = 1) {
+        value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t get() const {
+        return value.load(std::memory_order_relaxed);
+    }
+};
+
+class Gauge {
+    std::atomic<double> value{0};
+
+public:
+    void set(double v) {
+        value.store(v, std::memory_order_relaxed);
+    }
+
+    double get() const {
+        return value.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * Counts observations into buckets with fixed upper bounds, cumulated only when exported.
+ */
+class Histogram {
+    std::vector<double> bounds;
+    std::unique_ptr<std::atomic<uint64_t>[]> buckets; // one more than bounds, the last one is +Inf
+    std::atomic<double> sum{0};
+
+public:
+    /**
+     * @param bounds upper bounds of the buckets, ascending
+     */
+    explicit Histogram(std::vector<double> bounds);
+
+    void observe(double value);
+
+    const std::vector<double> &getBounds() const {
+        return bounds;
+    }
+
+    /**
+     * @return observations in each bucket alone, not cumulated, the last one above every bound
+     */
+    std::vector<uint64_t> getBuckets() const;
+
+    double getSum() const {
+        return sum.load(std::memory_order_relaxed);
+    }
+};
+
+// one exported value, histograms export several
+struct MetricSample {
+    std::string name;
+    MetricLabels labels;
+    double value;
+};
+
+/**
+ * Named counters, gauges and histograms of the running process. Registering takes a lock and is meant for
+ * start up, the returned metrics stay valid as long as the registry and are updated with relaxed atomics
+ * only. Values other components already keep can be registered as callbacks that run when exported.
+ */
+class MetricsRegistry {
+    enum class Type {
+        Counter,
+        Gauge,
+        Histogram,
+    };
+
+    struct Family {
+        std::string name;
+        std::string help;
+        Type type;
+    };
+
+    struct Metric {
+        size_t family;
+        MetricLabels labels;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+        std::function<double()> read;
+    };
+
+    mutable std::mutex mutex;
+    std::vector<Family> families;
+    std::deque<Metric> metrics;
+
+    Metric &add(const std::string &name, const std::string &help, Type type, MetricLabels labels);
+    void collectFamily(size_t family, std::vector<MetricSample> &samples) const;
+
+public:
+    Counter &counter(const std::string &name, const std::string &help, MetricLabels labels = {});
+
+    Gauge &gauge(const std::string &name, const std::string &help, MetricLabels labels = {});
+
+    Histogram &histogram(const std::string &name, const std::string &help, std::vector<double> bounds,
+                         MetricLabels labels = {});
+
+    /**
+     * @param read called from the thread that exports, must be safe to call there and not use the registry
+     */
+    void counterCallback(const std::string &name, const std::string &help, std::function<double()> read,
+                         MetricLabels labels = {});
+
+    void gaugeCallback(const std::string &name, const std::string &help, std::function<double()> read,
+                       MetricLabels labels = {});
+
+    /**
+     * @return current values, histograms as cumulative name_bucket with an le label, name_sum and name_count
+     */
+    std::vector<MetricSample> collect() const;
+
+    /**
+     * @return value of one sample as collect() names it, nullopt if there is none
+     */
+    std::optional<double> value(const std::string &name, const MetricLabels &labels = {}) const;
+
+    /**
+     * @return every metric in the Prometheus text exposition format
+     */
+    std::string exportText() const;
+
+    /**
+     * Replaces the file with exportText() at once, so a scraper never reads half of it.
+     *
+     * @throws std::runtime_error when the file cannot be written
+     */
+    void writeFile(const std::string &path) const;
+};
+
+#endif //MAPENGINE_METRICS_H
@@ -0,0 +1,170 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "PolylinePyramid.h"
+#include "View.h"
+
+#include <algorithm>
+#include <limits>
+#include <functional>
+
+static float segmentDistance(MapVec p, MapVec a, MapVec b) {
+    const MapVec ab = b - a;
+    const float length2 = glm::dot(ab, ab);
+    const float t = length2 > 0 ? std::clamp(glm::dot(p - a, ab) / length2, 0.f, 1.f) : 0.f;
+    return glm::length(p - (a + t * ab));
+}
+
+void PolylinePyramid::keepTolerances(const std::vector<MapVec> &points, uint32_t begin, uint32_t end,
+                                     std::vector<float> &out) {
+    if (begin == end) {
+        return;
+    }
+    out[begin] = out[end - 1] = std::numeric_limits<float>::infinity();
+
+    struct Span {
+        uint32_t first;
+        uint32_t last;
+        float parentTolerance;
+    };
+    std::vector<Span> stack = {{begin, end - 1, std::numeric_limits<float>::infinity()}};
+    while (!stack.empty()) {
+        const Span span = stack.back();
+        stack.pop_back();
+        if (span.last - span.first < 2) {
+            continue;
+        }
+        uint32_t farthest = span.first + 1;
+        float maxDistance = -1;
+        for (uint32_t i = span.first + 1; i < span.last; i++) {
+            float distance = segmentDistance(points[i], points[span.first], points[span.last]);
+            if (distance > maxDistance) {
+                maxDistance = distance;
+                farthest = i;
+            }
+        }
+        // a vertex cannot outlive the split that made it a span end
+        const float tolerance = std::min(maxDistance, span.parentTolerance);
+        out[farthest] = tolerance;
+        stack.push_back({span.first, farthest, tolerance});
+        stack.push_back({farthest, span.last, tolerance});
+    }
+}
+
+PolylinePyramid::PolylinePyramid(const std::vector<MapVec> &points, const std::vector<uint32_t> &offsets,
+                                 ThreadPool &pool, float tolerance) {
+    const size_t trackCount = offsets.empty() ? 0 : offsets.size() - 1;
+
+    std::vector<float> tolerances(points.size());
+    pool.parallelFor(trackCount, [&](size_t track) {
+        keepTolerances(points, offsets[track], offsets[track + 1], tolerances);
+    });
+
+    // map units per pixel at the level's tile scale
+    std::array<float, LEVEL_COUNT> levelTolerances{};
+    for (int level = 0; level < LEVEL_COUNT; level++) {
+        levelTolerances[level] = tolerance * 2 / static_cast<float>(View::TILE_PIXELS << level);
+    }
+
+    // segments per level and track
+    std::vector<std::array<uint32_t, LEVEL_COUNT>> trackSegments(trackCount);
+    pool.parallelFor(trackCount, [&](size_t track) {
+        std::array<uint32_t, LEVEL_COUNT> kept{};
+        for (uint32_t i = offsets[track]; i < offsets[track + 1]; i++) {
+            // levels are nested, the vertex is kept from the first level whose tolerance it exceeds
+            auto first = std::upper_bound(levelTolerances.begin(), levelTolerances.end(), tolerances[i],
+                                          std::greater<>()) - levelTolerances.begin();
+            for (auto level = first; level < LEVEL_COUNT; level++) {
+                kept[level]++;
+            }
+        }
+        for (int level = 0; level < LEVEL_COUNT; level++) {
+            trackSegments[track][level] = kept[level] > 0 ? kept[level] - 1 : 0;
+        }
+    });
+    std::array<uint32_t, LEVEL_COUNT> totals{};
+    for (const auto &track: trackSegments) {
+        for (int level = 0; level < LEVEL_COUNT; level++) {
+            totals[level] += track[level];
+        }
+    }
+
+    // A finer level is also a valid, if slower, simplification of a coarser one. Levels that would save less
+    // than a quarter of the segments reuse the finer level, which bounds the pyramid to 4 times the input.
+    std::array<int, LEVEL_COUNT> storedLevel{};
+    storedLevel[LEVEL_COUNT - 1] = LEVEL_COUNT - 1;
+    for (int level = LEVEL_COUNT - 2; level >= 0; level--) {
+        const int finer = storedLevel[level + 1];
+        storedLevel[level] = totals[level] * 4 > totals[finer] * 3 ? finer : level;
+    }
+
+    for (int level = 0; level < LEVEL_COUNT; level++) {
+        if (storedLevel[level] != level) {
+            continue;
+        }
+        const float levelTolerance = levelTolerances[level];
+        const uint32_t total = totals[level];
+
+        Level &current = levels[level];
+        current.segments = {static_cast<uint32_t>(segments.size()), total};
+        std::vector<uint32_t> trackFirst(trackCount);
+        uint32_t first = current.segments.first;
+        for (size_t track = 0; track < trackCount; track++) {
+            trackFirst[track] = first;
+            first += trackSegments[track][level];
+        }
+        segments.resize(segments.size() + total);
+        pool.parallelFor(trackCount, [&](size_t track) {
+            uint32_t out = trackFirst[track];
+            uint32_t previous = offsets[track];
+            for (uint32_t i = offsets[track] + 1; i < offsets[track + 1]; i++) {
+                if (tolerances[i] > levelTolerance) {
+                    segments[out++] = {previous, i, static_cast<uint32_t>(track)};
+                    previous = i;
+                }
+            }
+        });
+
+        current.firstChunk = static_cast<uint32_t>(chunkBoxes.size());
+        current.chunkCount = (total + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        chunkBoxes.resize(chunkBoxes.size() + current.chunkCount);
+        pool.parallelFor(current.chunkCount, [&](size_t chunk) {
+            const uint32_t begin = current.segments.first + static_cast<uint32_t>(chunk) * CHUNK_SIZE;
+            const uint32_t end = std::min(begin + CHUNK_SIZE, current.segments.first + total);
+            MapBox box{MapVec(std::numeric_limits<float>::max()), MapVec(std::numeric_limits<float>::lowest())};
+            for (uint32_t i = begin; i < end; i++) {
+                for (uint32_t point: {segments[i].first, segments[i].second}) {
+                    box.min = glm::min(box.min, points[point]);
+                    box.max = glm::max(box.max, points[point]);
+                }
+            }
+            chunkBoxes[current.firstChunk + chunk] = box;
+        });
+    }
+    for (int level = 0; level < LEVEL_COUNT; level++) {
+        levels[level] = levels[storedLevel[level]];
+    }
+}
+
+PolylinePyramid::Range PolylinePyramid::getLevel(int level) const {
+    return levels[std::clamp(level, 0, LEVEL_COUNT - 1)].segments;
+}
+
+void PolylinePyramid::query(int level, const OrientedBox &box, std::vector<Range> &out) const {
+    const Level &current = levels[std::clamp(level, 0, LEVEL_COUNT - 1)];
+    const uint32_t end = current.segments.first + current.segments.count;
+    const size_t firstRange = out.size();
+    for (uint32_t chunk = 0; chunk < current.chunkCount; chunk++) {
+        if (!box.intersects(chunkBoxes[current.firstChunk + chunk])) {
+            continue;
+        }
+        const uint32_t begin = current.segments.first + chunk * CHUNK_SIZE;
+        const uint32_t count = std::min(CHUNK_SIZE, end - begin);
+        if (out.size() > firstRange && out.back().first + out.back().count == begin) {
+            out.back().count += count;
+        } else {
+            out.push_back({begin, count});
+        }
+    }
+}
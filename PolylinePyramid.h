@@ -0,0 +1,79 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_POLYLINEPYRAMID_H
+#define MAPENGINE_POLYLINEPYRAMID_H
+
+#include <vector>
+#include <array>
+#include <cstdint>
+
+#include "MapGeometry.h"
+#include "ThreadPool.h"
+
+/**
+ * Douglas-Peucker simplification of polylines for every tile zoom level.
+ *
+ * Each vertex gets the largest tolerance at which Douglas-Peucker still keeps it, computed in one pass
+ * per track on the thread pool. A level keeps the vertices whose tolerance exceeds half a pixel at that
+ * level's scale, so the levels are nested and built by filtering without simplifying again.
+ *
+ * Segments of all levels are concatenated, level by level, and grouped into chunks of CHUNK_SIZE
+ * segments with a bounding box for culling.
+ */
+class PolylinePyramid {
+public:
+    static const int LEVEL_COUNT = 21;
+    static const uint32_t CHUNK_SIZE = 1024;
+
+    struct Segment {
+        uint32_t first; // point index
+        uint32_t second; // point index
+        uint32_t track;
+    };
+
+    struct Range {
+        uint32_t first; // segment index
+        uint32_t count;
+    };
+
+    /**
+     * @param points vertices of all tracks, map units
+     * @param offsets first point of every track followed by points.size()
+     * @param tolerance allowed error in pixels at a level's scale
+     */
+    PolylinePyramid(const std::vector<MapVec> &points, const std::vector<uint32_t> &offsets, ThreadPool &pool,
+                    float tolerance = .5f);
+
+    const std::vector<Segment> &getSegments() const {
+        return segments;
+    }
+
+    /**
+     * @return segment range of a level, levels outside [0, LEVEL_COUNT) are clamped
+     */
+    Range getLevel(int level) const;
+
+    /**
+     * Appends the segment ranges of level whose chunks intersect box, adjacent chunks merged.
+     */
+    void query(int level, const OrientedBox &box, std::vector<Range> &out) const;
+
+private:
+    struct Level {
+        Range segments;
+        uint32_t firstChunk;
+        uint32_t chunkCount;
+    };
+
+    std::vector<Segment> segments;
+    std::vector<MapBox> chunkBoxes;
+    std::array<Level, LEVEL_COUNT> levels{};
+
+    static void keepTolerances(const std::vector<MapVec> &points, uint32_t begin, uint32_t end,
+                               std::vector<float> &out);
+};
+
+
+#endif //MAPENGINE_POLYLINEPYRAMID_H
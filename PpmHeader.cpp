@@ -0,0 +1,41 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "PpmHeader.h"
+
+#include <cctype>
+#include <stdexcept>
+#include <string>
+
+static std::string token(std::istream &in) {
+    std::string value;
+    char c;
+    while (in.get(c)) {
+        if (c == '#') {
+            while (in.get(c) && c != '\n');
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            if (!value.empty()) {
+                return value;
+            }
+        } else {
+            value += c;
+        }
+    }
+    return value;
+}
+
+PpmHeader readPpmHeader(std::istream &in) {
+    if (token(in) != "P6") {
+        throw std::runtime_error("failed to read image, expected binary PPM!");
+    }
+    PpmHeader header{};
+    header.width = std::stoul(token(in));
+    header.height = std::stoul(token(in));
+    if (std::stoul(token(in)) != 255) {
+        throw std::runtime_error("failed to read image, expected 8 bit samples!");
+    }
+    // token() consumed the single whitespace after the maximum value
+    header.dataOffset = in.tellg();
+    return header;
+}
@@ -0,0 +1,23 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_PPMHEADER_H
+#define MAPENGINE_PPMHEADER_H
+
+#include <cstdint>
+#include <istream>
+
+// Binary PPM (P6) with 8 bit samples, the RGB pixels follow the header row by row
+struct PpmHeader {
+    uint32_t width;
+    uint32_t height;
+    std::streamoff dataOffset;
+};
+
+/**
+ * Reads the header from the start of the stream.
+ */
+PpmHeader readPpmHeader(std::istream &in);
+
+#endif //MAPENGINE_PPMHEADER_H
@@ -0,0 +1,179 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+// Builds a tile archive from one large image:
+//   PyramidBuilder <input.ppm> <output.mtar> [threads]
+// The input is read in strips one tile row tall, so memory use does not depend on the image size.
+
+#define STB_IMAGE_IMPLEMENTATION
+
+#include <stb_image.h>
+
+#include <iostream>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <exception>
+
+#include "TileArchive.h"
+#include "PpmHeader.h"
+#include "ThreadPool.h"
+
+// tiles read from the input at once, bounds the strip buffer to TILE_SIZE rows of this many tiles
+static const uint32_t STRIP_WINDOW_TILES = 64;
+
+// Reads the input row by row
+class PpmReader {
+    std::ifstream file;
+    std::streamoff dataOffset;
+
+public:
+    uint32_t width;
+    uint32_t height;
+
+    explicit PpmReader(const std::string &path) : file(path, std::ios::binary) {
+        if (!file) {
+            throw std::runtime_error("failed to open input image!");
+        }
+        PpmHeader header = readPpmHeader(file);
+        width = header.width;
+        height = header.height;
+        dataOffset = header.dataOffset;
+    }
+
+    /**
+     * @param out receives count RGB pixels starting at column x of row y
+     */
+    void readRow(uint32_t y, uint32_t x, uint32_t count, uint8_t *out) {
+        file.seekg(dataOffset + (static_cast<std::streamoff>(y) * width + x) * 3);
+        file.read(reinterpret_cast<char *>(out), static_cast<std::streamsize>(count) * 3);
+        if (!file) {
+            throw std::runtime_error("failed to read input image!");
+        }
+    }
+};
+
+// parallelFor for work that may throw, the first exception is rethrown once every call has returned
+static void parallelForThrowing(ThreadPool &pool, size_t count, const std::function<void(size_t)> &fn) {
+    std::mutex mutex;
+    std::exception_ptr error;
+    pool.parallelFor(count, [&](size_t i) {
+        try {
+            fn(i);
+        } catch (...) {
+            std::lock_guard lock(mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+static uint32_t divideRoundingUp(uint32_t a, uint32_t b) {
+    return (a + b - 1) / b;
+}
+
+// Cuts the base layer from the input, strip by strip
+static void buildBaseLayer(PpmReader &input, TileArchiveWriter &archive, ThreadPool &pool, uint32_t layer) {
+    const uint32_t columns = divideRoundingUp(input.width, TILE_SIZE);
+    const uint32_t rows = divideRoundingUp(input.height, TILE_SIZE);
+    std::vector<uint8_t> strip(size_t{TILE_SIZE} * STRIP_WINDOW_TILES * TILE_SIZE * 3);
+
+    for (uint32_t row = 0; row < rows; row++) {
+        const uint32_t y0 = row * TILE_SIZE;
+        const uint32_t stripHeight = std::min(TILE_SIZE, input.height - y0);
+        for (uint32_t firstColumn = 0; firstColumn < columns; firstColumn += STRIP_WINDOW_TILES) {
+            const uint32_t windowColumns = std::min(STRIP_WINDOW_TILES, columns - firstColumn);
+            const uint32_t x0 = firstColumn * TILE_SIZE;
+            const uint32_t stripWidth = std::min(windowColumns * TILE_SIZE, input.width - x0);
+            for (uint32_t y = 0; y < stripHeight; y++) {
+                input.readRow(y0 + y, x0, stripWidth, strip.data() + size_t{y} * stripWidth * 3);
+            }
+
+            parallelForThrowing(pool, windowColumns, [&](size_t i) {
+                const uint32_t tileX0 = static_cast<uint32_t>(i) * TILE_SIZE;
+                const uint32_t tileWidth = std::min(TILE_SIZE, stripWidth - tileX0);
+                // pixels beyond the image edge stay transparent
+                TileImage tile{TILE_SIZE, TILE_SIZE, std::vector<uint8_t>(size_t{TILE_SIZE} * TILE_SIZE * 4)};
+                for (uint32_t y = 0; y < stripHeight; y++) {
+                    const uint8_t *in = strip.data() + (size_t{y} * stripWidth + tileX0) * 3;
+                    uint8_t *out = tile.pixels.data() + size_t{y} * TILE_SIZE * 4;
+                    for (uint32_t x = 0; x < tileWidth; x++) {
+                        out[x * 4] = in[x * 3];
+                        out[x * 4 + 1] = in[x * 3 + 1];
+                        out[x * 4 + 2] = in[x * 3 + 2];
+                        out[x * 4 + 3] = 255;
+                    }
+                }
+                archive.add({layer, row, firstColumn + static_cast<uint32_t>(i)}, encodeTile(tile));
+            });
+        }
+        std::cout << "\rLayer " << layer << ": row " << row + 1 << " of " << rows << std::flush;
+    }
+    std::cout << std::endl;
+}
+
+// Builds a layer from the four children of each tile in the layer below
+static void buildCoarserLayer(TileArchiveWriter &archive, ThreadPool &pool, uint32_t layer, uint32_t rows,
+                              uint32_t columns) {
+    parallelForThrowing(pool, size_t{rows} * columns, [&](size_t i) {
+        const uint32_t row = static_cast<uint32_t>(i / columns);
+        const uint32_t column = static_cast<uint32_t>(i % columns);
+        TileImage tile{TILE_SIZE, TILE_SIZE, std::vector<uint8_t>(size_t{TILE_SIZE} * TILE_SIZE * 4)};
+        for (uint32_t quadrant = 0; quadrant < 4; quadrant++) {
+            const uint32_t dx = quadrant % 2, dy = quadrant / 2;
+            auto bytes = archive.read({layer + 1, row * 2 + dy, column * 2 + dx});
+            if (!bytes) {
+                // beyond the image edge
+                continue;
+            }
+            auto child = decodeTile(bytes->data(), bytes->size());
+            if (!child || child->width != TILE_SIZE || child->height != TILE_SIZE) {
+                throw std::runtime_error("failed to decode tile!");
+            }
+            downsampleInto(*child, tile, dx, dy);
+        }
+        archive.add({layer, row, column}, encodeTile(tile));
+    });
+    std::cout << "Layer " << layer << ": " << size_t{rows} * columns << " tiles" << std::endl;
+}
+
+void build_throws(const std::string &inputPath, const std::string &outputPath, unsigned threadCount) {
+    PpmReader input(inputPath);
+    uint32_t columns = divideRoundingUp(input.width, TILE_SIZE);
+    uint32_t rows = divideRoundingUp(input.height, TILE_SIZE);
+
+    const uint32_t baseLayer = pyramidBaseLayer(input.width, input.height);
+    std::cout << input.width << "x" << input.height << " pixels, " << baseLayer + 1 << " layers" << std::endl;
+
+    ThreadPool pool(threadCount);
+    TileArchiveWriter archive(outputPath, baseLayer + 1);
+    buildBaseLayer(input, archive, pool, baseLayer);
+    for (uint32_t layer = baseLayer; layer-- > 0;) {
+        columns = divideRoundingUp(columns, 2);
+        rows = divideRoundingUp(rows, 2);
+        buildCoarserLayer(archive, pool, layer, rows, columns);
+    }
+    archive.finish();
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::cout << "usage: PyramidBuilder <input.ppm> <output.mtar> [threads]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    try {
+        const unsigned threads = argc > 3 ? std::stoul(argv[3]) : std::thread::hardware_concurrency();
+        // the calling thread works in parallelFor too
+        build_throws(argv[1], argv[2], std::max(1U, threads) - 1);
+    } catch (std::exception &exception) {
+        std::cout << exception.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
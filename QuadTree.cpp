@@ -0,0 +1,137 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "QuadTree.h"
+
+#include <algorithm>
+#include <numeric>
+#include <deque>
+#include <cstddef>
+#include <utility>
+
+static uint32_t quantize(float v) {
+    auto q = static_cast<int64_t>((v + 1) / 2 * 65536);
+    return static_cast<uint32_t>(std::clamp<int64_t>(q, 0, 65535));
+}
+
+// spreads the lower 16 bits of v to the even bits
+static uint32_t part1By1(uint32_t v) {
+    v &= 0x0000ffff;
+    v = (v | (v << 8)) & 0x00ff00ff;
+    v = (v | (v << 4)) & 0x0f0f0f0f;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+static uint32_t mortonCode(float x, float y) {
+    return part1By1(quantize(x)) | (part1By1(quantize(y)) << 1);
+}
+
+std::vector<uint32_t> QuadTree::mortonOrder(const std::vector<float> &x, const std::vector<float> &y) {
+    std::vector<uint64_t> keys(x.size());
+    for (size_t i = 0; i < x.size(); i++) {
+        keys[i] = (static_cast<uint64_t>(mortonCode(x[i], y[i])) << 32) | i;
+    }
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<uint32_t> order(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        order[i] = static_cast<uint32_t>(keys[i]);
+    }
+    return order;
+}
+
+QuadTree::QuadTree(std::vector<float> x, std::vector<float> y) : x(std::move(x)), y(std::move(y)) {
+    codes.resize(this->x.size());
+    for (size_t i = 0; i < codes.size(); i++) {
+        codes[i] = mortonCode(this->x[i], this->y[i]);
+    }
+
+    nodes.push_back({{MapVec(-1, -1), MapVec(1, 1)}, 0, static_cast<uint32_t>(codes.size()), 0});
+    build(0, 0);
+
+    // only needed while building
+    codes = std::vector<uint32_t>();
+}
+
+void QuadTree::build(uint32_t node, uint32_t depth) {
+    const uint32_t begin = nodes[node].begin;
+    const uint32_t end = nodes[node].end;
+    if (end - begin <= LEAF_SIZE || depth == MAX_DEPTH) {
+        return;
+    }
+
+    const uint32_t shift = 2 * (MAX_DEPTH - 1 - depth);
+    const uint64_t prefix = codes[begin] & ~((uint64_t{4} << shift) - 1);
+    const MapBox box = nodes[node].box;
+    const MapVec mid = (box.min + box.max) * .5f;
+
+    const auto firstChild = static_cast<uint32_t>(nodes.size());
+    nodes[node].firstChild = firstChild;
+    uint32_t childBegin = begin;
+    for (uint32_t q = 0; q < 4; q++) {
+        uint32_t childEnd = end;
+        if (q < 3) {
+            auto bound = static_cast<uint32_t>(prefix | (uint64_t{q + 1} << shift));
+            childEnd = static_cast<uint32_t>(
+                    std::lower_bound(codes.begin() + childBegin, codes.begin() + end, bound) - codes.begin());
+        }
+        MapBox childBox{
+                MapVec(q & 1 ? mid.x : box.min.x, q & 2 ? mid.y : box.min.y),
+                MapVec(q & 1 ? box.max.x : mid.x, q & 2 ? box.max.y : mid.y),
+        };
+        nodes.push_back({childBox, childBegin, childEnd, 0});
+        childBegin = childEnd;
+    }
+
+    for (uint32_t q = 0; q < 4; q++) {
+        build(firstChild + q, depth + 1);
+    }
+}
+
+void QuadTree::split(const OrientedBox &box, size_t taskCount, std::vector<uint32_t> &out) const {
+    out.clear();
+    std::deque<uint32_t> queue{0};
+    while (!queue.empty() && queue.size() + out.size() < taskCount) {
+        uint32_t index = queue.front();
+        queue.pop_front();
+        const Node &node = nodes[index];
+        if (node.begin == node.end || !box.intersects(node.box)) {
+            continue;
+        }
+        if (node.firstChild == 0 || box.contains(node.box)) {
+            out.push_back(index);
+            continue;
+        }
+        for (uint32_t q = 0; q < 4; q++) {
+            queue.push_back(node.firstChild + q);
+        }
+    }
+    out.insert(out.end(), queue.begin(), queue.end());
+}
+
+void QuadTree::query(uint32_t index, const OrientedBox &box, std::vector<uint32_t> &out) const {
+    const Node &node = nodes[index];
+    if (node.begin == node.end || !box.intersects(node.box)) {
+        return;
+    }
+    if (box.contains(node.box)) {
+        size_t size = out.size();
+        out.resize(size + node.end - node.begin);
+        std::iota(out.begin() + static_cast<std::ptrdiff_t>(size), out.end(), node.begin);
+        return;
+    }
+    if (node.firstChild == 0) {
+        for (uint32_t i = node.begin; i < node.end; i++) {
+            if (box.contains(MapVec(x[i], y[i]))) {
+                out.push_back(i);
+            }
+        }
+        return;
+    }
+    for (uint32_t q = 0; q < 4; q++) {
+        query(node.firstChild + q, box, out);
+    }
+}
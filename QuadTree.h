@@ -0,0 +1,77 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_QUADTREE_H
+#define MAPENGINE_QUADTREE_H
+
+#include <vector>
+#include <cstdint>
+
+#include "MapGeometry.h"
+
+/**
+ * Point quadtree over map coordinates [-1, 1].
+ *
+ * Points are expected in Morton (Z-curve) order, see mortonOrder(), so every node covers a
+ * contiguous index range and a node that is fully visible is emitted without touching its points.
+ * The tree keeps the coordinates itself, so it does not depend on where they came from.
+ */
+class QuadTree {
+public:
+    static const uint32_t LEAF_SIZE = 256;
+    static const uint32_t MAX_DEPTH = 16;
+
+    struct Node {
+        MapBox box;
+        uint32_t begin;
+        uint32_t end;
+        uint32_t firstChild; // 4 consecutive children, 0 for a leaf
+    };
+
+    /**
+     * @param x point x coordinates
+     * @param y point y coordinates
+     * @return permutation that sorts the points into Morton order
+     */
+    static std::vector<uint32_t> mortonOrder(const std::vector<float> &x, const std::vector<float> &y);
+
+    /**
+     * @param x point x coordinates, already in Morton order
+     * @param y point y coordinates, already in Morton order
+     */
+    QuadTree(std::vector<float> x, std::vector<float> y);
+
+    /**
+     * Splits the part of the tree intersecting box into at least taskCount independent nodes when possible.
+     */
+    void split(const OrientedBox &box, size_t taskCount, std::vector<uint32_t> &nodes) const;
+
+    /**
+     * Appends the indices of the points under node that are inside box.
+     */
+    void query(uint32_t node, const OrientedBox &box, std::vector<uint32_t> &out) const;
+
+    const std::vector<Node> &getNodes() const {
+        return nodes;
+    }
+
+    const std::vector<float> &getX() const {
+        return x;
+    }
+
+    const std::vector<float> &getY() const {
+        return y;
+    }
+
+private:
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<uint32_t> codes;
+    std::vector<Node> nodes;
+
+    void build(uint32_t node, uint32_t depth);
+};
+
+
+#endif //MAPENGINE_QUADTREE_H
@@ -0,0 +1,170 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "RTree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static float centerX(const MapBox &box) {
+    return box.min.x + box.max.x;
+}
+
+static float centerY(const MapBox &box) {
+    return box.min.y + box.max.y;
+}
+
+RTree::RTree(const std::vector<MapBox> &featureBoxes, ThreadPool *pool) : featureCount(featureBoxes.size()) {
+    if (featureBoxes.empty()) {
+        return;
+    }
+
+    std::vector<Entry> level(featureBoxes.size());
+    for (size_t i = 0; i < featureBoxes.size(); i++) {
+        level[i] = {featureBoxes[i], static_cast<uint32_t>(i)};
+    }
+
+    // Only the features are sorted. Upper levels keep the order of the level below, which keeps the
+    // features under any node contiguous.
+    sortTileRecursive(level, pool);
+    while (true) {
+        const auto base = static_cast<uint32_t>(boxes.size());
+        for (const auto &entry: level) {
+            boxes.push_back(entry.box);
+            indices.push_back(entry.index);
+        }
+        levelEnds.push_back(static_cast<uint32_t>(boxes.size()));
+        if (levelEnds.size() > 1 && level.size() == 1) {
+            break;
+        }
+
+        std::vector<Entry> parents;
+        parents.reserve((level.size() + NODE_SIZE - 1) / NODE_SIZE);
+        for (size_t i = 0; i < level.size(); i += NODE_SIZE) {
+            MapBox box = level[i].box;
+            for (size_t j = i + 1; j < std::min(i + NODE_SIZE, level.size()); j++) {
+                box.min = glm::min(box.min, level[j].box.min);
+                box.max = glm::max(box.max, level[j].box.max);
+            }
+            parents.push_back({box, base + static_cast<uint32_t>(i)});
+        }
+        level = std::move(parents);
+    }
+}
+
+void RTree::sortTileRecursive(std::vector<Entry> &entries, ThreadPool *pool) {
+    const size_t nodeCount = (entries.size() + NODE_SIZE - 1) / NODE_SIZE;
+    const auto sliceCount = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(nodeCount))));
+    const size_t sliceSize = sliceCount * NODE_SIZE;
+    const size_t nonEmptySlices = (entries.size() + sliceSize - 1) / sliceSize;
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return centerX(a.box) < centerX(b.box);
+    });
+
+    auto sortSlice = [&](size_t slice) {
+        auto begin = entries.begin() + static_cast<std::ptrdiff_t>(slice * sliceSize);
+        auto end = entries.begin() + static_cast<std::ptrdiff_t>(std::min((slice + 1) * sliceSize, entries.size()));
+        std::sort(begin, end, [](const Entry &a, const Entry &b) {
+            return centerY(a.box) < centerY(b.box);
+        });
+    };
+    if (pool) {
+        pool->parallelFor(nonEmptySlices, sortSlice);
+    } else {
+        for (size_t slice = 0; slice < nonEmptySlices; slice++) {
+            sortSlice(slice);
+        }
+    }
+}
+
+uint32_t RTree::childrenEnd(uint32_t position, uint32_t level) const {
+    return std::min(indices[position] + NODE_SIZE, levelEnds[level - 1]);
+}
+
+std::pair<uint32_t, uint32_t> RTree::leafRange(uint32_t position, uint32_t level) const {
+    uint32_t first = position;
+    uint32_t last = position;
+    for (uint32_t l = level; l > 0; l--) {
+        first = indices[first];
+        last = childrenEnd(last, l) - 1;
+    }
+    return {first, last + 1};
+}
+
+template<typename Intersects, typename Contains, typename Emit>
+void RTree::search(const Intersects &intersects, const Contains &contains, const Emit &emit) const {
+    if (levelEnds.empty()) {
+        return;
+    }
+    const auto root = static_cast<uint32_t>(boxes.size() - 1);
+    if (!intersects(boxes[root])) {
+        return;
+    }
+
+    struct Item {
+        uint32_t position;
+        uint32_t level;
+    };
+    std::vector<Item> stack;
+    stack.reserve(64);
+    stack.push_back({root, static_cast<uint32_t>(levelEnds.size() - 1)});
+    while (!stack.empty()) {
+        const Item item = stack.back();
+        stack.pop_back();
+
+        if (item.level == 0) {
+            emit(item.position);
+            continue;
+        }
+        if (contains(boxes[item.position])) {
+            auto [first, end] = leafRange(item.position, item.level);
+            for (uint32_t position = first; position < end; position++) {
+                emit(position);
+            }
+            continue;
+        }
+        for (uint32_t child = indices[item.position]; child < childrenEnd(item.position, item.level); child++) {
+            if (intersects(boxes[child])) {
+                stack.push_back({child, item.level - 1});
+            }
+        }
+    }
+}
+
+void RTree::query(const OrientedBox &box, std::vector<uint32_t> &out) const {
+    search([&](const MapBox &node) { return box.intersects(node); },
+           [&](const MapBox &node) { return box.contains(node); },
+           [&](uint32_t position) { out.push_back(indices[position]); });
+}
+
+void RTree::query(const MapBox &box, std::vector<uint32_t> &out) const {
+    search([&](const MapBox &node) { return box.intersects(node); },
+           [&](const MapBox &node) { return box.contains(node.min) && box.contains(node.max); },
+           [&](uint32_t position) { out.push_back(indices[position]); });
+}
+
+void RTree::query(MapVec point, float radius, std::vector<uint32_t> &out) const {
+    const float radius2 = radius * radius;
+    search([&](const MapBox &node) { return node.distance2(point) <= radius2; },
+           [](const MapBox &) { return false; },
+           [&](uint32_t position) { out.push_back(indices[position]); });
+}
+
+std::optional<uint32_t> RTree::pick(MapVec point, float radius) const {
+    const float radius2 = radius * radius;
+    std::optional<uint32_t> result;
+    float closest = std::numeric_limits<float>::infinity();
+    search([&](const MapBox &node) { return node.distance2(point) <= std::min(radius2, closest); },
+           [](const MapBox &) { return false; },
+           [&](uint32_t position) {
+               float distance2 = boxes[position].distance2(point);
+               if (distance2 < closest) {
+                   closest = distance2;
+                   result = indices[position];
+               }
+           });
+    return result;
+}
@@ -0,0 +1,83 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_RTREE_H
+#define MAPENGINE_RTREE_H
+
+#include <vector>
+#include <optional>
+#include <cstdint>
+
+#include "MapGeometry.h"
+#include "ThreadPool.h"
+
+/**
+ * Static R-tree over feature bounding boxes in map units. Features are ordered with Sort-Tile-Recursive
+ * and packed into full nodes.
+ *
+ * Nodes are stored level by level in flat arrays. Children of a node are consecutive on the level below,
+ * so the features under a node are a contiguous range and fully covered nodes are emitted without testing.
+ * The tree is immutable after construction and every query is const, so any number of threads may query it
+ * at the same time.
+ */
+class RTree {
+public:
+    static const uint32_t NODE_SIZE = 16;
+
+    /**
+     * @param boxes feature bounding boxes, feature id is the index in this vector
+     * @param pool optional, sorts the packing slices in parallel
+     */
+    explicit RTree(const std::vector<MapBox> &boxes, ThreadPool *pool = nullptr);
+
+    /**
+     * Appends ids of the features whose boxes intersect the rotated box, e.g. View::getViewBox().
+     */
+    void query(const OrientedBox &box, std::vector<uint32_t> &out) const;
+
+    /**
+     * Appends ids of the features whose boxes intersect box.
+     */
+    void query(const MapBox &box, std::vector<uint32_t> &out) const;
+
+    /**
+     * Appends ids of the features whose boxes are at most radius away from point.
+     */
+    void query(MapVec point, float radius, std::vector<uint32_t> &out) const;
+
+    /**
+     * @return the feature closest to point, if any is within radius
+     */
+    std::optional<uint32_t> pick(MapVec point, float radius) const;
+
+    size_t size() const {
+        return featureCount;
+    }
+
+private:
+    struct Entry {
+        MapBox box;
+        uint32_t index;
+    };
+
+    size_t featureCount;
+    std::vector<MapBox> boxes;
+    // feature id for level 0, position of the first child for the other levels
+    std::vector<uint32_t> indices;
+    // end position of every level, the root is the last position
+    std::vector<uint32_t> levelEnds;
+
+    static void sortTileRecursive(std::vector<Entry> &entries, ThreadPool *pool);
+
+    template<typename Intersects, typename Contains, typename Emit>
+    void search(const Intersects &intersects, const Contains &contains, const Emit &emit) const;
+
+    // contiguous range of level 0 positions under the node
+    std::pair<uint32_t, uint32_t> leafRange(uint32_t position, uint32_t level) const;
+
+    uint32_t childrenEnd(uint32_t position, uint32_t level) const;
+};
+
+
+#endif //MAPENGINE_RTREE_H
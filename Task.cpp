@@ -0,0 +1,57 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "Task.h"
+
+#include <array>
+#include <new>
+#include <vector>
+
+// frames are rounded up to multiples of this
+static const size_t FRAME_SIZE_STEP = 64;
+// larger frames come from the heap every time
+static const size_t MAX_POOLED_FRAME_SIZE = 2048;
+// free frames kept per size class and thread, frames freed on other threads than they came from pile up there
+static const size_t MAX_FREE_FRAMES = 256;
+
+struct FreeFrames {
+    std::array<std::vector<void *>, MAX_POOLED_FRAME_SIZE / FRAME_SIZE_STEP> sizeClasses;
+
+    ~FreeFrames() {
+        for (auto &frames: sizeClasses) {
+            for (void *frame: frames) {
+                ::operator delete(frame);
+            }
+        }
+    }
+};
+
+static thread_local FreeFrames freeFrames;
+
+void *allocateCoroutineFrame(size_t size) {
+    if (size > MAX_POOLED_FRAME_SIZE) {
+        return ::operator new(size);
+    }
+    const size_t sizeClass = (size - 1) / FRAME_SIZE_STEP;
+    auto &frames = freeFrames.sizeClasses[sizeClass];
+    if (frames.empty()) {
+        return ::operator new((sizeClass + 1) * FRAME_SIZE_STEP);
+    }
+    void *frame = frames.back();
+    frames.pop_back();
+    return frame;
+}
+
+void freeCoroutineFrame(void *frame, size_t size) {
+    if (size > MAX_POOLED_FRAME_SIZE) {
+        ::operator delete(frame);
+        return;
+    }
+    auto &frames = freeFrames.sizeClasses[(size - 1) / FRAME_SIZE_STEP];
+    if (frames.size() < MAX_FREE_FRAMES) {
+        frames.push_back(frame);
+    } else {
+        ::operator delete(frame);
+    }
+}
@@ -0,0 +1,223 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_TASK_H
+#define MAPENGINE_TASK_H
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <utility>
+
+/**
+ * Coroutine frames come from per-thread free lists of a few size classes, so that starting a task per tile does
+ * not reach the heap once the lists are warm.
+ */
+void *allocateCoroutineFrame(size_t size);
+
+void freeCoroutineFrame(void *frame, size_t size);
+
+class TaskCancelled : public std::exception {
+public:
+    const char *what() const noexcept override {
+        return "task cancelled";
+    }
+};
+
+class CancellationToken {
+    const std::atomic<bool> *flag = nullptr;
+
+public:
+    // never cancelled
+    CancellationToken() = default;
+
+    explicit CancellationToken(const std::atomic<bool> &flag) : flag(&flag) {
+    }
+
+    bool isCancelled() const {
+        return flag && flag->load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @throws TaskCancelled
+     */
+    void throwIfCancelled() const {
+        if (isCancelled()) {
+            throw TaskCancelled();
+        }
+    }
+};
+
+/**
+ * Cancels the tokens it hands out. Must outlive the tasks holding them.
+ */
+class CancellationSource {
+    std::atomic<bool> cancelled{false};
+
+public:
+    void cancel() {
+        cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    CancellationToken token() const {
+        return CancellationToken(cancelled);
+    }
+};
+
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+    bool detached = false;
+
+    static void *operator new(size_t size) {
+        return allocateCoroutineFrame(size);
+    }
+
+    static void operator delete(void *frame, size_t size) {
+        freeCoroutineFrame(frame, size);
+    }
+
+    std::suspend_always initial_suspend() noexcept {
+        return {};
+    }
+
+    struct FinalAwaiter {
+        bool await_ready() noexcept {
+            return false;
+        }
+
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            TaskPromiseBase &promise = handle.promise();
+            if (promise.continuation) {
+                return promise.continuation;
+            }
+            if (promise.detached) {
+                handle.destroy();
+            }
+            return std::noop_coroutine();
+        }
+
+        void await_resume() noexcept {
+        }
+    };
+
+    FinalAwaiter final_suspend() noexcept {
+        return {};
+    }
+
+    void unhandled_exception() {
+        // nobody is left to rethrow it to, like an exception escaping a thread
+        if (detached) {
+            std::terminate();
+        }
+        exception = std::current_exception();
+    }
+};
+
+template<typename T>
+struct TaskPromise : TaskPromiseBase {
+    std::optional<T> value;
+
+    template<typename U>
+    void return_value(U &&result) {
+        value.emplace(std::forward<U>(result));
+    }
+
+    T result() {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+        return std::move(*value);
+    }
+};
+
+template<>
+struct TaskPromise<void> : TaskPromiseBase {
+    void return_void() {
+    }
+
+    void result() {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+};
+
+/**
+ * Lazily started coroutine. co_await runs it to completion and resumes the awaiting coroutine on whatever thread
+ * it finished, returning its result or rethrowing its exception. start() runs one without anyone awaiting it.
+ *
+ * Threads are switched by awaiting TaskExecutor, frames are waited for with VulkanRenderer::uploadsFinished().
+ */
+template<typename T = void>
+class Task {
+public:
+    struct promise_type : TaskPromise<T> {
+        Task get_return_object() {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+    };
+
+private:
+    std::coroutine_handle<promise_type> handle;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {
+    }
+
+public:
+    Task(Task &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {
+    }
+
+    Task &operator=(Task &&other) noexcept {
+        if (this != &other) {
+            if (handle) {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    ~Task() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() noexcept {
+                return false;
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+
+            T await_resume() {
+                return handle.promise().result();
+            }
+        };
+        return Awaiter{handle};
+    }
+
+    /**
+     * Runs the task on the calling thread until its first switch. It frees itself when done, and must not throw.
+     */
+    void start() && {
+        handle.promise().detached = true;
+        std::exchange(handle, nullptr).resume();
+    }
+};
+
+#endif //MAPENGINE_TASK_H
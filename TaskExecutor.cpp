@@ -0,0 +1,8 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "TaskExecutor.h"
+
+TaskExecutor::TaskExecutor(ThreadPool &pool) : pool(&pool) {
+}
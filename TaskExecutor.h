@@ -0,0 +1,44 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_TASKEXECUTOR_H
+#define MAPENGINE_TASKEXECUTOR_H
+
+#include <coroutine>
+
+#include "ThreadPool.h"
+
+/**
+ * Where tasks continue. co_await onPool() moves a task to the worker pool.
+ */
+class TaskExecutor {
+    ThreadPool *pool;
+
+public:
+    explicit TaskExecutor(ThreadPool &pool);
+
+    TaskExecutor(const TaskExecutor &) = delete;
+    TaskExecutor &operator=(const TaskExecutor &) = delete;
+
+    struct PoolAwaiter {
+        ThreadPool *pool;
+
+        bool await_ready() noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            pool->submit([handle]() { handle.resume(); });
+        }
+
+        void await_resume() noexcept {
+        }
+    };
+
+    PoolAwaiter onPool() {
+        return {pool};
+    }
+};
+
+#endif //MAPENGINE_TASKEXECUTOR_H
@@ -0,0 +1,104 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "ThreadPool.h"
+
+#include <memory>
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+    workers.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; i++) {
+        workers.emplace_back([this]() { work(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+    for (auto &worker: workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::work() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(mutex);
+            condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    condition.notify_one();
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)> &fn) {
+    if (count == 0) {
+        return;
+    }
+
+    // Shared with helpers that may start after this call has returned. Those find no work left
+    // and never touch fn.
+    struct State {
+        std::atomic<size_t> next{0};
+        size_t count{};
+        const std::function<void(size_t)> *fn{};
+        std::mutex mutex;
+        std::condition_variable done;
+        int active = 0;
+    };
+    auto state = std::make_shared<State>();
+    state->count = count;
+    state->fn = &fn;
+
+    auto run = [](State &s) {
+        for (size_t i = s.next++; i < s.count; i = s.next++) {
+            (*s.fn)(i);
+        }
+    };
+
+    size_t helpers = std::min(count - 1, workers.size());
+    for (size_t i = 0; i < helpers; i++) {
+        submit([state, run]() {
+            {
+                std::lock_guard lock(state->mutex);
+                if (state->next >= state->count) {
+                    return;
+                }
+                state->active++;
+            }
+            run(*state);
+            {
+                std::lock_guard lock(state->mutex);
+                state->active--;
+            }
+            state->done.notify_one();
+        });
+    }
+
+    run(*state);
+
+    std::unique_lock lock(state->mutex);
+    state->done.wait(lock, [&]() { return state->active == 0; });
+}
+
+size_t ThreadPool::pending() const {
+    std::lock_guard lock(mutex);
+    return tasks.size();
+}
@@ -0,0 +1,51 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_THREADPOOL_H
+#define MAPENGINE_THREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <algorithm>
+
+class ThreadPool {
+private:
+    // disable copying
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    mutable std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping = false;
+
+    void work();
+
+public:
+    explicit ThreadPool(unsigned threadCount = std::max(2U, std::thread::hardware_concurrency()) - 1);
+    ~ThreadPool();
+
+    void submit(std::function<void()> task);
+
+    /**
+     * Calls fn(i) for every i in [0, count) using the workers and the calling thread.
+     * Returns when every call has finished. Workers busy with other tasks are not waited for.
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)> &fn);
+
+    size_t threadCount() const {
+        return workers.size();
+    }
+
+    size_t pending() const;
+};
+
+
+#endif //MAPENGINE_THREADPOOL_H
@@ -0,0 +1,267 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "TileArchive.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <queue>
+#include <stdexcept>
+
+static const char ARCHIVE_MAGIC[4] = {'M', 'T', 'A', 'R'};
+static const uint32_t ARCHIVE_VERSION = 1;
+// index entries the writer holds before spilling them
+static const size_t MAX_BUFFERED_ENTRIES = 65536;
+// entries read from each run, and written to the index, at a time while merging
+static const size_t MERGE_BUFFER_ENTRIES = 256;
+
+TileArchiveWriter::TileArchiveWriter(const std::string &path, uint32_t layerCount)
+        : file(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc),
+          spillPath(path + ".index"),
+          spill(spillPath, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc),
+          layerCount(layerCount) {
+    if (!file || !spill) {
+        throw std::runtime_error("failed to create tile archive!");
+    }
+    // placeholder until finish
+    TileArchiveHeader header{};
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    end = sizeof(header);
+}
+
+TileArchiveWriter::~TileArchiveWriter() {
+    try {
+        finish();
+    } catch (std::exception &) {
+        // an archive without index is rejected when opened
+    }
+    if (spill.is_open()) {
+        spill.close();
+        std::remove(spillPath.c_str());
+    }
+}
+
+void TileArchiveWriter::add(const TileKey &key, const std::vector<uint8_t> &bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    file.seekp(static_cast<std::streamoff>(end));
+    file.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!file) {
+        throw std::runtime_error("failed to write tile archive!");
+    }
+    entries[key.packed()] = {key.packed(), end, static_cast<uint32_t>(bytes.size()), 0};
+    end += bytes.size();
+    if (entries.size() >= MAX_BUFFERED_ENTRIES) {
+        spillEntries();
+    }
+}
+
+void TileArchiveWriter::spillEntries() {
+    std::vector<TileArchiveEntry> run;
+    run.reserve(entries.size());
+    for (const auto &[key, entry]: entries) {
+        run.push_back(entry);
+    }
+    std::sort(run.begin(), run.end(), [](const TileArchiveEntry &a, const TileArchiveEntry &b) {
+        return a.key < b.key;
+    });
+    spill.seekp(static_cast<std::streamoff>(spilled * sizeof(TileArchiveEntry)));
+    spill.write(reinterpret_cast<const char *>(run.data()),
+                static_cast<std::streamsize>(run.size() * sizeof(TileArchiveEntry)));
+    if (!spill) {
+        throw std::runtime_error("failed to write tile archive index!");
+    }
+    runs.push_back({spilled, run.size(), run.front().key, run.back().key});
+    spilled += run.size();
+    entries.clear();
+}
+
+void TileArchiveWriter::readSpilled(uint64_t first, uint64_t count, TileArchiveEntry *out) {
+    spill.seekg(static_cast<std::streamoff>(first * sizeof(TileArchiveEntry)));
+    spill.read(reinterpret_cast<char *>(out), static_cast<std::streamsize>(count * sizeof(TileArchiveEntry)));
+    if (!spill) {
+        throw std::runtime_error("failed to read tile archive index!");
+    }
+}
+
+std::optional<TileArchiveEntry> TileArchiveWriter::findSpilled(uint64_t key) {
+    // a tile added again is in a newer run
+    for (auto run = runs.rbegin(); run != runs.rend(); ++run) {
+        if (key < run->minKey || key > run->maxKey) {
+            continue;
+        }
+        uint64_t low = 0, high = run->count;
+        TileArchiveEntry entry{};
+        while (low < high) {
+            const uint64_t middle = low + (high - low) / 2;
+            readSpilled(run->first + middle, 1, &entry);
+            if (entry.key < key) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        if (low < run->count) {
+            readSpilled(run->first + low, 1, &entry);
+            if (entry.key == key) {
+                return entry;
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<std::vector<uint8_t>> TileArchiveWriter::read(const TileKey &key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::optional<TileArchiveEntry> entry;
+    if (auto buffered = entries.find(key.packed()); buffered != entries.end()) {
+        entry = buffered->second;
+    } else {
+        entry = findSpilled(key.packed());
+    }
+    if (!entry) {
+        return std::nullopt;
+    }
+    std::vector<uint8_t> bytes(entry->size);
+    file.seekg(static_cast<std::streamoff>(entry->offset));
+    file.read(reinterpret_cast<char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!file) {
+        throw std::runtime_error("failed to read tile archive!");
+    }
+    return bytes;
+}
+
+void TileArchiveWriter::finish() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (finished) {
+        return;
+    }
+    finished = true;
+
+    if (!entries.empty()) {
+        spillEntries();
+    }
+    const uint64_t indexCount = writeIndex();
+
+    TileArchiveHeader header{
+            .version = ARCHIVE_VERSION,
+            .tileSize = TILE_SIZE,
+            .layerCount = layerCount,
+            .indexOffset = end,
+            .indexCount = indexCount,
+    };
+    std::memcpy(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+    file.seekp(0);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.flush();
+    if (!file) {
+        throw std::runtime_error("failed to write tile archive!");
+    }
+    spill.close();
+    std::remove(spillPath.c_str());
+}
+
+uint64_t TileArchiveWriter::writeIndex() {
+    struct Cursor {
+        uint64_t next; // first entry of the run not buffered yet
+        uint64_t end;
+        std::vector<TileArchiveEntry> buffer;
+        size_t position = 0;
+    };
+    std::vector<Cursor> cursors;
+    cursors.reserve(runs.size());
+    auto refill = [&](Cursor &cursor) {
+        const auto count = static_cast<size_t>(std::min<uint64_t>(MERGE_BUFFER_ENTRIES, cursor.end - cursor.next));
+        cursor.buffer.resize(count);
+        readSpilled(cursor.next, count, cursor.buffer.data());
+        cursor.next += count;
+        cursor.position = 0;
+    };
+
+    // smallest key first, of equal keys the newest run's
+    using Head = std::pair<uint64_t, size_t>; // key, run
+    auto later = [](const Head &a, const Head &b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    };
+    std::priority_queue<Head, std::vector<Head>, decltype(later)> heads(later);
+    for (const Run &run: runs) {
+        cursors.push_back({run.first, run.first + run.count});
+        refill(cursors.back());
+        heads.emplace(cursors.back().buffer.front().key, cursors.size() - 1);
+    }
+
+    std::vector<TileArchiveEntry> output;
+    output.reserve(MERGE_BUFFER_ENTRIES);
+    uint64_t written = 0;
+    auto flush = [&]() {
+        file.seekp(static_cast<std::streamoff>(end + written * sizeof(TileArchiveEntry)));
+        file.write(reinterpret_cast<const char *>(output.data()),
+                   static_cast<std::streamsize>(output.size() * sizeof(TileArchiveEntry)));
+        if (!file) {
+            throw std::runtime_error("failed to write tile archive!");
+        }
+        written += output.size();
+        output.clear();
+    };
+    std::optional<uint64_t> lastKey;
+    while (!heads.empty()) {
+        Cursor &cursor = cursors[heads.top().second];
+        heads.pop();
+        const TileArchiveEntry entry = cursor.buffer[cursor.position++];
+        // older entries of a tile added again are dropped
+        if (entry.key != lastKey) {
+            output.push_back(entry);
+            lastKey = entry.key;
+            if (output.size() == MERGE_BUFFER_ENTRIES) {
+                flush();
+            }
+        }
+        if (cursor.position == cursor.buffer.size() && cursor.next < cursor.end) {
+            refill(cursor);
+        }
+        if (cursor.position < cursor.buffer.size()) {
+            heads.emplace(cursor.buffer[cursor.position].key, &cursor - cursors.data());
+        }
+    }
+    flush();
+    return written;
+}
+
+TileArchive::TileArchive(const std::string &path) : file(path, std::ios::binary) {
+    TileArchiveHeader header{};
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!file || std::memcmp(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0 ||
+        header.version != ARCHIVE_VERSION || header.tileSize != TILE_SIZE) {
+        throw std::runtime_error("failed to open tile archive!");
+    }
+    layerCount = header.layerCount;
+
+    index.resize(header.indexCount);
+    file.seekg(static_cast<std::streamoff>(header.indexOffset));
+    file.read(reinterpret_cast<char *>(index.data()),
+              static_cast<std::streamsize>(index.size() * sizeof(TileArchiveEntry)));
+    if (!file) {
+        throw std::runtime_error("failed to read tile archive index!");
+    }
+}
+
+std::optional<std::vector<uint8_t>> TileArchive::fetch(const TileKey &key) {
+    auto entry = std::lower_bound(index.begin(), index.end(), key.packed(),
+                                  [](const TileArchiveEntry &entry, uint64_t key) {
+                                      return entry.key < key;
+                                  });
+    if (entry == index.end() || entry->key != key.packed()) {
+        return std::nullopt;
+    }
+
+    std::vector<uint8_t> bytes(entry->size);
+    std::lock_guard<std::mutex> lock(mutex);
+    file.seekg(static_cast<std::streamoff>(entry->offset));
+    file.read(reinterpret_cast<char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!file) {
+        file.clear();
+        return std::nullopt;
+    }
+    return bytes;
+}
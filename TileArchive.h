@@ -0,0 +1,109 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_TILEARCHIVE_H
+#define MAPENGINE_TILEARCHIVE_H
+
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "TileSource.h"
+
+/*
+ * Archive layout, little endian:
+ *   header  "MTAR", version, tile size, layer count, index offset (u64), index entry count (u64)
+ *   blobs   encoded tiles back to back
+ *   index   entries sorted by packed key: key (u64), offset (u64), size (u32), padding (u32)
+ */
+
+struct TileArchiveHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t tileSize;
+    uint32_t layerCount;
+    uint64_t indexOffset;
+    uint64_t indexCount;
+};
+
+struct TileArchiveEntry {
+    uint64_t key;
+    uint64_t offset;
+    uint32_t size;
+    uint32_t padding;
+};
+
+/**
+ * Appends tiles to a new archive. Safe to use from several threads, and tiles already written can be read back
+ * while the archive is being built.
+ *
+ * Index entries are buffered up to a limit, then sorted and spilled as a run to a temporary file next to the
+ * archive. finish() merges the runs into the index, so memory use does not grow with the number of tiles.
+ */
+class TileArchiveWriter {
+    // sorted entries in the spill file
+    struct Run {
+        uint64_t first; // entry index in the spill file
+        uint64_t count;
+        uint64_t minKey;
+        uint64_t maxKey;
+    };
+
+    std::fstream file;
+    std::string spillPath;
+    std::fstream spill;
+    std::mutex mutex;
+    std::unordered_map<uint64_t, TileArchiveEntry> entries; // not spilled yet, newer than the runs
+    std::vector<Run> runs; // oldest first
+    uint64_t spilled = 0;
+    uint64_t end;
+    uint32_t layerCount;
+    bool finished = false;
+
+    void spillEntries();
+    void readSpilled(uint64_t first, uint64_t count, TileArchiveEntry *out);
+    std::optional<TileArchiveEntry> findSpilled(uint64_t key);
+    uint64_t writeIndex();
+
+public:
+    TileArchiveWriter(const std::string &path, uint32_t layerCount);
+    ~TileArchiveWriter();
+
+    TileArchiveWriter(const TileArchiveWriter &) = delete;
+    TileArchiveWriter &operator=(const TileArchiveWriter &) = delete;
+
+    void add(const TileKey &key, const std::vector<uint8_t> &bytes);
+
+    /**
+     * @return tile added before, nullopt if there is none
+     */
+    std::optional<std::vector<uint8_t>> read(const TileKey &key);
+
+    /**
+     * Writes the index and the header. Called by the destructor if not before.
+     */
+    void finish();
+};
+
+/**
+ * Reads tiles from an archive written by TileArchiveWriter. The index is held in memory.
+ */
+class TileArchive : public TileSource {
+    std::ifstream file;
+    std::mutex mutex;
+    std::vector<TileArchiveEntry> index;
+    uint32_t layerCount;
+
+public:
+    explicit TileArchive(const std::string &path);
+
+    std::optional<std::vector<uint8_t>> fetch(const TileKey &key) override;
+
+    uint32_t getLayerCount() const override {
+        return layerCount;
+    }
+};
+
+#endif //MAPENGINE_TILEARCHIVE_H
@@ -0,0 +1,32 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_TILEKEY_H
+#define MAPENGINE_TILEKEY_H
+
+#include <cstdint>
+#include <functional>
+
+// Identifies a tile of the pyramid, level n has 2^n tiles per side
+struct TileKey {
+    uint32_t layer;
+    uint32_t row;
+    uint32_t column;
+
+    bool operator==(const TileKey &other) const = default;
+
+    // unique up to layer 29
+    uint64_t packed() const {
+        return (static_cast<uint64_t>(layer) << 58) | (static_cast<uint64_t>(row) << 29) | column;
+    }
+};
+
+template<>
+struct std::hash<TileKey> {
+    size_t operator()(const TileKey &key) const noexcept {
+        return std::hash<uint64_t>()(key.packed());
+    }
+};
+
+#endif //MAPENGINE_TILEKEY_H
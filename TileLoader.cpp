@@ -0,0 +1,202 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "TileLoader.h"
+
+#include <stdexcept>
+#include <utility>
+
+// a queued tile not wanted for this long is cancelled
+static const std::chrono::milliseconds CANCEL_AFTER{500};
+// entries of the negative cache before expired ones are purged
+static const size_t MAX_ABSENT_TILES = 1 << 20;
+
+TileLoader::TileLoader(TaskExecutor &executor, TileSource &source, TileRamCache *ramCache, unsigned maxLoads,
+                       std::chrono::seconds emptyTtl, std::chrono::seconds failedTtl)
+        : executor(&executor), source(&source), ramCache(ramCache), maxLoads(maxLoads), emptyTtl(emptyTtl),
+          failedTtl(failedTtl) {
+}
+
+TileLoader::~TileLoader() {
+    std::unique_lock lock(mutex);
+    queue = {};
+    wanted.clear();
+    idle.wait(lock, [this]() { return activeLoads == 0; });
+}
+
+uint32_t TileLoader::secondsSinceEpoch(Clock::time_point time) const {
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::seconds>(time - epoch).count());
+}
+
+bool TileLoader::isAbsent(const TileKey &key, Clock::time_point now) {
+    auto entry = absent.find(key.packed());
+    if (entry == absent.end()) {
+        return false;
+    }
+    if (entry->second > secondsSinceEpoch(now)) {
+        return true;
+    }
+    absent.erase(entry);
+    return false;
+}
+
+void TileLoader::rememberAbsent(const TileKey &key, std::chrono::seconds ttl) {
+    if (absent.size() >= MAX_ABSENT_TILES) {
+        const uint32_t now = secondsSinceEpoch(Clock::now());
+        std::erase_if(absent, [&](const auto &entry) { return entry.second <= now; });
+        if (absent.size() >= MAX_ABSENT_TILES) {
+            // still full of live entries, forgetting only costs refetches
+            absent.clear();
+        }
+    }
+    absent[key.packed()] = secondsSinceEpoch(Clock::now() + ttl);
+}
+
+void TileLoader::request(const TileKey &key, Clock::time_point deadline) {
+    std::lock_guard lock(mutex);
+    if (loading.contains(key) || finished.contains(key) || isAbsent(key, Clock::now())) {
+        return;
+    }
+    auto [queued, inserted] = wanted.try_emplace(key, Wanted{deadline, deadline});
+    if (!inserted) {
+        queued->second.until = std::max(queued->second.until, deadline);
+        if (queued->second.deadline <= deadline) {
+            return;
+        }
+        queued->second.deadline = deadline;
+    }
+    queue.push({deadline, key});
+    startLoads();
+}
+
+void TileLoader::cancel(const TileKey &key) {
+    std::lock_guard lock(mutex);
+    wanted.erase(key);
+    if (auto load = loading.find(key); load != loading.end()) {
+        load->second.cancel();
+    }
+}
+
+void TileLoader::startLoads() {
+    // each load takes the most urgent tile when it starts, not when it is submitted
+    for (; activeLoads < maxLoads && activeLoads < wanted.size(); activeLoads++) {
+        loadQueued().start();
+    }
+}
+
+std::optional<TileImage> TileLoader::loadFromRam(const TileKey &key) {
+    if (!ramCache) {
+        return std::nullopt;
+    }
+    if (auto decoded = ramCache->getDecoded(key)) {
+        return *decoded;
+    }
+    if (auto encoded = ramCache->getEncoded(key)) {
+        if (auto image = source->decode(*encoded)) {
+            ramCache->putDecoded(key, *image);
+            return image;
+        }
+    }
+    return std::nullopt;
+}
+
+Task<std::optional<std::vector<uint8_t>>> TileLoader::fetch(TileKey key) {
+    co_await executor->onPool();
+    auto bytes = source->fetch(key);
+    // before loadTile checks for cancellation, so that a cancelled load keeps what it fetched
+    if (bytes && ramCache && source->isEncodedCacheable()) {
+        ramCache->putEncoded(key, *bytes);
+    }
+    co_return bytes;
+}
+
+Task<TileImage> TileLoader::decode(TileKey key, std::vector<uint8_t> bytes) {
+    co_await executor->onPool();
+    auto image = source->decode(bytes);
+    if (!image) {
+        throw std::runtime_error("failed to decode tile!");
+    }
+    if (ramCache) {
+        ramCache->putDecoded(key, *image);
+    }
+    co_return std::move(*image);
+}
+
+Task<std::optional<TileImage>> TileLoader::loadTile(TileKey key, CancellationToken token) {
+    if (auto image = loadFromRam(key)) {
+        co_return image;
+    }
+    auto bytes = co_await fetch(key);
+    if (!bytes) {
+        co_return std::nullopt;
+    }
+    token.throwIfCancelled();
+    co_return co_await decode(key, std::move(*bytes));
+}
+
+Task<> TileLoader::loadQueued() {
+    co_await executor->onPool();
+    std::unique_lock lock(mutex);
+    while (!wanted.empty()) {
+        const Queued next = queue.top();
+        queue.pop();
+        auto queued = wanted.find(next.key);
+        if (queued == wanted.end() || queued->second.deadline != next.deadline) {
+            continue;
+        }
+        const bool stale = Clock::now() > queued->second.until + CANCEL_AFTER;
+        wanted.erase(queued);
+        if (stale) {
+            continue;
+        }
+        const CancellationToken token = loading.try_emplace(next.key).first->second.token();
+        lock.unlock();
+
+        // each stage is a pool task of its own, the lock must not be held across them
+        std::optional<TileImage> image;
+        bool failed = false;
+        bool stopped = false;
+        try {
+            image = co_await loadTile(next.key, token);
+        } catch (TaskCancelled &) {
+            stopped = true;
+        } catch (std::exception &) {
+            failed = true;
+        }
+
+        lock.lock();
+        // the token points into the entry
+        const bool cancelled = token.isCancelled();
+        loading.erase(next.key);
+        if (image) {
+            finished.insert(next.key);
+            results.push_back({next.key, std::move(*image), cancelled});
+        } else if (!stopped) {
+            rememberAbsent(next.key, failed ? failedTtl : emptyTtl);
+        }
+    }
+    activeLoads--;
+    idle.notify_all();
+}
+
+std::vector<TileLoader::Result> TileLoader::collect(size_t max) {
+    std::lock_guard lock(mutex);
+    std::vector<Result> collected;
+    while (!results.empty() && collected.size() < max) {
+        finished.erase(results.front().key);
+        collected.push_back(std::move(results.front()));
+        results.pop_front();
+    }
+    return collected;
+}
+
+bool TileLoader::isBusy() {
+    std::lock_guard lock(mutex);
+    return !wanted.empty() || !loading.empty() || !results.empty();
+}
+
+TileLoader::Depths TileLoader::getDepths() {
+    std::lock_guard lock(mutex);
+    return {wanted.size(), loading.size(), results.size()};
+}
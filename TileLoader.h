@@ -0,0 +1,133 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_TILELOADER_H
+#define MAPENGINE_TILELOADER_H
+
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "TileSource.h"
+#include "TileRamCache.h"
+#include "Task.h"
+#include "TaskExecutor.h"
+
+/**
+ * Fetches and decodes tiles on the thread pool. Queued tiles are loaded in deadline order, and at most a few
+ * loads run at once so that the pool stays available to other work.
+ *
+ * Each tile has at most one load, however often it is requested while queued, loading or waiting to be
+ * collected. Tiles the source does not have are remembered for a while, failed ones for a shorter while, and
+ * requests for them are ignored until then. A queued tile nobody asked for since its deadline passed a while
+ * ago is cancelled. A cancelled load that already started stops before its next stage, what it fetched is kept
+ * in the RAM cache unless the source's tiles are not worth caching encoded.
+ */
+class TileLoader {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Result {
+        TileKey key;
+        TileImage image;
+        bool cancelled = false; // no longer wanted when it finished
+    };
+
+    struct Depths {
+        size_t queued;
+        size_t loading; // fetching or decoding
+        size_t finished; // waiting to be collected
+    };
+
+private:
+    struct Queued {
+        Clock::time_point deadline;
+        TileKey key;
+
+        bool operator>(const Queued &other) const {
+            return deadline > other.deadline;
+        }
+    };
+
+    struct Wanted {
+        Clock::time_point deadline; // earliest, orders the queue
+        Clock::time_point until; // latest, the tile is cancelled a while after it
+    };
+
+    TaskExecutor *executor;
+    TileSource *source;
+    TileRamCache *ramCache;
+    unsigned maxLoads;
+    std::chrono::seconds emptyTtl;
+    std::chrono::seconds failedTtl;
+    const Clock::time_point epoch = Clock::now();
+
+    std::mutex mutex;
+    std::condition_variable idle;
+    std::priority_queue<Queued, std::vector<Queued>, std::greater<>> queue;
+    std::unordered_map<TileKey, Wanted> wanted; // queued tiles, stale queue entries differ in deadline
+    std::unordered_map<TileKey, CancellationSource> loading;
+    std::unordered_set<TileKey> finished; // in results
+    std::deque<Result> results;
+    unsigned activeLoads = 0;
+
+    // packed key to the second since epoch when the tile may be requested again
+    std::unordered_map<uint64_t, uint32_t> absent;
+
+    uint32_t secondsSinceEpoch(Clock::time_point time) const;
+    bool isAbsent(const TileKey &key, Clock::time_point now);
+    void rememberAbsent(const TileKey &key, std::chrono::seconds ttl);
+    std::optional<TileImage> loadFromRam(const TileKey &key);
+    void startLoads();
+    Task<> loadQueued();
+    Task<std::optional<TileImage>> loadTile(TileKey key, CancellationToken token);
+    Task<std::optional<std::vector<uint8_t>>> fetch(TileKey key);
+    Task<TileImage> decode(TileKey key, std::vector<uint8_t> bytes);
+
+public:
+    /**
+     * @param ramCache looked up before the source and filled from it, may be nullptr
+     * @param maxLoads loads running at the same time, usually the source's getConcurrency()
+     * @param emptyTtl how long a tile the source does not have is not requested again
+     * @param failedTtl how long a tile the source failed to deliver is not requested again
+     */
+    TileLoader(TaskExecutor &executor, TileSource &source, TileRamCache *ramCache = nullptr, unsigned maxLoads = 4,
+               std::chrono::seconds emptyTtl = std::chrono::minutes(10),
+               std::chrono::seconds failedTtl = std::chrono::seconds(15));
+    ~TileLoader();
+
+    TileLoader(const TileLoader &) = delete;
+    TileLoader &operator=(const TileLoader &) = delete;
+
+    /**
+     * Queues the tile unless it is queued, loading or finished already, or known to be missing. A tile queued
+     * again keeps the earlier deadline and stays wanted until the later one.
+     */
+    void request(const TileKey &key, Clock::time_point deadline);
+
+    /**
+     * Drops the tile from the queue. A load in progress stops before its next stage, or is delivered as cancelled
+     * when it has none left.
+     */
+    void cancel(const TileKey &key);
+
+    /**
+     * @param max results to return, the rest stay for the next calls
+     * @return loaded tiles, oldest first. Missing and failed tiles are not reported.
+     */
+    std::vector<Result> collect(size_t max = SIZE_MAX);
+
+    /**
+     * @return true while loads are queued, running or waiting to be collected
+     */
+    bool isBusy();
+
+    Depths getDepths();
+};
+
+#endif //MAPENGINE_TILELOADER_H
@@ -0,0 +1,27 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "TileRamCache.h"
+
+TileRamCache::TileRamCache(size_t encodedBudget, size_t decodedBudget, unsigned shardCount)
+        : encoded(encodedBudget, shardCount), decoded(decodedBudget, shardCount) {
+}
+
+std::shared_ptr<const std::vector<uint8_t>> TileRamCache::getEncoded(const TileKey &key) {
+    return encoded.get(key);
+}
+
+void TileRamCache::putEncoded(const TileKey &key, std::vector<uint8_t> bytes) {
+    const size_t size = bytes.size();
+    encoded.put(key, std::make_shared<const std::vector<uint8_t>>(std::move(bytes)), size);
+}
+
+std::shared_ptr<const TileImage> TileRamCache::getDecoded(const TileKey &key) {
+    return decoded.get(key);
+}
+
+void TileRamCache::putDecoded(const TileKey &key, TileImage image) {
+    const size_t size = image.pixels.size();
+    decoded.put(key, std::make_shared<const TileImage>(std::move(image)), size);
+}
@@ -0,0 +1,141 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_TILERAMCACHE_H
+#define MAPENGINE_TILERAMCACHE_H
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "TileSource.h"
+
+// Lookups of one cache tier, totals since start
+struct TileTierStats {
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    // totals at the last takeHitRatio()
+    uint64_t takenHits = 0;
+    uint64_t takenMisses = 0;
+
+    void count(bool hit) {
+        (hit ? hits : misses).fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Not thread safe, call from one thread.
+     *
+     * @return hits per lookup since the last call, 0 without lookups
+     */
+    double takeHitRatio() {
+        const uint64_t h = hits.load(std::memory_order_relaxed) - takenHits;
+        const uint64_t m = misses.load(std::memory_order_relaxed) - takenMisses;
+        takenHits += h;
+        takenMisses += m;
+        return h + m == 0 ? 0 : static_cast<double>(h) / static_cast<double>(h + m);
+    }
+};
+
+/**
+ * Byte-budgeted LRU split into shards by key, each with its own lock, so that loader threads rarely wait for
+ * each other. Values are shared, a value evicted while in use stays alive for its users.
+ */
+template<typename Value>
+class ShardedTileLru {
+    struct Entry {
+        TileKey key;
+        std::shared_ptr<const Value> value;
+        size_t bytes;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> entries; // most recently used first
+        std::unordered_map<TileKey, typename std::list<Entry>::iterator> index;
+        size_t bytes = 0;
+    };
+
+    std::vector<Shard> shards;
+    size_t shardBudget;
+
+    Shard &shardOf(const TileKey &key) {
+        // packed keys of neighbouring tiles differ in the low bits only
+        return shards[(key.packed() * 0x9E3779B97F4A7C15ull >> 32) % shards.size()];
+    }
+
+public:
+    TileTierStats stats;
+
+    ShardedTileLru(size_t budget, unsigned shardCount) : shards(shardCount), shardBudget(budget / shardCount) {
+    }
+
+    std::shared_ptr<const Value> get(const TileKey &key) {
+        Shard &shard = shardOf(key);
+        std::lock_guard lock(shard.mutex);
+        auto found = shard.index.find(key);
+        stats.count(found != shard.index.end());
+        if (found == shard.index.end()) {
+            return nullptr;
+        }
+        shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+        return found->second->value;
+    }
+
+    void put(const TileKey &key, std::shared_ptr<const Value> value, size_t bytes) {
+        if (bytes > shardBudget) {
+            return;
+        }
+        Shard &shard = shardOf(key);
+        std::lock_guard lock(shard.mutex);
+        if (auto old = shard.index.find(key); old != shard.index.end()) {
+            shard.bytes -= old->second->bytes;
+            shard.entries.erase(old->second);
+            shard.index.erase(old);
+        }
+        shard.entries.push_front({key, std::move(value), bytes});
+        shard.index.emplace(key, shard.entries.begin());
+        shard.bytes += bytes;
+        while (shard.bytes > shardBudget) {
+            shard.bytes -= shard.entries.back().bytes;
+            shard.index.erase(shard.entries.back().key);
+            shard.entries.pop_back();
+        }
+    }
+};
+
+/**
+ * RAM tier between the tile sources and the GPU. Encoded tiles make revisiting an area a decode instead of a
+ * fetch, and the optional decoded tiles make it a copy.
+ */
+class TileRamCache {
+    ShardedTileLru<std::vector<uint8_t>> encoded;
+    ShardedTileLru<TileImage> decoded;
+
+public:
+    /**
+     * @param encodedBudget bytes of encoded tiles
+     * @param decodedBudget bytes of decoded tiles, 0 keeps none
+     */
+    explicit TileRamCache(size_t encodedBudget = size_t{256} << 20, size_t decodedBudget = size_t{256} << 20,
+                          unsigned shardCount = 16);
+
+    std::shared_ptr<const std::vector<uint8_t>> getEncoded(const TileKey &key);
+    void putEncoded(const TileKey &key, std::vector<uint8_t> bytes);
+
+    std::shared_ptr<const TileImage> getDecoded(const TileKey &key);
+    void putDecoded(const TileKey &key, TileImage image);
+
+    TileTierStats &encodedStats() {
+        return encoded.stats;
+    }
+
+    TileTierStats &decodedStats() {
+        return decoded.stats;
+    }
+};
+
+#endif //MAPENGINE_TILERAMCACHE_H
@@ -0,0 +1,92 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+
+#include "TileSource.h"
+
+#include <algorithm>
+
+#include <stb_image.h>
+#include <stb_image_write.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+std::optional<TileImage> TileSource::decode(const std::vector<uint8_t> &bytes) const {
+    return decodeTile(bytes.data(), bytes.size());
+}
+
+uint32_t pyramidBaseLayer(uint32_t width, uint32_t height) {
+    const uint32_t tiles = (std::max(width, height) + TILE_SIZE - 1) / TILE_SIZE;
+    uint32_t layer = 0;
+    while ((1u << layer) < tiles) {
+        layer++;
+    }
+    return layer;
+}
+
+std::optional<TileImage> decodeTile(const uint8_t *bytes, size_t size) {
+    int width, height, channels;
+    stbi_uc *pixels = stbi_load_from_memory(bytes, static_cast<int>(size), &width, &height, &channels,
+                                            STBI_rgb_alpha);
+    if (!pixels) {
+        return std::nullopt;
+    }
+    TileImage image{static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+    image.pixels.assign(pixels, pixels + size_t{image.width} * image.height * 4);
+    stbi_image_free(pixels);
+    return image;
+}
+
+std::vector<uint8_t> encodeTile(const TileImage &image) {
+    std::vector<uint8_t> bytes;
+    stbi_write_png_to_func([](void *context, void *data, int size) {
+        auto out = static_cast<std::vector<uint8_t> *>(context);
+        out->insert(out->end(), static_cast<uint8_t *>(data), static_cast<uint8_t *>(data) + size);
+    }, &bytes, static_cast<int>(image.width), static_cast<int>(image.height), 4, image.pixels.data(),
+                           static_cast<int>(image.width * 4));
+    return bytes;
+}
+
+// Averages 2x2 blocks of two RGBA rows into one row of count pixels
+static void downsampleRow(const uint8_t *top, const uint8_t *bottom, uint8_t *out, uint32_t count) {
+    uint32_t x = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+    // four output pixels from eight input pixels per step, summed in 16 bit lanes
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rounding = _mm_set1_epi16(2);
+    for (; x + 4 <= count; x += 4) {
+        __m128i sums[4];
+        for (int half = 0; half < 2; half++) {
+            const __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i *>(top + x * 8 + half * 16));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bottom + x * 8 + half * 16));
+            // vertical pairs, each register holds two neighbouring input pixels
+            const __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(t, zero), _mm_unpacklo_epi8(b, zero));
+            const __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(t, zero), _mm_unpackhi_epi8(b, zero));
+            // horizontal pairs land in the low four lanes
+            sums[half * 2] = _mm_add_epi16(low, _mm_srli_si128(low, 8));
+            sums[half * 2 + 1] = _mm_add_epi16(high, _mm_srli_si128(high, 8));
+        }
+        const __m128i first = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(sums[0], sums[1]), rounding), 2);
+        const __m128i second = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(sums[2], sums[3]), rounding), 2);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x * 4), _mm_packus_epi16(first, second));
+    }
+#endif
+    for (uint32_t i = x * 4; i < count * 4; i++) {
+        // channel i % 4 of pixel i / 4 averages the same channel of its 2x2 children
+        const uint32_t j = (i / 4) * 8 + i % 4;
+        out[i] = static_cast<uint8_t>((top[j] + top[j + 4] + bottom[j] + bottom[j + 4] + 2) / 4);
+    }
+}
+
+void downsampleInto(const TileImage &child, TileImage &parent, uint32_t quadrantX, uint32_t quadrantY) {
+    const uint32_t half = TILE_SIZE / 2;
+    for (uint32_t y = 0; y < half; y++) {
+        const uint8_t *top = child.pixels.data() + size_t{y} * 2 * TILE_SIZE * 4;
+        uint8_t *out = parent.pixels.data() + (size_t{quadrantY * half + y} * TILE_SIZE + quadrantX * half) * 4;
+        downsampleRow(top, top + TILE_SIZE * 4, out, half);
+    }
+}
@@ -0,0 +1,89 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_TILESOURCE_H
+#define MAPENGINE_TILESOURCE_H
+
+#include <cstdint>
+#include <vector>
+#include <optional>
+
+#include "TileKey.h"
+
+// edge length of every tile in pixels, same as View::TILE_PIXELS
+static const uint32_t TILE_SIZE = 256;
+
+// RGBA8 pixels, rows top to bottom
+struct TileImage {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint8_t> pixels;
+};
+
+/**
+ * Where tiles come from. Sources hand out the tile as stored, usually PNG or JPEG, and decoding is a separate
+ * step so that encoded bytes can be cached and decoded later. Both are called from loader threads.
+ */
+class TileSource {
+public:
+    virtual ~TileSource() = default;
+
+    /**
+     * @return layers the source has tiles for, finer layers are not requested
+     */
+    virtual uint32_t getLayerCount() const = 0;
+
+    /**
+     * @return fetches worth running at the same time, more only wait inside the source
+     */
+    virtual unsigned getConcurrency() const {
+        return 4;
+    }
+
+    /**
+     * @return false when fetching a tile again is as cheap as keeping what fetch returned, e.g. raw pixels from a
+     * mapped file, so that RAM caches keep only the decoded tile
+     */
+    virtual bool isEncodedCacheable() const {
+        return true;
+    }
+
+    /**
+     * @return encoded tile, nullopt when the source has no such tile
+     * @throws std::runtime_error when the source fails to tell
+     */
+    virtual std::optional<std::vector<uint8_t>> fetch(const TileKey &key) = 0;
+
+    /**
+     * @param bytes what fetch returned
+     * @return nullopt when the bytes are not a valid image
+     */
+    virtual std::optional<TileImage> decode(const std::vector<uint8_t> &bytes) const;
+};
+
+/**
+ * @return finest layer of a pyramid whose tiles hold an image of this size unscaled, the image covering the
+ * top left corner of the map
+ */
+uint32_t pyramidBaseLayer(uint32_t width, uint32_t height);
+
+/**
+ * Decodes any format stb_image reads to RGBA8.
+ */
+std::optional<TileImage> decodeTile(const uint8_t *bytes, size_t size);
+
+/**
+ * @return image encoded as PNG
+ */
+std::vector<uint8_t> encodeTile(const TileImage &image);
+
+/**
+ * Box filters a TILE_SIZE tile into one quadrant of its parent. Uses SSE2 where available.
+ *
+ * @param quadrantX 0 for the left half of the parent, 1 for the right half
+ * @param quadrantY 0 for the top half of the parent, 1 for the bottom half
+ */
+void downsampleInto(const TileImage &child, TileImage &parent, uint32_t quadrantX, uint32_t quadrantY);
+
+#endif //MAPENGINE_TILESOURCE_H
@@ -4,6 +4,17 @@
 
 #include "View.h"
 
+#include <unordered_set>
+#include <limits>
+#include <glm/gtc/constants.hpp>
+
+// curvature of the flight path, the value users preferred in van Wijk and Nuij's study
+static const float FLIGHT_RHO = 1.42f;
+// path samples per second of flight when planning tile requests
+static const float FLIGHT_SAMPLES_PER_SECOND = 60;
+// tangent of half the vertical field of view, about 53 degrees
+static const float TAN_HALF_FOV = .5f;
+
 void View::scale(float scaleFactor) {
     auto size = transformation.size.get();
     auto windowSize = transformation.windowSize.get();
@@ -50,18 +61,15 @@ void View::limitTranslation() {
 }
 
 void View::boundingBox(MapVec &boundingBoxLeftTop, MapVec &boundingBoxRightBottom) {
-    auto windowSize = transformation.windowSize.get();
-    const auto mapCoords = transformation.getWindowToMapMatrix() * glm::mat4(
-            glm::vec4(0, 0, 0, 1),
-            glm::vec4(windowSize.x, 0, 0, 1),
-            glm::vec4(0, windowSize.y, 0, 1),
-            glm::vec4(windowSize.x, windowSize.y, 0, 1)
-    );
-    const MapVec mapTopLeft = glm::column(mapCoords, 0).xy;
-    const MapVec mapTopRight = glm::column(mapCoords, 1).xy;
-    const MapVec mapBottomLeft = glm::column(mapCoords, 2).xy;
-    const MapVec mapBottomRight = glm::column(mapCoords, 3).xy;
-    const std::array<MapVec, 4> viewCorners = {mapTopLeft, mapTopRight, mapBottomLeft, mapBottomRight};
+    // the zoom and translation limits stay the same when the camera tilts
+    const float angle = transformation.angle.get();
+    const OrientedBox topDown{
+            transformation.center.get(),
+            MapVec(std::cos(angle), -std::sin(angle)),
+            MapVec(std::sin(angle), std::cos(angle)),
+            transformation.size.get() / 2.f
+    };
+    const std::array<MapVec, 4> viewCorners = topDown.corners();
     boundingBoxLeftTop = MapVec(1, -1);
     boundingBoxRightBottom = MapVec(-1, 1);
     for (auto viewCorner: viewCorners) {
@@ -76,107 +84,300 @@ void View::rotate(float deltaAngle, float winX, float winY) {
     auto center = transformation.center.get();
     auto unchangedCenter = center;
     auto z = glm::vec3(0, 0, 1);
-    MapVec map = (transformation.getWindowToMapMatrix() * glm::vec4(winX, winY, 0, 1)).xy;
+    MapVec map = windowToMap(winX, winY);
     center -= map;
     center = (glm::rotate(glm::mat4(1), -deltaAngle, z) * glm::vec4(center, 0, 1)).xy;
     center += map;
     transformation.center = center;
     transformation.angle += deltaAngle;
 
-    map = (transformation.getWindowToMapMatrix() * glm::vec4(winX, winY, 0, 1)).xy;
+    map = windowToMap(winX, winY);
     limitZoom(unchangedCenter, transformation.size.get(), 1, map);
     limitTranslation();
 }
 
+void View::tilt(float deltaPitch) {
+    transformation.pitch = std::clamp(transformation.pitch.get() + deltaPitch, 0.f, MAX_PITCH);
+}
+
 void View::zoom(float scaleFactor, float winX, float winY) {
-    MapVec map = (transformation.getWindowToMapMatrix() * glm::vec4(winX, winY, 0, 1)).xy;
+    // a pitched camera scales with the view, so the point under the cursor stays there too
+    MapVec map = windowToMap(winX, winY);
     auto unchangedCenter = transformation.center.get();
     auto unchangedSize = transformation.size.get();
     transformation.center = scaleFactor * (unchangedCenter - map) + map;
     scale(scaleFactor);
 
-    map = (transformation.getWindowToMapMatrix() * glm::vec4(winX, winY, 0, 1)).xy;
+    map = windowToMap(winX, winY);
     limitZoom(unchangedCenter, unchangedSize, scaleFactor, map);
     limitTranslation();
 }
 
 void View::translate(float winDX, float winDY) {
-    auto r = transformation.getWindowToMapMatrix() * glm::mat2x4(
-            glm::vec4(0, 0, 0, 1),
-            glm::vec4(winDX, winDY, 0, 1)
-    );
-    transformation.center += glm::column(r, 0).xy - glm::column(r, 1).xy;
+    // a pitched view moves as much as the map at the center of the window
+    const WindowVec middle = transformation.windowSize.get() * .5f;
+    transformation.center += windowToMap(middle.x, middle.y) - windowToMap(middle.x + winDX, middle.y + winDY);
     limitTranslation();
 }
 
-std::vector<TileVec> View::getTiles() {
-    // TODO: optimize 45 deg angle
+void View::setCamera(MapVec center, float width, float angle) {
+    const auto windowSize = transformation.windowSize.get();
+    transformation.center = center;
+    transformation.angle = angle;
+    transformation.size = MapVec(width, width * windowSize.y / windowSize.x);
+    limitZoom(center, transformation.size.get(), 1, center);
+    limitTranslation();
+}
 
-    MapVec boundingBoxLeftTop;
-    MapVec boundingBoxRightBottom;
-    boundingBox(boundingBoxLeftTop, boundingBoxRightBottom);
-    MapVec maxDiffVec(boundingBoxRightBottom.x - boundingBoxLeftTop.x, boundingBoxLeftTop.y - boundingBoxRightBottom.y);
-
-    double pixels;
-    double maxDiff;
-    {
-        if (maxDiffVec.x > maxDiffVec.y) {
-            maxDiffVec.y = 0;
-            maxDiff = maxDiffVec.x;
-        } else {
-            maxDiffVec.x = 0;
-            maxDiff = maxDiffVec.y;
-        }
+void View::Flight::pose(float t, MapVec &center, float &width, float &angle) const {
+    const float s = t * length;
+    const float rho2 = FLIGHT_RHO * FLIGHT_RHO;
+    if (t >= 1) {
+        center = to;
+        width = toWidth;
+        angle = fromAngle + deltaAngle;
+        return;
+    }
+    if (panning) {
+        const MapVec direction = (to - from) / glm::length(to - from);
+        const float u = fromWidth / rho2 * (std::cosh(r0) * std::tanh(FLIGHT_RHO * s + r0) - std::sinh(r0));
+        center = from + direction * u;
+        width = fromWidth * std::cosh(r0) / std::cosh(FLIGHT_RHO * s + r0);
+    } else {
+        center = from;
+        width = fromWidth * std::exp((toWidth < fromWidth ? -1.f : 1.f) * FLIGHT_RHO * s);
+    }
+    angle = fromAngle + deltaAngle * t;
+}
 
-        glm::mat4 vulkanToWindow(1);
-        auto windowSize = transformation.windowSize.get();
-        vulkanToWindow = glm::scale(vulkanToWindow, glm::vec3(windowSize.x / 2, windowSize.y / 2, 1));
-        vulkanToWindow = glm::translate(vulkanToWindow, glm::vec3(1, 1, 0));
-        auto r = vulkanToWindow * transformation.getViewMatrix() * glm::mat2x4(
-                glm::vec4(maxDiffVec, 0, 1),
-                glm::vec4(0, 0, 0, 1)
-        );
-        pixels = glm::length(glm::column(r, 0) - glm::column(r, 1));
+std::vector<TileRequest> View::flyTo(MapVec center, float width, float angle, float duration) {
+    const MapVec from = transformation.center.get();
+    const float fromWidth = transformation.size.get().x;
+    const float fromAngle = transformation.angle.get();
+    const float rho2 = FLIGHT_RHO * FLIGHT_RHO;
+
+    Flight plan{
+            .from = from,
+            .to = center,
+            .fromWidth = fromWidth,
+            .toWidth = width,
+            .fromAngle = fromAngle,
+            // the short way around
+            .deltaAngle = std::remainder(angle - fromAngle, 2 * glm::pi<float>()),
+            .r0 = 0,
+            .length = 0,
+            .panning = false,
+            .duration = std::max(duration, 1e-3f),
+    };
+    const float distance = glm::length(center - from);
+    if (distance > 1e-6f * std::max(fromWidth, width)) {
+        const auto b = [&](float w, float sign) {
+            return (width * width - fromWidth * fromWidth + sign * rho2 * rho2 * distance * distance) /
+                   (2 * w * rho2 * distance);
+        };
+        // ln(-b + sqrt(b^2 + 1)) without the cancellation
+        const auto r = [](float b) {
+            return -std::asinh(b);
+        };
+        plan.r0 = r(b(fromWidth, 1));
+        plan.length = (r(b(width, -1)) - plan.r0) / FLIGHT_RHO;
+        plan.panning = true;
+    } else {
+        plan.length = std::abs(std::log(width / fromWidth)) / FLIGHT_RHO;
     }
 
-    // TODO: Do not draw tiles that are not in the window
-    const int layer = floor(log2(2 / maxDiff * pixels / 256));
-    const auto tilesPerDimensionInMap = static_cast<double>(1U << layer);
-    const auto tileSide = static_cast<float>(2 / tilesPerDimensionInMap);
-    const int hCount = static_cast<int>(1 + ceil((boundingBoxRightBottom.x - boundingBoxLeftTop.x) / tileSide));
-    const int vCount = static_cast<int>(1 + ceil((boundingBoxLeftTop.y - boundingBoxRightBottom.y) / tileSide));
-    MapVec tileHorPos;
-    MapVec tileVerPos = glm::vec2(0, 0);
+    // Follow the path on a copy and collect what getTiles() returns on the way. Frames fall between the
+    // samples, so the tile rectangle swept from one sample to the next is requested too.
+    std::vector<TileRequest> requests;
+    std::unordered_set<TileKey> seen;
+    const auto request = [&](const TileVec &tile, float deadline) {
+        if (seen.insert(tile.key()).second) {
+            requests.push_back({tile, deadline});
+        }
+    };
+    View probe(*this);
+    probe.flight.reset();
+    std::vector<TileVec> previous;
+    const int samples = std::max(2, static_cast<int>(std::ceil(plan.duration * FLIGHT_SAMPLES_PER_SECOND)) + 1);
+    std::vector<float> sampleTimes;
+    for (int i = 0; i < samples; i++) {
+        sampleTimes.push_back(static_cast<float>(i) / static_cast<float>(samples - 1));
+    }
+    // the width peaks once, sampling the peak keeps the width monotonic between samples
+    if (plan.panning && plan.length > 0) {
+        const float peak = -plan.r0 / FLIGHT_RHO / plan.length;
+        if (peak > 0 && peak < 1) {
+            sampleTimes.insert(std::upper_bound(sampleTimes.begin(), sampleTimes.end(), peak), peak);
+        }
+    }
+    for (float t: sampleTimes) {
+        MapVec sampleCenter;
+        float sampleWidth, sampleAngle;
+        plan.pose(t, sampleCenter, sampleWidth, sampleAngle);
+        probe.setCamera(sampleCenter, sampleWidth, sampleAngle);
+        std::vector<TileVec> tiles = probe.getTiles();
+        for (const auto &tile: tiles) {
+            request(tile, t * plan.duration);
+        }
 
-    std::vector<TileVec> output;
-    for (int j = 0; j < vCount; j++) {
-        tileHorPos = glm::vec2(0, 0);
-        for (int i = 0; i < hCount; i++) {
-            auto tilePos = boundingBoxLeftTop + tileHorPos + tileVerPos;
-            double column = floor((tilePos.x + 1) / 2 * tilesPerDimensionInMap);
-            double row = floor((tilePos.y - 1) / -2 * tilesPerDimensionInMap);
-            if (column >= 0 && row >= 0 && column < (1 << layer) && row < (1 << layer)) {
-                tilePos = MapVec(
-                        static_cast<float>(column / tilesPerDimensionInMap * 2.f - 1.f + tileSide / 2),
-                        static_cast<float>(row / tilesPerDimensionInMap * -2.f + 1.f - tileSide / 2)
-                );
-
-                output.push_back({
-                                         tilePos,
-                                         tileSide,
-                                         static_cast<uint32_t>(row),
-                                         static_cast<uint32_t>(column)
-                                 });
+        // the tiles of a pitched view vary too much in level for that, its samples have to do
+        if (!previous.empty() && !tiles.empty() && transformation.pitch.get() == 0) {
+            MapBox swept{MapVec(std::numeric_limits<float>::max()), MapVec(std::numeric_limits<float>::lowest())};
+            for (const auto *sample: {&previous, &tiles}) {
+                for (const auto &tile: *sample) {
+                    swept.min = glm::min(swept.min, tile.center - tile.tileSide / 2);
+                    swept.max = glm::max(swept.max, tile.center + tile.tileSide / 2);
+                }
+            }
+            // frames between samples may use any layer in between
+            uint32_t minLayer = UINT32_MAX;
+            uint32_t maxLayer = 0;
+            for (const auto *sample: {&previous, &tiles}) {
+                for (const auto &tile: *sample) {
+                    minLayer = std::min(minLayer, tile.layer);
+                    maxLayer = std::max(maxLayer, tile.layer);
+                }
             }
+            for (uint32_t layer = minLayer; layer <= maxLayer; layer++) {
+                const auto tilesPerDimension = static_cast<float>(1U << layer);
+                const auto toIndex = [&](float coordinate) {
+                    return static_cast<uint32_t>(std::clamp(coordinate * tilesPerDimension, 0.f,
+                                                            tilesPerDimension - 1));
+                };
+                // getTiles() rounds the window's bounding box out to whole tiles, so frames between the samples
+                // may reach one tile further
+                const uint32_t minColumn = toIndex((swept.min.x + 1) / 2) - (toIndex((swept.min.x + 1) / 2) > 0);
+                const uint32_t maxColumn = std::min(toIndex((swept.max.x + 1) / 2) + 1, (1U << layer) - 1);
+                const uint32_t minRow = toIndex((1 - swept.max.y) / 2) - (toIndex((1 - swept.max.y) / 2) > 0);
+                const uint32_t maxRow = std::min(toIndex((1 - swept.min.y) / 2) + 1, (1U << layer) - 1);
+                for (uint32_t row = minRow; row <= maxRow; row++) {
+                    for (uint32_t column = minColumn; column <= maxColumn; column++) {
+                        request(tileAt(layer, row, column), t * plan.duration);
+                    }
+                }
+            }
+        }
+        previous = std::move(tiles);
+    }
+
+    flight = plan;
+    return requests;
+}
+
+void View::animate(float dt) {
+    if (!flight) {
+        return;
+    }
+    flight->elapsed += dt;
+    const float t = std::min(flight->elapsed / flight->duration, 1.f);
+    MapVec center;
+    float width, angle;
+    flight->pose(t, center, width, angle);
+    setCamera(center, width, angle);
+    if (t >= 1) {
+        flight.reset();
+    }
+}
 
-            tileHorPos.x += tileSide;
+bool View::isFlying() const {
+    return flight.has_value();
+}
+
+void View::stopFlight() {
+    flight.reset();
+}
+
+void View::jumpTo(MapVec center, float width, float angle) {
+    flight.reset();
+    setCamera(center, width, angle);
+}
+
+int View::getLayer() {
+    // the coarsest layer whose texels span at most MAX_TEXEL_PIXELS where w is 1
+    const float pixelsPerMapUnit = transformation.windowSize.get().x / transformation.size.get().x;
+    return std::max(0, static_cast<int>(std::ceil(std::log2(2 * pixelsPerMapUnit /
+                                                            (MAX_TEXEL_PIXELS * TILE_PIXELS)))));
+}
+
+float View::texelPixels(const ViewSnapshot &view, MapVec tileCenter, float tileSide) {
+    // w is the distance from the camera relative to the center's, linear over the map plane
+    const glm::vec4 w = glm::row(view.viewMatrix, 3);
+    const float nearest = glm::dot(MapVec(w.x, w.y), tileCenter) + w.w -
+                          tileSide / 2 * (std::abs(w.x) + std::abs(w.y));
+    const float pixelsPerMapUnit = view.windowSize.x / view.size.x;
+    return tileSide / TILE_PIXELS * pixelsPerMapUnit / std::max(nearest, NEAR_PLANE);
+}
+
+void View::collectTiles(const ViewSnapshot &view, const TileVec &tile, std::vector<TileVec> &output) {
+    const MapVec half(tile.tileSide / 2);
+    if (!view.footprint.intersects({tile.center - half, tile.center + half})) {
+        return;
+    }
+    if (tile.layer >= maxLayer || texelPixels(view, tile.center, tile.tileSide) <= MAX_TEXEL_PIXELS) {
+        output.push_back(tile);
+        return;
+    }
+    for (uint32_t row = tile.row * 2; row < tile.row * 2 + 2; row++) {
+        for (uint32_t column = tile.column * 2; column < tile.column * 2 + 2; column++) {
+            collectTiles(view, tileAt(tile.layer + 1, row, column), output);
         }
-        tileVerPos.y -= tileSide;
     }
+}
 
+std::vector<TileVec> View::getTiles() {
+    std::vector<TileVec> output;
+    collectTiles(snapshot(), tileAt(0, 0, 0), output);
     return output;
 }
 
+TileVec View::tileAt(uint32_t layer, uint32_t row, uint32_t column) {
+    const auto tilesPerDimensionInMap = static_cast<double>(1U << layer);
+    const auto tileSide = static_cast<float>(2 / tilesPerDimensionInMap);
+    return {
+            MapVec(
+                    static_cast<float>(column / tilesPerDimensionInMap * 2.f - 1.f + tileSide / 2),
+                    static_cast<float>(row / tilesPerDimensionInMap * -2.f + 1.f - tileSide / 2)
+            ),
+            tileSide,
+            row,
+            column,
+            layer
+    };
+}
+
+ViewSnapshot View::snapshot() {
+    const WindowVec windowSize = transformation.windowSize.get();
+    return {
+            transformation.center.get(),
+            transformation.angle.get(),
+            transformation.pitch.get(),
+            transformation.size.get(),
+            windowSize,
+            transformation.getViewMatrix(),
+            {{windowToMap(0, 0), windowToMap(windowSize.x, 0), windowToMap(windowSize.x, windowSize.y),
+              windowToMap(0, windowSize.y)}}
+    };
+}
+
+MapVec View::windowToMap(float winX, float winY) {
+    // where the pixel's ray from the near to the far plane meets the map
+    const glm::mat4 &windowToMap = transformation.getWindowToMapMatrix();
+    const glm::vec4 near = windowToMap * glm::vec4(winX, winY, 0, 1);
+    const glm::vec4 far = windowToMap * glm::vec4(winX, winY, 1, 1);
+    const glm::vec3 from = glm::vec3(near) / near.w;
+    const glm::vec3 to = glm::vec3(far) / far.w;
+    const glm::vec3 map = glm::mix(from, to, from.z / (from.z - to.z));
+    return {map.x, map.y};
+}
+
+float View::windowToMapLength(float pixels) {
+    return pixels * transformation.size.get().x / transformation.windowSize.get().x;
+}
+
+OrientedBox View::getViewBox() {
+    return snapshot().viewBox();
+}
+
 View::View(
         float cx,
         float cy,
@@ -195,18 +396,41 @@ void View::Transformation::calculateWindowToMapMatrix() {
     windowToVulkan = glm::translate(windowToVulkan, glm::vec3(-1, -1, 0));
     windowToVulkan = glm::scale(windowToVulkan, glm::vec3(2 / windowSize.get().x, 2 / windowSize.get().y, 1));
 
+    // inverting the projection alone keeps the center as exact as it is
     glm::mat4 vulkanToMap(1);
     vulkanToMap = glm::translate(vulkanToMap, glm::vec3(center.get(), 0));
     vulkanToMap = glm::rotate(vulkanToMap, -angle.get(), glm::vec3(0, 0, 1));
-    vulkanToMap = glm::scale(vulkanToMap, glm::vec3(size.get().x / 2, -size.get().y / 2, 1));
+    vulkanToMap = vulkanToMap * glm::inverse(calculateProjection());
 
     windowToMapMatrix = vulkanToMap * windowToVulkan;
 }
 
+glm::mat4 View::Transformation::calculateProjection() {
+    // The camera looks at the center from where the window's height spans size.y there, tilted so that the top
+    // of the window is farther away. Rows are Vulkan x, y, depth and w, all divided by the camera's distance to
+    // the center, so that a view from straight above keeps w at 1 and maps the map as it did without perspective.
+    const float distance = size.get().y / (2 * TAN_HALF_FOV);
+    const float near = distance * NEAR_PLANE;
+    const float far = 2 * distance / std::cos(pitch.get() + std::atan(TAN_HALF_FOV));
+    const float sinPitch = std::sin(pitch.get());
+    const float cosPitch = std::cos(pitch.get());
+    const float depthScale = far / (far - near) / distance;
+
+    glm::mat4 projection(0);
+    projection[0][0] = 2 / size.get().x;
+    projection[1][1] = -2 * cosPitch / size.get().y;
+    projection[2][1] = -2 * sinPitch / size.get().y;
+    projection[1][2] = depthScale * sinPitch;
+    projection[2][2] = -depthScale * cosPitch;
+    projection[3][2] = depthScale * (distance - near);
+    projection[1][3] = sinPitch / distance;
+    projection[2][3] = -cosPitch / distance;
+    projection[3][3] = 1;
+    return projection;
+}
+
 void View::Transformation::calculateViewMatrix() {
-    viewMatrix = glm::mat4(1);
-    viewMatrix = glm::scale(viewMatrix, glm::vec3(2 / size.get().x, -2 / size.get().y, 1));
-    viewMatrix = glm::rotate(viewMatrix, angle.get(), glm::vec3(0, 0, 1));
+    viewMatrix = glm::rotate(calculateProjection(), angle.get(), glm::vec3(0, 0, 1));
     viewMatrix = glm::translate(viewMatrix, glm::vec3(-center.get(), 0));
 }
 
@@ -229,7 +453,34 @@ const glm::mat4 &View::Transformation::getViewMatrix() {
 View::Transformation::Transformation(float cx, float cy, float angle, float width, float windowWidth, float windowHeight) :
         center{MapVec(cx, cy), winToMapMatrixDirty, viewMatrixDirty},
         angle{angle, winToMapMatrixDirty, viewMatrixDirty},
+        pitch{0, winToMapMatrixDirty, viewMatrixDirty},
         size{MapVec(width, width * windowHeight / windowWidth), winToMapMatrixDirty, viewMatrixDirty},
         windowSize{WindowVec(windowWidth, windowHeight), winToMapMatrixDirty, viewMatrixDirty} {
 
+}
+
+View::Transformation::Transformation(const Transformation &other) :
+        viewMatrix(other.viewMatrix),
+        windowToMapMatrix(other.windowToMapMatrix),
+        winToMapMatrixDirty(other.winToMapMatrixDirty),
+        viewMatrixDirty(other.viewMatrixDirty),
+        center{other.center.value, winToMapMatrixDirty, viewMatrixDirty},
+        angle{other.angle.value, winToMapMatrixDirty, viewMatrixDirty},
+        pitch{other.pitch.value, winToMapMatrixDirty, viewMatrixDirty},
+        size{other.size.value, winToMapMatrixDirty, viewMatrixDirty},
+        windowSize{other.windowSize.value, winToMapMatrixDirty, viewMatrixDirty} {
+
+}
+
+View::Transformation &View::Transformation::operator=(const Transformation &other) {
+    viewMatrix = other.viewMatrix;
+    windowToMapMatrix = other.windowToMapMatrix;
+    winToMapMatrixDirty = other.winToMapMatrixDirty;
+    viewMatrixDirty = other.viewMatrixDirty;
+    center.value = other.center.value;
+    angle.value = other.angle.value;
+    pitch.value = other.pitch.value;
+    size.value = other.size.value;
+    windowSize.value = other.windowSize.value;
+    return *this;
 }
\ No newline at end of file
@@ -9,30 +9,118 @@
 #include <array>
 #include <functional>
 #include <cmath>
+#include <optional>
+#include <limits>
 #include <glm/glm.hpp>
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/gtc/matrix_access.hpp>
 
-typedef glm::vec2 MapVec;
-typedef glm::vec2 WindowVec;
+#include "MapGeometry.h"
+#include "TileKey.h"
 
 struct TileVec {
     MapVec center;
     float tileSide;
     uint32_t row;
     uint32_t column;
+    uint32_t layer;
+
+    TileKey key() const {
+        return {layer, row, column};
+    }
+};
+
+// A tile needed by a planned camera movement
+struct TileRequest {
+    TileVec tile;
+    float deadline; // seconds from the start of the movement
+};
+
+// Copy of the camera state that can be handed to other threads
+struct ViewSnapshot {
+    MapVec center;
+    float angle;
+    float pitch;
+    MapVec size; // at the center
+    WindowVec windowSize;
+    glm::mat4 viewMatrix;
+    MapQuad footprint; // area the window shows, from its top left corner clockwise
+
+    WindowVec mapToWindow(MapVec map) const {
+        glm::vec4 vulkan = viewMatrix * glm::vec4(map, 0, 1);
+        return (MapVec(vulkan.x, vulkan.y) / vulkan.w + MapVec(1, 1)) * .5f * windowSize;
+    }
+
+    // area covered by the window in map units, a pitched view's footprint is bounded along the window's axes
+    OrientedBox viewBox() const {
+        const MapVec axisX(std::cos(angle), -std::sin(angle));
+        const MapVec axisY(std::sin(angle), std::cos(angle));
+        if (pitch == 0) {
+            return {center, axisX, axisY, size / 2.f};
+        }
+        MapVec min(std::numeric_limits<float>::max());
+        MapVec max(std::numeric_limits<float>::lowest());
+        for (MapVec corner: footprint.corners) {
+            const MapVec local(glm::dot(corner - center, axisX), glm::dot(corner - center, axisY));
+            min = glm::min(min, local);
+            max = glm::max(max, local);
+        }
+        const MapVec middle = (min + max) * .5f;
+        return {center + axisX * middle.x + axisY * middle.y, axisX, axisY, (max - min) * .5f};
+    }
+
+    // same zoom, rotation and window, center may differ. Moving a pitched view changes the perspective, so it
+    // has to stay in place.
+    bool sameScale(const ViewSnapshot &other) const {
+        return angle == other.angle && pitch == other.pitch && size == other.size &&
+               windowSize == other.windowSize && (pitch == 0 || center == other.center);
+    }
 };
 
 class View {
+public:
+    static const int TILE_PIXELS = 256;
+    // steepest pitch, 60 degrees, the window's top edge still shows the map and not the sky
+    static constexpr float MAX_PITCH = 1.04719755f;
+    // tiles are refined while their texels span more pixels
+    static constexpr float MAX_TEXEL_PIXELS = 2;
+    // near clipping plane as a fraction of the camera's distance to the center
+    static constexpr float NEAR_PLANE = .1f;
+
 private:
     void scale(float scaleFactor);
 
+    // of the window's area as seen from straight above, pitch aside
     void boundingBox(MapVec &boundingBoxLeftTop, MapVec &boundingBoxRightBottom);
 
     void limitZoom(MapVec previousCenter, MapVec previousSize, float scaleFactor, MapVec zoomCenter);
 
     void limitTranslation();
 
+    void collectTiles(const ViewSnapshot &view, const TileVec &tile, std::vector<TileVec> &output);
+
+    // Optimal zoom and pan path of van Wijk and Nuij, "Smooth and efficient zooming and panning"
+    struct Flight {
+        MapVec from;
+        MapVec to;
+        float fromWidth;
+        float toWidth;
+        float fromAngle;
+        float deltaAngle;
+        float r0;
+        float length; // path length in the paper's units
+        bool panning; // false when the centers coincide and the path only zooms
+        float duration;
+        float elapsed = 0;
+
+        void pose(float t, MapVec &center, float &width, float &angle) const;
+    };
+    std::optional<Flight> flight;
+
+    uint32_t maxLayer = std::numeric_limits<uint32_t>::max();
+
+    void setCamera(MapVec center, float width, float angle);
+
     struct Transformation {
     private:
         template<typename T>
@@ -59,14 +147,17 @@ private:
         };
 
 
-        // map coord to vulkan coord
+        // map coord to vulkan coord, perspective when pitched. w is 1 at the center of the window.
         glm::mat4 viewMatrix{};
 
-        // window coord to map coord
+        // window coord and depth to homogeneous map coord
         glm::mat4 windowToMapMatrix{};
 
         void calculateWindowToMapMatrix();
 
+        // map coord relative to the center, turned with the window, to Vulkan coord
+        glm::mat4 calculateProjection();
+
         void calculateViewMatrix();
 
         bool winToMapMatrixDirty = true;
@@ -80,7 +171,8 @@ private:
 
         Field<MapVec> center;
         Field<float> angle;
-        Field<MapVec> size; // zoom
+        Field<float> pitch; // radians from looking straight down, the top of the window tilts away
+        Field<MapVec> size; // zoom, map units the window spans at its center
         Field<WindowVec> windowSize;
 
         Transformation(
@@ -91,6 +183,11 @@ private:
                 float windowWidth,
                 float windowHeight
         );
+
+        // the fields refer to the dirty flags of their own transformation
+        Transformation(const Transformation &other);
+
+        Transformation &operator=(const Transformation &other);
     } transformation;
 
 public:
@@ -120,15 +217,107 @@ public:
 
     void rotate(float deltaAngle, float winX, float winY);
 
+    /**
+     * Tilts the camera about the center of the window, within 0 and MAX_PITCH.
+     *
+     * @param deltaPitch radians, positive shows more of the area above the center
+     */
+    void tilt(float deltaPitch);
+
+    float getPitch() {
+        return transformation.pitch.get();
+    }
+
     void zoom(float scaleFactor, float winX, float winY);
 
     void translate(float winDX, float winDY);
 
+    /**
+     * Starts flying to another camera: zooms out, pans and zooms back in so the motion looks uniform.
+     * animate() moves the camera along the path.
+     *
+     * @param width view width in map units
+     * @param angle view angle in radians
+     * @param duration seconds
+     * @return every tile getTiles() returns along the path, in path order, with the time it is first needed
+     */
+    std::vector<TileRequest> flyTo(MapVec center, float width, float angle, float duration);
+
+    /**
+     * Advances the flight, if any.
+     *
+     * @param dt seconds since the last frame
+     */
+    void animate(float dt);
+
+    bool isFlying() const;
+
+    // e.g. when user input takes over
+    void stopFlight();
+
+    /**
+     * Moves the camera at once, e.g. to follow another view. Stops any flight.
+     *
+     * @param width view width in map units
+     * @param angle view angle in radians
+     */
+    void jumpTo(MapVec center, float width, float angle);
+
     const glm::mat4 &getViewMatrix() {
         return transformation.getViewMatrix();
     };
 
+    /**
+     * @return map coordinates of a window pixel, e.g. the cursor
+     */
+    MapVec windowToMap(float winX, float winY);
+
+    /**
+     * @return length in map units of a distance in pixels at the center of the window
+     */
+    float windowToMapLength(float pixels);
+
+    WindowVec getWindowSize() {
+        return transformation.windowSize.get();
+    }
+
+    /**
+     * Selects tiles of the levels the window needs where they are shown, coarser towards the horizon of a pitched
+     * view: a tile is refined while its texels span more than MAX_TEXEL_PIXELS where it is nearest to the camera,
+     * up to the max layer. VulkanTile's culling selects the same way.
+     */
     std::vector<TileVec> getTiles();
+
+    /**
+     * Finest layer getTiles() and VulkanTile's culling select, e.g. the tile source's last. Zooming in further
+     * magnifies its tiles.
+     */
+    void setMaxLayer(uint32_t layer) {
+        maxLayer = layer;
+    }
+
+    uint32_t getMaxLayer() const {
+        return maxLayer;
+    }
+
+    static TileVec tileAt(uint32_t layer, uint32_t row, uint32_t column);
+
+    /**
+     * @return zoom level getTiles() selects at the center of the window, level n has 2^n tiles per side
+     */
+    int getLayer();
+
+    ViewSnapshot snapshot();
+
+    /**
+     * @return area covered by the window in map units, bounding the footprint of a pitched view
+     */
+    OrientedBox getViewBox();
+
+    /**
+     * @return pixels a texel of the tile spans where the tile is nearest to the camera
+     */
+    static float texelPixels(const ViewSnapshot &view, MapVec tileCenter, float tileSide);
 };
 
 
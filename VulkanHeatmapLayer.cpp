@@ -0,0 +1,376 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "VulkanHeatmapLayer.h"
+
+#include <stdexcept>
+#include <cmath>
+
+struct HeatmapComputePushConstants {
+    glm::mat4 mapToAccumulation; // map units to accumulation pixels
+    uint32_t pointCount;
+    float sigma; // accumulation pixels
+};
+
+struct HeatmapCompositePushConstants {
+    glm::mat4 vulkanToUv; // mat3, current frame's vulkan coordinates to homogeneous accumulation texture coordinates
+    glm::vec4 intensity; // float
+};
+
+// a view matrix maps the map plane by a homography, from map x, y, 1 to Vulkan x, y, w
+static glm::mat3 planeHomography(const glm::mat4 &matrix) {
+    return {
+            glm::vec3(matrix[0].x, matrix[0].y, matrix[0].w),
+            glm::vec3(matrix[1].x, matrix[1].y, matrix[1].w),
+            glm::vec3(matrix[3].x, matrix[3].y, matrix[3].w),
+    };
+}
+
+VulkanHeatmapLayer::VulkanHeatmapLayer(VulkanRenderer &renderer, uint32_t maxPoints, float radius, float intensity,
+                                       float resolution, float margin)
+        : renderer(&renderer),
+          maxPoints(maxPoints),
+          radius(radius),
+          intensity(intensity),
+          resolution(resolution),
+          margin(margin) {
+    VkDevice device = renderer.device;
+    const float scale = resolution * (1 + 2 * margin);
+    extent = {
+            static_cast<uint32_t>(std::ceil(static_cast<float>(renderer.renderArea.extent.width) * scale)),
+            static_cast<uint32_t>(std::ceil(static_cast<float>(renderer.renderArea.extent.height) * scale)),
+    };
+
+    // Images, kept in VK_IMAGE_LAYOUT_GENERAL
+    VulkanImage accumulation = createImage(renderer, extent.width, extent.height, VK_FORMAT_R32_UINT,
+                                           VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+    VulkanImage blur = createImage(renderer, extent.width, extent.height, VK_FORMAT_R32_SFLOAT,
+                                   VK_IMAGE_USAGE_STORAGE_BIT);
+    VulkanImage density = createImage(renderer, extent.width, extent.height, VK_FORMAT_R32_SFLOAT,
+                                      VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+    accumulationImage = accumulation.image;
+    blurImage = blur.image;
+    densityImage = density.image;
+    {
+        VkCommandBuffer commandBuffer = beginSingleTimeCommands(renderer);
+        for (VkImage image: {accumulationImage, blurImage, densityImage}) {
+            imageBarrier(commandBuffer, image,
+                         VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0,
+                         VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0);
+        }
+        endSingleTimeCommands(renderer, commandBuffer);
+    }
+
+    for (auto &buffer: pointBuffers) {
+        buffer = createBuffer(renderer, std::max<VkDeviceSize>(maxPoints, 1) * sizeof(float),
+                              VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+
+    VkSampler sampler;
+    {
+        VkSamplerCreateInfo samplerInfo{
+                .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+                .magFilter = VK_FILTER_LINEAR,
+                .minFilter = VK_FILTER_LINEAR,
+                .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+                .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER,
+                .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER,
+                .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER,
+                .anisotropyEnable = VK_FALSE,
+                .compareEnable = VK_FALSE,
+                .minLod = 0,
+                .maxLod = 0,
+                .borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK,
+                .unnormalizedCoordinates = VK_FALSE,
+        };
+        if (vkCreateSampler(device, &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create texture sampler!");
+        }
+        renderer.resourceStack.emplace([=]() {
+            vkDestroySampler(device, sampler, nullptr);
+        });
+    }
+
+    // Descriptor set layouts
+    VkDescriptorSetLayout computeSetLayout;
+    VkDescriptorSetLayout compositeSetLayout;
+    {
+        std::array<VkDescriptorSetLayoutBinding, 6> bindings{};
+        for (uint32_t i = 0; i < bindings.size(); i++) {
+            bindings[i] = {
+                    .binding = i,
+                    .descriptorType = i < 3 ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                    .descriptorCount = 1,
+                    .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            };
+        }
+        VkDescriptorSetLayoutCreateInfo layoutInfo{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+                .bindingCount = static_cast<uint32_t>(bindings.size()),
+                .pBindings = bindings.data(),
+        };
+        if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &computeSetLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor set layout!");
+        }
+        renderer.resourceStack.emplace([=]() {
+            vkDestroyDescriptorSetLayout(device, computeSetLayout, nullptr);
+        });
+
+        VkDescriptorSetLayoutBinding samplerBinding{
+                .binding = 0,
+                .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+        };
+        layoutInfo.bindingCount = 1;
+        layoutInfo.pBindings = &samplerBinding;
+        if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &compositeSetLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor set layout!");
+        }
+        renderer.resourceStack.emplace([=]() {
+            vkDestroyDescriptorSetLayout(device, compositeSetLayout, nullptr);
+        });
+    }
+
+    // Descriptor sets
+    {
+        std::array<VkDescriptorPoolSize, 3> poolSizes = {
+                VkDescriptorPoolSize{.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 3},
+                VkDescriptorPoolSize{.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, .descriptorCount = 3},
+                VkDescriptorPoolSize{.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .descriptorCount = 1},
+        };
+        VkDescriptorPoolCreateInfo poolInfo{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+                .maxSets = 2,
+                .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+                .pPoolSizes = poolSizes.data(),
+        };
+        VkDescriptorPool descriptorPool;
+        if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor pool!");
+        }
+        renderer.resourceStack.emplace([=]() {
+            vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+        });
+
+        std::array<VkDescriptorSetLayout, 2> setLayouts = {computeSetLayout, compositeSetLayout};
+        std::array<VkDescriptorSet, 2> sets{};
+        VkDescriptorSetAllocateInfo allocInfo{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+                .descriptorPool = descriptorPool,
+                .descriptorSetCount = static_cast<uint32_t>(setLayouts.size()),
+                .pSetLayouts = setLayouts.data(),
+        };
+        if (vkAllocateDescriptorSets(device, &allocInfo, sets.data()) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate descriptor sets!");
+        }
+        computeDescriptorSet = sets[0];
+        compositeDescriptorSet = sets[1];
+
+        std::array<VkDescriptorBufferInfo, 3> bufferInfos{};
+        std::array<VkDescriptorImageInfo, 4> imageInfos{};
+        std::array<VkWriteDescriptorSet, 7> writes{};
+        for (uint32_t i = 0; i < 3; i++) {
+            bufferInfos[i] = {
+                    .buffer = pointBuffers[i].buffer,
+                    .offset = 0,
+                    .range = VK_WHOLE_SIZE,
+            };
+            writes[i] = {
+                    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                    .dstSet = computeDescriptorSet,
+                    .dstBinding = i,
+                    .dstArrayElement = 0,
+                    .descriptorCount = 1,
+                    .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                    .pBufferInfo = &bufferInfos[i],
+            };
+        }
+        std::array<VkImageView, 3> storageViews = {accumulation.view, blur.view, density.view};
+        for (uint32_t i = 0; i < 3; i++) {
+            imageInfos[i] = {
+                    .imageView = storageViews[i],
+                    .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+            };
+            writes[3 + i] = {
+                    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                    .dstSet = computeDescriptorSet,
+                    .dstBinding = 3 + i,
+                    .dstArrayElement = 0,
+                    .descriptorCount = 1,
+                    .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                    .pImageInfo = &imageInfos[i],
+            };
+        }
+        imageInfos[3] = {
+                .sampler = sampler,
+                .imageView = density.view,
+                .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+        };
+        writes[6] = {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = compositeDescriptorSet,
+                .dstBinding = 0,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .pImageInfo = &imageInfos[3],
+        };
+        vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+
+    // Pipeline layouts
+    {
+        VkPushConstantRange range{
+                .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                .offset = 0,
+                .size = sizeof(HeatmapComputePushConstants)
+        };
+        VkPipelineLayoutCreateInfo createInfo{
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+                .setLayoutCount = 1,
+                .pSetLayouts = &computeSetLayout,
+                .pushConstantRangeCount = 1,
+                .pPushConstantRanges = &range,
+        };
+        if (vkCreatePipelineLayout(device, &createInfo, nullptr, &computeLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+        renderer.resourceStack.emplace([=, layout = computeLayout]() {
+            vkDestroyPipelineLayout(device, layout, nullptr);
+        });
+
+        range = {
+                .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+                .offset = 0,
+                .size = sizeof(HeatmapCompositePushConstants)
+        };
+        createInfo.pSetLayouts = &compositeSetLayout;
+        if (vkCreatePipelineLayout(device, &createInfo, nullptr, &compositeLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+        renderer.resourceStack.emplace([=, layout = compositeLayout]() {
+            vkDestroyPipelineLayout(device, layout, nullptr);
+        });
+    }
+
+    splatPipeline = createComputePipeline(renderer, "../shaders/heatmap_splat_comp.spv", computeLayout);
+    blurXPipeline = createComputePipeline(renderer, "../shaders/heatmap_blur_x_comp.spv", computeLayout);
+    blurYPipeline = createComputePipeline(renderer, "../shaders/heatmap_blur_y_comp.spv", computeLayout);
+    compositePipeline = createGraphicsPipeline(renderer, {
+            .vertexShaderPath = "../shaders/heatmap_vert.spv",
+            .fragmentShaderPath = "../shaders/heatmap_frag.spv",
+            .layout = compositeLayout,
+            .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP,
+    });
+}
+
+void VulkanHeatmapLayer::setPoints(const HeatmapPoints &points) {
+    // frames in flight may still splat the old points
+    vkDeviceWaitIdle(renderer->device);
+
+    pointCount = static_cast<uint32_t>(std::min<size_t>(points.x.size(), maxPoints));
+    if (pointCount > 0) {
+        std::array<const float *, 3> data = {points.x.data(), points.y.data(), points.weight.data()};
+        for (size_t i = 0; i < pointBuffers.size(); i++) {
+            uploadBuffer(*renderer, pointBuffers[i], data[i], pointCount * sizeof(float));
+        }
+    }
+    pointsVersion++;
+}
+
+bool VulkanHeatmapLayer::covers(const ViewSnapshot &view) const {
+    if (!accumulated || accumulatedVersion != pointsVersion || !accumulated->sameScale(view)) {
+        return false;
+    }
+    const WindowVec offset = accumulated->mapToWindow(view.center) - accumulated->windowSize * .5f;
+    return std::abs(offset.x) <= margin * view.windowSize.x && std::abs(offset.y) <= margin * view.windowSize.y;
+}
+
+void VulkanHeatmapLayer::compute(VkCommandBuffer commandBuffer, View &view) {
+    const ViewSnapshot snapshot = view.snapshot();
+    if (covers(snapshot)) {
+        return;
+    }
+    accumulated = snapshot;
+    accumulatedVersion = pointsVersion;
+
+    // the window plus margin maps onto the whole accumulation image
+    mapToAccumulation = glm::scale(glm::mat4(1), glm::vec3(extent.width / 2.f, extent.height / 2.f, 1));
+    mapToAccumulation = glm::translate(mapToAccumulation, glm::vec3(1, 1, 0));
+    mapToAccumulation = glm::scale(mapToAccumulation, glm::vec3(glm::vec2(1 / (1 + 2 * margin)), 1));
+    mapToAccumulation = mapToAccumulation * snapshot.viewMatrix;
+
+    // earlier frames may still sample the density
+    memoryBarrier(commandBuffer,
+                  VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                  VK_ACCESS_SHADER_READ_BIT,
+                  VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                  VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    VkClearColorValue zero{};
+    VkImageSubresourceRange range{
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .baseMipLevel = 0,
+            .levelCount = 1,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+    };
+    vkCmdClearColorImage(commandBuffer, accumulationImage, VK_IMAGE_LAYOUT_GENERAL, &zero, 1, &range);
+    memoryBarrier(commandBuffer,
+                  VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+    HeatmapComputePushConstants pushConstants{
+            mapToAccumulation,
+            pointCount,
+            radius * resolution
+    };
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computeLayout, 0, 1,
+                            &computeDescriptorSet, 0, nullptr);
+    vkCmdPushConstants(commandBuffer, computeLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                       sizeof(HeatmapComputePushConstants), &pushConstants);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, splatPipeline);
+    vkCmdDispatch(commandBuffer, (pointCount + 255) / 256, 1, 1);
+    memoryBarrier(commandBuffer,
+                  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, blurXPipeline);
+    vkCmdDispatch(commandBuffer, (extent.width + 15) / 16, (extent.height + 15) / 16, 1);
+    memoryBarrier(commandBuffer,
+                  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, blurYPipeline);
+    vkCmdDispatch(commandBuffer, (extent.width + 15) / 16, (extent.height + 15) / 16, 1);
+    memoryBarrier(commandBuffer,
+                  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                  VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+}
+
+void VulkanHeatmapLayer::render(VkCommandBuffer commandBuffer, View &view) {
+    if (!accumulated) {
+        return;
+    }
+
+    // a translated view samples the accumulation at its own map positions, through the map plane when pitched
+    const glm::mat3 accumulationToUv(glm::vec3(1.f / static_cast<float>(extent.width), 0, 0),
+                                     glm::vec3(0, 1.f / static_cast<float>(extent.height), 0),
+                                     glm::vec3(0, 0, 1));
+    const glm::mat3 vulkanToUv = accumulationToUv * planeHomography(mapToAccumulation) *
+                                 glm::inverse(planeHomography(view.getViewMatrix()));
+    HeatmapCompositePushConstants pushConstants{
+            glm::mat4(vulkanToUv),
+            glm::vec4(intensity, 0, 0, 0)
+    };
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, compositePipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, compositeLayout, 0, 1,
+                            &compositeDescriptorSet, 0, nullptr);
+    vkCmdPushConstants(commandBuffer, compositeLayout, VK_SHADER_STAGE_VERTEX_BIT, 0,
+                       sizeof(HeatmapCompositePushConstants), &pushConstants);
+    vkCmdDraw(commandBuffer, 4, 1, 0, 0);
+}
@@ -0,0 +1,89 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_VULKANHEATMAPLAYER_H
+#define MAPENGINE_VULKANHEATMAPLAYER_H
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <optional>
+
+#include "VulkanRenderer.h"
+#include "VulkanUtils.h"
+#include "View.h"
+
+// Weighted points in structure-of-arrays layout, coordinates in map units
+struct HeatmapPoints {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> weight;
+};
+
+/**
+ * Point density drawn through a color ramp.
+ *
+ * compute() splats the points into an offscreen accumulation image covering the window plus a margin and
+ * blurs it with a separable Gaussian, all in compute shaders. render() composites the result inside the
+ * rendering pass by looking the density up at each fragment's map position, so while the view only
+ * translates inside the margin the previous accumulation is reused without any compute work.
+ */
+class VulkanHeatmapLayer {
+    VulkanRenderer *renderer;
+    uint32_t maxPoints;
+    float radius;
+    float intensity;
+    float resolution;
+    float margin;
+
+    VkExtent2D extent{}; // accumulation image size
+    VkImage accumulationImage{}; // R32_UINT, fixed point weights
+    VkImage blurImage{};
+    VkImage densityImage{};
+    std::array<VulkanBuffer, 3> pointBuffers;
+    uint32_t pointCount = 0;
+    uint64_t pointsVersion = 0;
+
+    VkPipelineLayout computeLayout{};
+    VkDescriptorSet computeDescriptorSet{};
+    VkPipeline splatPipeline{};
+    VkPipeline blurXPipeline{};
+    VkPipeline blurYPipeline{};
+
+    VkPipelineLayout compositeLayout{};
+    VkDescriptorSet compositeDescriptorSet{};
+    VkPipeline compositePipeline{};
+
+    // view and points the density was computed for
+    std::optional<ViewSnapshot> accumulated;
+    uint64_t accumulatedVersion = 0;
+    glm::mat4 mapToAccumulation{1};
+
+    bool covers(const ViewSnapshot &view) const;
+
+public:
+    /**
+     * @param radius kernel standard deviation in pixels
+     * @param intensity density scale of the color ramp
+     * @param resolution accumulation pixels per window pixel
+     * @param margin extra area accumulated around the window, fraction of the window size
+     */
+    VulkanHeatmapLayer(VulkanRenderer &renderer, uint32_t maxPoints, float radius = 12, float intensity = .02f,
+                       float resolution = .5f, float margin = .25f);
+
+    /**
+     * Replaces the points, at most maxPoints. Waits for the frames in flight.
+     */
+    void setPoints(const HeatmapPoints &points);
+
+    /**
+     * Recomputes the density if the points changed or the view left the accumulated area.
+     * Records outside the rendering pass.
+     */
+    void compute(VkCommandBuffer commandBuffer, View &view);
+
+    void render(VkCommandBuffer commandBuffer, View &view);
+};
+
+
+#endif //MAPENGINE_VULKANHEATMAPLAYER_H
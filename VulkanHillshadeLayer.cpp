@@ -0,0 +1,421 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "VulkanHillshadeLayer.h"
+
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <cmath>
+
+// meters along the equator
+static const double EARTH_CIRCUMFERENCE = 40075016.686;
+// shading dispatch workgroup edge, as in hillshade.comp
+static const uint32_t SHADE_GROUP_SIZE = 16;
+
+struct HillshadePushConstants {
+    glm::vec4 light; // vec3 towards the light, x right, y down the tile and z up
+    uint32_t encoding;
+    uint32_t shading;
+    float opacity;
+};
+
+// per tile of a dispatch, the workgroup z picks it
+struct HillshadeJob {
+    float metersPerPixel;
+};
+
+/**
+ * @return ground size of a pixel of a Web Mercator tile, at the tile's center latitude
+ */
+static float metersPerPixel(const TileKey &key, uint32_t pixels) {
+    const double tiles = std::exp2(static_cast<double>(key.layer));
+    const double latitude = std::atan(std::sinh(glm::pi<double>() * (1 - 2 * (key.row + .5) / tiles)));
+    return static_cast<float>(EARTH_CIRCUMFERENCE * std::cos(latitude) / (tiles * pixels));
+}
+
+VulkanHillshadeLayer::VulkanHillshadeLayer(VulkanRenderer &renderer, VulkanTextureTable &textures,
+                                           ElevationEncoding encoding, uint32_t capacity, float opacity)
+        : renderer(&renderer),
+          textures(&textures),
+          encoding(encoding),
+          capacity(capacity),
+          opacity(opacity),
+          cache(textures, capacity),
+          tiles(renderer, textures, capacity, 1, true) {
+    VkDevice device = renderer.device;
+    setLight(glm::radians(315.0f), glm::radians(45.0f));
+
+    {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(renderer.physicalDevice, &properties);
+        const VkPhysicalDeviceLimits &limits = properties.limits;
+        // the rest of the tiles wait for the next frames' dispatches
+        maxJobs = std::min({capacity, limits.maxPerStageDescriptorSampledImages,
+                            limits.maxPerStageDescriptorStorageImages, limits.maxDescriptorSetSampledImages,
+                            limits.maxDescriptorSetStorageImages, limits.maxComputeWorkGroupCount[2]});
+    }
+
+    const uint32_t frameCount = renderer.getFramesInFlight();
+    for (uint32_t i = 0; i < frameCount; i++) {
+        jobBuffers.push_back(createBuffer(renderer, maxJobs * sizeof(HillshadeJob), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+    }
+
+    // Descriptor set layout, elevation and shaded images of the dispatch's tiles and their jobs
+    VkDescriptorSetLayout descriptorSetLayout;
+    {
+        std::array<VkDescriptorSetLayoutBinding, 3> bindings = {
+                VkDescriptorSetLayoutBinding{
+                        .binding = 0,
+                        .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                        .descriptorCount = maxJobs,
+                        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                },
+                VkDescriptorSetLayoutBinding{
+                        .binding = 1,
+                        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                        .descriptorCount = maxJobs,
+                        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                },
+                VkDescriptorSetLayoutBinding{
+                        .binding = 2,
+                        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                        .descriptorCount = 1,
+                        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                },
+        };
+        // a dispatch writes only as many images as it has tiles
+        std::array<VkDescriptorBindingFlags, 3> bindingFlags = {
+                VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT,
+                VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT,
+                0,
+        };
+        VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+                .bindingCount = static_cast<uint32_t>(bindingFlags.size()),
+                .pBindingFlags = bindingFlags.data(),
+        };
+        VkDescriptorSetLayoutCreateInfo layoutInfo{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+                .pNext = &flagsInfo,
+                .bindingCount = static_cast<uint32_t>(bindings.size()),
+                .pBindings = bindings.data(),
+        };
+        if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor set layout!");
+        }
+        renderer.resourceStack.emplace([=]() {
+            vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+        });
+    }
+
+    // Descriptor sets, one per frame in flight
+    {
+        std::array<VkDescriptorPoolSize, 3> poolSizes = {
+                VkDescriptorPoolSize{.type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, .descriptorCount = maxJobs * frameCount},
+                VkDescriptorPoolSize{.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, .descriptorCount = maxJobs * frameCount},
+                VkDescriptorPoolSize{.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = frameCount},
+        };
+        VkDescriptorPoolCreateInfo poolInfo{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+                .maxSets = frameCount,
+                .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+                .pPoolSizes = poolSizes.data(),
+        };
+        VkDescriptorPool descriptorPool;
+        if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor pool!");
+        }
+        renderer.resourceStack.emplace([=]() {
+            vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+        });
+
+        std::vector<VkDescriptorSetLayout> layouts(frameCount, descriptorSetLayout);
+        descriptorSets.resize(frameCount);
+        VkDescriptorSetAllocateInfo allocInfo{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+                .descriptorPool = descriptorPool,
+                .descriptorSetCount = frameCount,
+                .pSetLayouts = layouts.data(),
+        };
+        if (vkAllocateDescriptorSets(device, &allocInfo, descriptorSets.data()) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate descriptor sets!");
+        }
+
+        for (uint32_t frame = 0; frame < frameCount; frame++) {
+            VkDescriptorBufferInfo bufferInfo{
+                    .buffer = jobBuffers[frame].buffer,
+                    .offset = 0,
+                    .range = VK_WHOLE_SIZE,
+            };
+            VkWriteDescriptorSet write{
+                    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                    .dstSet = descriptorSets[frame],
+                    .dstBinding = 2,
+                    .dstArrayElement = 0,
+                    .descriptorCount = 1,
+                    .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                    .pBufferInfo = &bufferInfo,
+            };
+            vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+        }
+    }
+
+    // Pipeline
+    {
+        VkPushConstantRange range{
+                .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                .offset = 0,
+                .size = sizeof(HillshadePushConstants)
+        };
+        VkPipelineLayoutCreateInfo createInfo{
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+                .setLayoutCount = 1,
+                .pSetLayouts = &descriptorSetLayout,
+                .pushConstantRangeCount = 1,
+                .pPushConstantRanges = &range,
+        };
+        if (vkCreatePipelineLayout(device, &createInfo, nullptr, &layout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+        renderer.resourceStack.emplace([=, layout = layout]() {
+            vkDestroyPipelineLayout(device, layout, nullptr);
+        });
+    }
+    pipeline = createComputePipeline(renderer, "../shaders/hillshade_comp.spv", layout);
+}
+
+VulkanHillshadeLayer::~VulkanHillshadeLayer() {
+    // the shaded images go with the cache
+    for (const auto &[key, elevation]: elevations) {
+        destroyImageLater(*renderer, elevation.image);
+    }
+}
+
+bool VulkanHillshadeLayer::contains(const TileKey &key) const {
+    return cache.contains(key);
+}
+
+bool VulkanHillshadeLayer::use(const TileKey &key) {
+    return cache.use(key);
+}
+
+std::optional<uint32_t> VulkanHillshadeLayer::getTexture(const TileKey &key) const {
+    return cache.getTexture(key);
+}
+
+bool VulkanHillshadeLayer::takeChanged() {
+    return cache.takeChanged();
+}
+
+void VulkanHillshadeLayer::insert(const TileVec &tile, const TileImage &elevation) {
+    const TileKey key = tile.key();
+    if (cache.contains(key)) {
+        return;
+    }
+    VulkanImage image = createOwnedImage(*renderer, elevation.width, elevation.height, VK_FORMAT_R8G8B8A8_UNORM,
+                                         VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+    uint32_t texture;
+    VulkanImage shaded;
+    try {
+        uploadImageLater(*renderer, image.image, VK_IMAGE_LAYOUT_UNDEFINED, elevation.pixels.data(),
+                         elevation.pixels.size(), {0, 0, 0}, {elevation.width, elevation.height, 1});
+        // UNORM, sRGB formats cannot be stored to
+        shaded = createOwnedImage(*renderer, elevation.width, elevation.height, VK_FORMAT_R8G8B8A8_UNORM,
+                                  VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_STORAGE_BIT |
+                                  VK_IMAGE_USAGE_SAMPLED_BIT);
+        texture = textures->adopt(shaded);
+    } catch (...) {
+        if (shaded.image) {
+            destroyImage(*renderer, shaded);
+        }
+        destroyImage(*renderer, image);
+        throw;
+    }
+
+    if (auto evicted = cache.adopt(tile, texture)) {
+        auto entry = elevations.find(*evicted);
+        destroyImageLater(*renderer, entry->second.image);
+        elevations.erase(entry);
+    }
+    elevations.emplace(key, Elevation{image, shaded, std::max(elevation.width, elevation.height),
+                                      metersPerPixel(key, elevation.width)});
+    unshaded.push_back(key);
+}
+
+void VulkanHillshadeLayer::setLight(float azimuth, float altitude) {
+    light = {std::sin(azimuth) * std::cos(altitude), -std::cos(azimuth) * std::cos(altitude), std::sin(altitude)};
+    shadeAll = true;
+}
+
+void VulkanHillshadeLayer::setShading(TerrainShading shading) {
+    this->shading = shading;
+    shadeAll = true;
+}
+
+void VulkanHillshadeLayer::compute(VkCommandBuffer commandBuffer, View &view) {
+    if (shadeAll) {
+        unshaded.clear();
+        for (const auto &[key, elevation]: elevations) {
+            unshaded.push_back(key);
+        }
+        shadeAll = false;
+    }
+
+    // the frame's fence has been waited for, so its set and job buffer are free to write
+    const int frame = renderer->currentFrame;
+    auto *jobs = static_cast<HillshadeJob *>(jobBuffers[frame].mapped);
+    std::vector<VkDescriptorImageInfo> elevationInfos;
+    std::vector<VkDescriptorImageInfo> shadedInfos;
+    std::vector<VkImageMemoryBarrier> toGeneral;
+    std::vector<VkImageMemoryBarrier> toShaderRead;
+    uint32_t groups = 0;
+    uint32_t jobCount = 0;
+    // tiles evicted since they were queued are skipped
+    while (!unshaded.empty() && jobCount < maxJobs) {
+        auto entry = elevations.find(unshaded.back());
+        unshaded.pop_back();
+        if (entry == elevations.end()) {
+            continue;
+        }
+        Elevation &elevation = entry->second;
+        jobs[jobCount++] = {elevation.metersPerPixel};
+        elevationInfos.push_back({
+                .imageView = elevation.image.view,
+                .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        });
+        shadedInfos.push_back({
+                .imageView = elevation.shaded.view,
+                .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+        });
+        VkImageMemoryBarrier barrier{
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .srcAccessMask = 0,
+                .dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+                .oldLayout = elevation.written ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED,
+                .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = elevation.shaded.image,
+                .subresourceRange = {
+                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                        .baseMipLevel = 0,
+                        .levelCount = 1,
+                        .baseArrayLayer = 0,
+                        .layerCount = 1,
+                },
+        };
+        toGeneral.push_back(barrier);
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        toShaderRead.push_back(barrier);
+        elevation.written = true;
+        groups = std::max(groups, (elevation.side + SHADE_GROUP_SIZE - 1) / SHADE_GROUP_SIZE);
+    }
+
+    if (jobCount > 0) {
+        const std::array<VkWriteDescriptorSet, 2> writes = {
+                VkWriteDescriptorSet{
+                        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                        .dstSet = descriptorSets[frame],
+                        .dstBinding = 0,
+                        .dstArrayElement = 0,
+                        .descriptorCount = jobCount,
+                        .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                        .pImageInfo = elevationInfos.data(),
+                },
+                VkWriteDescriptorSet{
+                        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                        .dstSet = descriptorSets[frame],
+                        .dstBinding = 1,
+                        .dstArrayElement = 0,
+                        .descriptorCount = jobCount,
+                        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                        .pImageInfo = shadedInfos.data(),
+                },
+        };
+        vkUpdateDescriptorSets(renderer->device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+        // earlier frames may still sample the tiles shaded again
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr,
+                             jobCount, toGeneral.data());
+        HillshadePushConstants pushConstants{
+                glm::vec4(light, 0),
+                static_cast<uint32_t>(encoding),
+                static_cast<uint32_t>(shading),
+                opacity,
+        };
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0, 1,
+                                &descriptorSets[frame], 0, nullptr);
+        vkCmdPushConstants(commandBuffer, layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(HillshadePushConstants),
+                           &pushConstants);
+        vkCmdDispatch(commandBuffer, groups, groups, jobCount);
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr,
+                             jobCount, toShaderRead.data());
+    }
+
+    // the tiles left for the next dispatches are drawn already, transparent until then
+    std::vector<VkImageMemoryBarrier> toTransfer;
+    for (const TileKey &key: unshaded) {
+        auto entry = elevations.find(key);
+        if (entry == elevations.end() || entry->second.written) {
+            continue;
+        }
+        toTransfer.push_back({
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .srcAccessMask = 0,
+                .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = entry->second.shaded.image,
+                .subresourceRange = {
+                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                        .baseMipLevel = 0,
+                        .levelCount = 1,
+                        .baseArrayLayer = 0,
+                        .layerCount = 1,
+                },
+        });
+        entry->second.written = true;
+    }
+    if (!toTransfer.empty()) {
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                             0, nullptr, 0, nullptr, static_cast<uint32_t>(toTransfer.size()), toTransfer.data());
+        const VkClearColorValue transparent{};
+        for (VkImageMemoryBarrier &barrier: toTransfer) {
+            vkCmdClearColorImage(commandBuffer, barrier.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &transparent, 1,
+                                 &barrier.subresourceRange);
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        }
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                             0, nullptr, 0, nullptr, static_cast<uint32_t>(toTransfer.size()), toTransfer.data());
+    }
+
+    if (composited) {
+        return;
+    }
+    if (cache.takeChanged()) {
+        tiles.setCandidates(cache.getCandidates());
+    }
+    tiles.cull(commandBuffer, view);
+}
+
+void VulkanHillshadeLayer::render(VkCommandBuffer commandBuffer, View &view) {
+    if (!composited) {
+        tiles.renderCulled(commandBuffer, view);
+    }
+}
@@ -0,0 +1,145 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_VULKANHILLSHADELAYER_H
+#define MAPENGINE_VULKANHILLSHADELAYER_H
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <vector>
+
+#include "VulkanRenderer.h"
+#include "VulkanUtils.h"
+#include "VulkanTextureTable.h"
+#include "VulkanTileCache.h"
+#include "VulkanTile.h"
+#include "TileSource.h"
+#include "View.h"
+
+// how elevation tiles pack meters into RGB
+enum class ElevationEncoding {
+    TerrainRgb, // Mapbox, -10000 + (R * 65536 + G * 256 + B) * 0.1
+    Terrarium, // R * 256 + G + B / 256 - 32768
+};
+
+enum class TerrainShading {
+    Hillshade, // shadows and highlights of the light
+    Slope, // darker the steeper, independent of the light
+};
+
+/**
+ * Terrain shading drawn over the imagery, from elevation tiles of the same grid.
+ *
+ * A tile is shaded once in a compute shader when it becomes resident, and the result is cached in a tile cache
+ * of its own and drawn like imagery tiles. Only changing the light or the shading shades again, every resident
+ * tile in one dispatch. The elevation tiles stay on the GPU for that. Both images of a tile are ranges of the
+ * renderer's memory pool, so the two per tile do not count against maxMemoryAllocationCount.
+ */
+class VulkanHillshadeLayer {
+    struct Elevation {
+        VulkanImage image; // R8G8B8A8_UNORM as encoded
+        VulkanImage shaded; // owned by the texture table
+        uint32_t side; // pixels, the longer edge
+        float metersPerPixel;
+        bool written = false; // the shaded image has left VK_IMAGE_LAYOUT_UNDEFINED
+    };
+
+    VulkanRenderer *renderer;
+    VulkanTextureTable *textures;
+    ElevationEncoding encoding;
+    uint32_t capacity;
+    uint32_t maxJobs; // tiles shaded per dispatch
+    float opacity;
+    glm::vec3 light{};
+    TerrainShading shading = TerrainShading::Hillshade;
+
+    VulkanTileCache cache;
+    VulkanTile tiles;
+    std::unordered_map<TileKey, Elevation> elevations; // of the tiles in cache
+    std::vector<TileKey> unshaded; // inserted since the last compute()
+    bool shadeAll = false;
+    bool composited = false;
+
+    // one dispatch per frame, its tiles are packed into the frame's set
+    VkPipelineLayout layout{};
+    VkPipeline pipeline{};
+    std::vector<VkDescriptorSet> descriptorSets;
+    std::vector<VulkanBuffer> jobBuffers;
+
+public:
+    /**
+     * @param textures table the shaded tiles are drawn from
+     * @param capacity tiles kept shaded
+     * @param opacity of the darkest shadow
+     */
+    VulkanHillshadeLayer(VulkanRenderer &renderer, VulkanTextureTable &textures, ElevationEncoding encoding,
+                         uint32_t capacity = 2048, float opacity = .5f);
+    ~VulkanHillshadeLayer();
+
+    VulkanHillshadeLayer(const VulkanHillshadeLayer &) = delete;
+    VulkanHillshadeLayer &operator=(const VulkanHillshadeLayer &) = delete;
+
+    bool contains(const TileKey &key) const;
+
+    /**
+     * Marks a resident tile as used now.
+     *
+     * @return true if the tile is resident
+     */
+    bool use(const TileKey &key);
+
+    /**
+     * @return texture table slot of a resident shaded tile
+     */
+    std::optional<uint32_t> getTexture(const TileKey &key) const;
+
+    /**
+     * @return true if tiles were shaded for the first time or evicted since the last call
+     */
+    bool takeChanged();
+
+    /**
+     * A composited layer still shades its tiles, but another VulkanTile draws them as an overlay of its own tiles,
+     * and compute() and render() leave drawing to it.
+     */
+    void setComposited(bool composited) {
+        this->composited = composited;
+    }
+
+    /**
+     * Tiles the view selects this frame, those without shading yet show their nearest shaded ancestor.
+     */
+    void setShownTiles(const std::vector<TileVec> &shown) {
+        tiles.setShownTiles(shown);
+    }
+
+    /**
+     * Uploads the elevation tile in the next frame, whose compute() shades it.
+     */
+    void insert(const TileVec &tile, const TileImage &elevation);
+
+    /**
+     * @param azimuth radians clockwise from the top of the map
+     * @param altitude radians above the horizon
+     */
+    void setLight(float azimuth, float altitude);
+
+    void setShading(TerrainShading shading);
+
+    TerrainShading getShading() const {
+        return shading;
+    }
+
+    /**
+     * Shades the new tiles, or all of them after the light changed, and culls the view's tiles unless composited.
+     * Records outside the rendering pass.
+     */
+    void compute(VkCommandBuffer commandBuffer, View &view);
+
+    void render(VkCommandBuffer commandBuffer, View &view);
+};
+
+
+#endif //MAPENGINE_VULKANHILLSHADELAYER_H
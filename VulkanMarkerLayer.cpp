@@ -0,0 +1,227 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "VulkanMarkerLayer.h"
+
+#include <stdexcept>
+#include <cstring>
+
+struct MarkerPushConstants {
+    glm::mat4 viewMatrix;
+    glm::vec4 markerSize; // vec2, in vulkan units
+};
+
+QuadTree VulkanMarkerLayer::sortedTree(MarkerSet &markers) {
+    auto order = QuadTree::mortonOrder(markers.x, markers.y);
+    std::vector<float> x(order.size());
+    std::vector<float> y(order.size());
+    std::vector<uint32_t> color(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        x[i] = markers.x[order[i]];
+        y[i] = markers.y[order[i]];
+        color[i] = markers.color[order[i]];
+    }
+    markers = {{}, {}, std::move(color)};
+    return {std::move(x), std::move(y)};
+}
+
+VulkanMarkerLayer::VulkanMarkerLayer(VulkanRenderer &renderer, ThreadPool &pool, MarkerSet markers, float markerSize)
+        : renderer(&renderer),
+          pool(&pool),
+          quadTree(sortedTree(markers)),
+          markerSize(markerSize) {
+    VkDevice device = renderer.device;
+    const auto count = static_cast<VkDeviceSize>(quadTree.getX().size());
+
+    // Storage buffers, one per attribute
+    std::array<VulkanBuffer, 3> storageBuffers;
+    {
+        std::array<const void *, 3> data = {quadTree.getX().data(), quadTree.getY().data(), markers.color.data()};
+        for (size_t i = 0; i < storageBuffers.size(); i++) {
+            VkDeviceSize size = std::max<VkDeviceSize>(count, 1) * 4;
+            storageBuffers[i] = createBuffer(renderer, size,
+                                             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            if (count > 0) {
+                uploadBuffer(renderer, storageBuffers[i], data[i], count * 4);
+            }
+        }
+    }
+
+    // Per-frame instance buffers, large enough for every point to be visible
+    for (size_t i = 0; i < renderer.getFramesInFlight(); i++) {
+        visibleBuffers.push_back(createBuffer(renderer, std::max<VkDeviceSize>(count, 1) * sizeof(uint32_t),
+                                              VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                              VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                              VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+    }
+
+    // Descriptor set layout
+    VkDescriptorSetLayout descriptorSetLayout;
+    {
+        std::array<VkDescriptorSetLayoutBinding, 3> bindings{};
+        for (uint32_t i = 0; i < bindings.size(); i++) {
+            bindings[i] = {
+                    .binding = i,
+                    .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                    .descriptorCount = 1,
+                    .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+            };
+        }
+        VkDescriptorSetLayoutCreateInfo layoutInfo{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+                .bindingCount = static_cast<uint32_t>(bindings.size()),
+                .pBindings = bindings.data(),
+        };
+        if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor set layout!");
+        }
+        renderer.resourceStack.emplace([=]() {
+            vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+        });
+    }
+
+    // Descriptor set
+    {
+        VkDescriptorPoolSize poolSize{
+                .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = static_cast<uint32_t>(storageBuffers.size()),
+        };
+        VkDescriptorPoolCreateInfo poolInfo{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+                .maxSets = 1,
+                .poolSizeCount = 1,
+                .pPoolSizes = &poolSize,
+        };
+        VkDescriptorPool descriptorPool;
+        if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor pool!");
+        }
+        renderer.resourceStack.emplace([=]() {
+            vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+        });
+
+        VkDescriptorSetAllocateInfo allocInfo{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+                .descriptorPool = descriptorPool,
+                .descriptorSetCount = 1,
+                .pSetLayouts = &descriptorSetLayout,
+        };
+        if (vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate descriptor sets!");
+        }
+
+        std::array<VkDescriptorBufferInfo, 3> bufferInfos{};
+        std::array<VkWriteDescriptorSet, 3> writes{};
+        for (uint32_t i = 0; i < writes.size(); i++) {
+            bufferInfos[i] = {
+                    .buffer = storageBuffers[i].buffer,
+                    .offset = 0,
+                    .range = VK_WHOLE_SIZE,
+            };
+            writes[i] = {
+                    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                    .dstSet = descriptorSet,
+                    .dstBinding = i,
+                    .dstArrayElement = 0,
+                    .descriptorCount = 1,
+                    .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                    .pBufferInfo = &bufferInfos[i],
+            };
+        }
+        vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+
+    // Pipeline layout
+    {
+        VkPushConstantRange range{
+                .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+                .offset = 0,
+                .size = sizeof(MarkerPushConstants)
+        };
+        VkPipelineLayoutCreateInfo createInfo{
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+                .setLayoutCount = 1,
+                .pSetLayouts = &descriptorSetLayout,
+                .pushConstantRangeCount = 1,
+                .pPushConstantRanges = &range,
+        };
+        if (vkCreatePipelineLayout(device, &createInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+        renderer.resourceStack.emplace([=, layout = pipelineLayout]() {
+            vkDestroyPipelineLayout(device, layout, nullptr);
+        });
+    }
+
+    pipeline = createGraphicsPipeline(renderer, {
+            .vertexShaderPath = "../shaders/marker_vert.spv",
+            .fragmentShaderPath = "../shaders/marker_frag.spv",
+            .layout = pipelineLayout,
+            .bindings = {
+                    VkVertexInputBindingDescription{
+                            .binding = 0,
+                            .stride = sizeof(uint32_t),
+                            .inputRate = VK_VERTEX_INPUT_RATE_INSTANCE
+                    },
+            },
+            .attributes = {
+                    VkVertexInputAttributeDescription{
+                            .location = 0,
+                            .binding = 0,
+                            .format = VK_FORMAT_R32_UINT,
+                            .offset = 0,
+                    },
+            },
+            .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP,
+    });
+}
+
+void VulkanMarkerLayer::render(VkCommandBuffer commandBuffer, View &view) {
+    const WindowVec windowSize = view.getWindowSize();
+    OrientedBox viewBox = view.getViewBox();
+    // markers whose center is just outside the window are still partly visible
+    viewBox = viewBox.expanded(markerSize / 2 * viewBox.halfExtent.x * 2 / windowSize.x);
+
+    quadTree.split(viewBox, (pool->threadCount() + 1) * 4, tasks);
+    if (taskResults.size() < tasks.size()) {
+        taskResults.resize(tasks.size());
+    }
+    pool->parallelFor(tasks.size(), [&](size_t i) {
+        taskResults[i].clear();
+        quadTree.query(tasks[i], viewBox, taskResults[i]);
+    });
+
+    taskOffsets.resize(tasks.size());
+    size_t total = 0;
+    for (size_t i = 0; i < tasks.size(); i++) {
+        taskOffsets[i] = total;
+        total += taskResults[i].size();
+    }
+    visibleCount = static_cast<uint32_t>(total);
+    if (visibleCount == 0) {
+        return;
+    }
+
+    // the frame's fence has been waited for, so its instance buffer is free to write
+    const VulkanBuffer &visibleBuffer = visibleBuffers[renderer->currentFrame];
+    auto *dst = static_cast<uint32_t *>(visibleBuffer.mapped);
+    pool->parallelFor(tasks.size(), [&](size_t i) {
+        memcpy(dst + taskOffsets[i], taskResults[i].data(), taskResults[i].size() * sizeof(uint32_t));
+    });
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0,
+                            nullptr);
+    VkDeviceSize offset = 0;
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &visibleBuffer.buffer, &offset);
+
+    MarkerPushConstants pushConstants{
+            view.getViewMatrix(),
+            glm::vec4(markerSize / windowSize.x, markerSize / windowSize.y, 0, 0)
+    };
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(MarkerPushConstants),
+                       &pushConstants);
+    vkCmdDraw(commandBuffer, 4, visibleCount, 0, 0);
+}
@@ -0,0 +1,67 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_VULKANMARKERLAYER_H
+#define MAPENGINE_VULKANMARKERLAYER_H
+
+#include <vulkan/vulkan.h>
+#include <vector>
+
+#include "VulkanRenderer.h"
+#include "VulkanUtils.h"
+#include "ThreadPool.h"
+#include "QuadTree.h"
+#include "View.h"
+
+// Points in structure-of-arrays layout, coordinates in map units
+struct MarkerSet {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<uint32_t> color; // RGBA8, red in the lowest byte
+};
+
+/**
+ * Draws every visible point with one instanced draw.
+ *
+ * Points live in device local storage buffers. Each frame the quadtree is culled against the view on
+ * the thread pool and the indices of the visible points are written to a per-frame instance buffer.
+ */
+class VulkanMarkerLayer {
+    VulkanRenderer *renderer;
+    ThreadPool *pool;
+
+    QuadTree quadTree; // owns the coordinates, in Morton order
+    float markerSize;
+
+    VkPipeline pipeline{};
+    VkPipelineLayout pipelineLayout{};
+    VkDescriptorSet descriptorSet{};
+    std::vector<VulkanBuffer> visibleBuffers; // one per frame in flight
+
+    std::vector<uint32_t> tasks;
+    std::vector<std::vector<uint32_t>> taskResults;
+    std::vector<size_t> taskOffsets;
+    uint32_t visibleCount = 0;
+
+    /**
+     * Sorts the markers into Morton order and moves their coordinates into the returned tree.
+     */
+    static QuadTree sortedTree(MarkerSet &markers);
+
+public:
+    /**
+     * @param markers points, x and y in [-1, 1]
+     * @param markerSize marker diameter in pixels
+     */
+    VulkanMarkerLayer(VulkanRenderer &renderer, ThreadPool &pool, MarkerSet markers, float markerSize = 6);
+
+    void render(VkCommandBuffer commandBuffer, View &view);
+
+    uint32_t getVisibleCount() const {
+        return visibleCount;
+    }
+};
+
+
+#endif //MAPENGINE_VULKANMARKERLAYER_H
@@ -0,0 +1,113 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "VulkanMemoryPool.h"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+VulkanMemoryPool::VulkanMemoryPool(VkDeviceSize &allocatedMemory, VkDeviceSize blockSize)
+        : allocatedMemory(&allocatedMemory), blockSize(blockSize) {
+}
+
+MemoryAllocation VulkanMemoryPool::allocate(VkDevice device, const VkMemoryRequirements &requirements,
+                                            uint32_t memoryType, bool linear, bool map) {
+    const VkDeviceSize alignment = requirements.alignment;
+    for (uint32_t index = 0; index < blocks.size(); index++) {
+        Block &block = blocks[index];
+        if (!block.memory || block.memoryType != memoryType || block.linear != linear ||
+            (map && !block.mapped)) {
+            continue;
+        }
+        for (auto range = block.free.begin(); range != block.free.end(); ++range) {
+            const auto [offset, size] = *range;
+            const VkDeviceSize aligned = (offset + alignment - 1) / alignment * alignment;
+            if (aligned + requirements.size > offset + size) {
+                continue;
+            }
+            // the alignment gap before and the rest after stay free
+            block.free.erase(range);
+            if (aligned > offset) {
+                block.free.emplace(offset, aligned - offset);
+            }
+            if (aligned + requirements.size < offset + size) {
+                block.free.emplace(aligned + requirements.size, offset + size - aligned - requirements.size);
+            }
+            block.allocations++;
+            return {block.memory, aligned, requirements.size, index,
+                    block.mapped ? static_cast<char *>(block.mapped) + aligned : nullptr};
+        }
+    }
+
+    Block block{
+            .size = std::max(blockSize, requirements.size),
+            .memoryType = memoryType,
+            .linear = linear,
+    };
+    VkMemoryAllocateInfo allocateInfo{
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .allocationSize = block.size,
+            .memoryTypeIndex = memoryType,
+    };
+    if (vkAllocateMemory(device, &allocateInfo, nullptr, &block.memory) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate memory block!");
+    }
+    if (map && vkMapMemory(device, block.memory, 0, VK_WHOLE_SIZE, 0, &block.mapped) != VK_SUCCESS) {
+        vkFreeMemory(device, block.memory, nullptr);
+        throw std::runtime_error("failed to map memory block!");
+    }
+    *allocatedMemory += block.size;
+    if (requirements.size < block.size) {
+        block.free.emplace(requirements.size, block.size - requirements.size);
+    }
+    block.allocations = 1;
+
+    uint32_t index = 0;
+    while (index < blocks.size() && blocks[index].memory) {
+        index++;
+    }
+    if (index == blocks.size()) {
+        blocks.emplace_back();
+    }
+    blocks[index] = std::move(block);
+    return {blocks[index].memory, 0, requirements.size, index, blocks[index].mapped};
+}
+
+void VulkanMemoryPool::free(VkDevice device, const MemoryAllocation &allocation) {
+    Block &block = blocks[allocation.block];
+    VkDeviceSize offset = allocation.offset;
+    VkDeviceSize size = allocation.size;
+    auto next = block.free.lower_bound(offset);
+    if (next != block.free.end() && offset + size == next->first) {
+        size += next->second;
+        next = block.free.erase(next);
+    }
+    if (next != block.free.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            offset = previous->first;
+            size += previous->second;
+            block.free.erase(previous);
+        }
+    }
+    block.free.emplace(offset, size);
+
+    // blocks of the usual size are kept for the next allocations, one of a single large request is not
+    if (--block.allocations == 0 && block.size > blockSize) {
+        vkFreeMemory(device, block.memory, nullptr);
+        *allocatedMemory -= block.size;
+        block = {};
+    }
+}
+
+void VulkanMemoryPool::destroy(VkDevice device) {
+    for (Block &block: blocks) {
+        if (block.memory) {
+            vkFreeMemory(device, block.memory, nullptr);
+            *allocatedMemory -= block.size;
+        }
+    }
+    blocks.clear();
+}
@@ -0,0 +1,70 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_VULKANMEMORYPOOL_H
+#define MAPENGINE_VULKANMEMORYPOOL_H
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+// A range of a pool block, plain data so that it can be queued for deferred destruction
+struct MemoryAllocation {
+    VkDeviceMemory memory;
+    VkDeviceSize offset;
+    VkDeviceSize size;
+    uint32_t block; // in the pool
+    void *mapped; // at offset, for host visible memory
+};
+
+/**
+ * Device memory suballocated from large blocks, so that however many tiles are resident the allocations stay far
+ * below maxMemoryAllocationCount. Blocks hold either linear resources or optimally tiled images, never both, and
+ * are searched first fit. Freed ranges merge with their free neighbours.
+ */
+class VulkanMemoryPool {
+    struct Block {
+        VkDeviceMemory memory{};
+        VkDeviceSize size = 0;
+        uint32_t memoryType = 0;
+        bool linear = false;
+        void *mapped = nullptr;
+        std::map<VkDeviceSize, VkDeviceSize> free; // offset to size
+        uint32_t allocations = 0;
+    };
+
+    VkDeviceSize *allocatedMemory;
+    VkDeviceSize blockSize;
+    std::vector<Block> blocks; // a freed block has no memory and is reused
+
+public:
+    static const VkDeviceSize DEFAULT_BLOCK_SIZE = 64 << 20;
+
+    /**
+     * @param allocatedMemory counter of device memory the blocks are added to
+     * @param blockSize larger requests get a block of their own, freed with them
+     */
+    explicit VulkanMemoryPool(VkDeviceSize &allocatedMemory, VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE);
+
+    VulkanMemoryPool(const VulkanMemoryPool &) = delete;
+    VulkanMemoryPool &operator=(const VulkanMemoryPool &) = delete;
+
+    /**
+     * @param linear buffers and linearly tiled images, as opposed to optimally tiled images
+     * @param map maps the blocks, for host visible memory types
+     */
+    MemoryAllocation allocate(VkDevice device, const VkMemoryRequirements &requirements, uint32_t memoryType,
+                              bool linear, bool map = false);
+
+    void free(VkDevice device, const MemoryAllocation &allocation);
+
+    /**
+     * Frees every block, allocated from or not.
+     */
+    void destroy(VkDevice device);
+};
+
+
+#endif //MAPENGINE_VULKANMEMORYPOOL_H
@@ -0,0 +1,193 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "VulkanPolylineLayer.h"
+
+#include <stdexcept>
+
+struct PolylinePushConstants {
+    glm::mat4 viewMatrix;
+    glm::vec4 windowSize; // vec2 in pixels, z is the line width in pixels
+};
+
+VulkanPolylineLayer::VulkanPolylineLayer(VulkanRenderer &renderer, ThreadPool &pool, const PolylineSet &polylines,
+                                         float lineWidth)
+        : renderer(&renderer),
+          pyramid(polylines.points, polylines.offsets, pool),
+          lineWidth(lineWidth) {
+    VkDevice device = renderer.device;
+
+    // Storage buffers for points and track colors, vertex buffer for the segments of all levels
+    std::array<VulkanBuffer, 2> storageBuffers;
+    {
+        std::array<std::pair<const void *, VkDeviceSize>, 2> data = {
+                std::make_pair(polylines.points.data(), polylines.points.size() * sizeof(MapVec)),
+                std::make_pair(polylines.color.data(), polylines.color.size() * sizeof(uint32_t)),
+        };
+        for (size_t i = 0; i < storageBuffers.size(); i++) {
+            storageBuffers[i] = createBuffer(renderer, std::max<VkDeviceSize>(data[i].second, 4),
+                                             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            if (data[i].second > 0) {
+                uploadBuffer(renderer, storageBuffers[i], data[i].first, data[i].second);
+            }
+        }
+
+        const auto &segments = pyramid.getSegments();
+        const VkDeviceSize segmentsSize = segments.size() * sizeof(PolylinePyramid::Segment);
+        segmentBuffer = createBuffer(renderer, std::max<VkDeviceSize>(segmentsSize, 4),
+                                     VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if (segmentsSize > 0) {
+            uploadBuffer(renderer, segmentBuffer, segments.data(), segmentsSize);
+        }
+    }
+
+    // Descriptor set layout
+    VkDescriptorSetLayout descriptorSetLayout;
+    {
+        std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+        for (uint32_t i = 0; i < bindings.size(); i++) {
+            bindings[i] = {
+                    .binding = i,
+                    .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                    .descriptorCount = 1,
+                    .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+            };
+        }
+        VkDescriptorSetLayoutCreateInfo layoutInfo{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+                .bindingCount = static_cast<uint32_t>(bindings.size()),
+                .pBindings = bindings.data(),
+        };
+        if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor set layout!");
+        }
+        renderer.resourceStack.emplace([=]() {
+            vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+        });
+    }
+
+    // Descriptor set
+    {
+        VkDescriptorPoolSize poolSize{
+                .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = static_cast<uint32_t>(storageBuffers.size()),
+        };
+        VkDescriptorPoolCreateInfo poolInfo{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+                .maxSets = 1,
+                .poolSizeCount = 1,
+                .pPoolSizes = &poolSize,
+        };
+        VkDescriptorPool descriptorPool;
+        if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor pool!");
+        }
+        renderer.resourceStack.emplace([=]() {
+            vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+        });
+
+        VkDescriptorSetAllocateInfo allocInfo{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+                .descriptorPool = descriptorPool,
+                .descriptorSetCount = 1,
+                .pSetLayouts = &descriptorSetLayout,
+        };
+        if (vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate descriptor sets!");
+        }
+
+        std::array<VkDescriptorBufferInfo, 2> bufferInfos{};
+        std::array<VkWriteDescriptorSet, 2> writes{};
+        for (uint32_t i = 0; i < writes.size(); i++) {
+            bufferInfos[i] = {
+                    .buffer = storageBuffers[i].buffer,
+                    .offset = 0,
+                    .range = VK_WHOLE_SIZE,
+            };
+            writes[i] = {
+                    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                    .dstSet = descriptorSet,
+                    .dstBinding = i,
+                    .dstArrayElement = 0,
+                    .descriptorCount = 1,
+                    .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                    .pBufferInfo = &bufferInfos[i],
+            };
+        }
+        vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+
+    // Pipeline layout
+    {
+        VkPushConstantRange range{
+                .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+                .offset = 0,
+                .size = sizeof(PolylinePushConstants)
+        };
+        VkPipelineLayoutCreateInfo createInfo{
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+                .setLayoutCount = 1,
+                .pSetLayouts = &descriptorSetLayout,
+                .pushConstantRangeCount = 1,
+                .pPushConstantRanges = &range,
+        };
+        if (vkCreatePipelineLayout(device, &createInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+        renderer.resourceStack.emplace([=, layout = pipelineLayout]() {
+            vkDestroyPipelineLayout(device, layout, nullptr);
+        });
+    }
+
+    pipeline = createGraphicsPipeline(renderer, {
+            .vertexShaderPath = "../shaders/polyline_vert.spv",
+            .fragmentShaderPath = "../shaders/polyline_frag.spv",
+            .layout = pipelineLayout,
+            .bindings = {
+                    VkVertexInputBindingDescription{
+                            .binding = 0,
+                            .stride = sizeof(PolylinePyramid::Segment),
+                            .inputRate = VK_VERTEX_INPUT_RATE_INSTANCE
+                    },
+            },
+            .attributes = {
+                    VkVertexInputAttributeDescription{
+                            .location = 0,
+                            .binding = 0,
+                            .format = VK_FORMAT_R32G32B32_UINT,
+                            .offset = 0,
+                    },
+            },
+            .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP,
+    });
+}
+
+void VulkanPolylineLayer::render(VkCommandBuffer commandBuffer, View &view) {
+    // segments just outside the window still reach into it by half the line width
+    const OrientedBox viewBox = view.getViewBox().expanded(view.windowToMapLength(lineWidth));
+    visibleRanges.clear();
+    pyramid.query(view.getLayer(), viewBox, visibleRanges);
+    if (visibleRanges.empty()) {
+        return;
+    }
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0,
+                            nullptr);
+    VkDeviceSize offset = 0;
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &segmentBuffer.buffer, &offset);
+
+    const WindowVec windowSize = view.getWindowSize();
+    PolylinePushConstants pushConstants{
+            view.getViewMatrix(),
+            glm::vec4(windowSize, lineWidth, 0)
+    };
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PolylinePushConstants),
+                       &pushConstants);
+    for (const auto &range: visibleRanges) {
+        vkCmdDraw(commandBuffer, 4, range.count, 0, range.first);
+    }
+}
@@ -0,0 +1,54 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_VULKANPOLYLINELAYER_H
+#define MAPENGINE_VULKANPOLYLINELAYER_H
+
+#include <vulkan/vulkan.h>
+#include <vector>
+
+#include "VulkanRenderer.h"
+#include "VulkanUtils.h"
+#include "ThreadPool.h"
+#include "PolylinePyramid.h"
+#include "View.h"
+
+// Tracks stored back to back, coordinates in map units
+struct PolylineSet {
+    std::vector<MapVec> points;
+    std::vector<uint32_t> offsets; // first point of every track followed by points.size()
+    std::vector<uint32_t> color; // per track, RGBA8, red in the lowest byte
+};
+
+/**
+ * Draws tracks simplified for the current zoom level.
+ *
+ * Points and the segments of every level of the simplification pyramid are uploaded once. A frame picks
+ * the level of View::getLayer(), culls its chunks and draws the visible segment ranges instanced; the
+ * vertex shader extrudes each segment to the line width in pixels, so nothing is rebuilt on zoom or rotation.
+ */
+class VulkanPolylineLayer {
+    VulkanRenderer *renderer;
+    PolylinePyramid pyramid;
+    float lineWidth;
+
+    VkPipeline pipeline{};
+    VkPipelineLayout pipelineLayout{};
+    VkDescriptorSet descriptorSet{};
+    VulkanBuffer segmentBuffer;
+
+    std::vector<PolylinePyramid::Range> visibleRanges;
+
+public:
+    /**
+     * @param lineWidth in pixels
+     */
+    VulkanPolylineLayer(VulkanRenderer &renderer, ThreadPool &pool, const PolylineSet &polylines,
+                        float lineWidth = 3);
+
+    void render(VkCommandBuffer commandBuffer, View &view);
+};
+
+
+#endif //MAPENGINE_VULKANPOLYLINELAYER_H
@@ -3,10 +3,15 @@
 //
 
 #include "VulkanRenderer.h"
+#include "VulkanUtils.h"
 
 
 VulkanRenderer::VulkanRenderer(const std::function<void(VkInstance instance, VkSurfaceKHR *surface)> &createSurface,
-                               const std::function<void(uint32_t* width, uint32_t* height)>& getWindowSize) {
+                               const std::function<void(uint32_t* width, uint32_t* height)>& getWindowSize,
+                               LatencyMode latencyMode) : latencyMode(latencyMode) {
+    const uint32_t framesInFlight = latencyMode == LatencyMode::LowLatency ? 1 :
+                                    latencyMode == LatencyMode::Balanced ? 2 : 3;
+
     // instance
     {
         const char *layers[]{
@@ -61,11 +66,13 @@ VulkanRenderer::VulkanRenderer(const std::function<void(VkInstance instance, VkS
         });
     }
 
-    // surface
-    createSurface(instance, &surface);
-    resourceStack.emplace([=]() {
-        vkDestroySurfaceKHR(instance, surface, nullptr);
-    });
+    // surface, none when headless
+    if (createSurface) {
+        createSurface(instance, &surface);
+        resourceStack.emplace([=]() {
+            vkDestroySurfaceKHR(instance, surface, nullptr);
+        });
+    }
 
     std::vector<const char *> requiredDeviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 
@@ -115,6 +122,22 @@ VulkanRenderer::VulkanRenderer(const std::function<void(VkInstance instance, VkS
     for (; deviceIt != devices.end(); ++deviceIt) {
         physicalDevice = *deviceIt;
 
+        VkPhysicalDeviceVulkan12Features supported12{
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        };
+        VkPhysicalDeviceFeatures2 supported{
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+                .pNext = &supported12,
+        };
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &supported);
+        if (!supported.features.shaderSampledImageArrayDynamicIndexing ||
+            !supported.features.shaderStorageImageArrayDynamicIndexing ||
+            !supported12.shaderSampledImageArrayNonUniformIndexing ||
+            !supported12.descriptorBindingSampledImageUpdateAfterBind ||
+            !supported12.descriptorBindingPartiallyBound || !supported12.runtimeDescriptorArray) {
+            continue;
+        }
+
         uint32_t count;
         vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &count, nullptr);
         std::vector<VkQueueFamilyProperties> queueFamilyProperties(count);
@@ -132,13 +155,17 @@ VulkanRenderer::VulkanRenderer(const std::function<void(VkInstance instance, VkS
                     .pQueuePriorities = &queuePriority,
             };
 
-            if (queueFamilyProperties[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+            // compute layers record their dispatches into the frame's command buffer
+            const VkQueueFlags graphicsFlags = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT;
+            if ((queueFamilyProperties[i].queueFlags & graphicsFlags) == graphicsFlags) {
                 graphicsQueue.familyIndex = i;
                 pushCreateInfo = true;
             }
 
             VkBool32 surfaceSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface, &surfaceSupport);
+            if (surface) {
+                vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface, &surfaceSupport);
+            }
             if (surfaceSupport) {
                 surfaceQueue.familyIndex = i;
                 pushCreateInfo = true;
@@ -148,7 +175,7 @@ VulkanRenderer::VulkanRenderer(const std::function<void(VkInstance instance, VkS
                 queueCreateInfos.push_back(queueCreateInfo);
             }
         }
-        if (!surfaceQueue.familyIndex.has_value() || !graphicsQueue.familyIndex.has_value()) {
+        if ((surface && !surfaceQueue.familyIndex.has_value()) || !graphicsQueue.familyIndex.has_value()) {
             continue;
         }
 
@@ -156,10 +183,29 @@ VulkanRenderer::VulkanRenderer(const std::function<void(VkInstance instance, VkS
                 VK_KHR_SWAPCHAIN_EXTENSION_NAME
         };
 
-        VkPhysicalDeviceVulkan13Features features = {
+        // descriptor indexing for the bindless texture table
+        VkPhysicalDeviceVulkan12Features features12 = {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+                .descriptorIndexing = true,
+                .shaderSampledImageArrayNonUniformIndexing = true,
+                .descriptorBindingSampledImageUpdateAfterBind = true,
+                .descriptorBindingPartiallyBound = true,
+                .runtimeDescriptorArray = true,
+        };
+        VkPhysicalDeviceVulkan13Features features13 = {
                 .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+                .pNext = &features12,
                 .dynamicRendering = true
         };
+        // image arrays of compute layers, indexed by workgroup
+        VkPhysicalDeviceFeatures2 features = {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+                .pNext = &features13,
+                .features = {
+                        .shaderSampledImageArrayDynamicIndexing = true,
+                        .shaderStorageImageArrayDynamicIndexing = true,
+                },
+        };
 
         VkDeviceCreateInfo deviceCreateInfo{
                 .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
@@ -173,9 +219,14 @@ VulkanRenderer::VulkanRenderer(const std::function<void(VkInstance instance, VkS
         resourceStack.emplace([=]() {
             vkDestroyDevice(device, nullptr);
         });
+        resourceStack.emplace([this]() {
+            memoryPool.destroy(device);
+        });
 
         vkGetDeviceQueue(device, *graphicsQueue.familyIndex, 0, &graphicsQueue.queue);
-        vkGetDeviceQueue(device, *surfaceQueue.familyIndex, 0, &surfaceQueue.queue);
+        if (surface) {
+            vkGetDeviceQueue(device, *surfaceQueue.familyIndex, 0, &surfaceQueue.queue);
+        }
         break;
     }
     if (deviceIt == devices.end()) {
@@ -183,7 +234,7 @@ VulkanRenderer::VulkanRenderer(const std::function<void(VkInstance instance, VkS
     }
 
     // Create swapchain
-    {
+    if (surface) {
         VkSurfaceCapabilitiesKHR capabilities;
         vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &capabilities);
 
@@ -250,7 +301,11 @@ VulkanRenderer::VulkanRenderer(const std::function<void(VkInstance instance, VkS
         VkSwapchainCreateInfoKHR createInfo = {
                 .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
                 .surface = surface,
-                .minImageCount = std::clamp(capabilities.minImageCount + 1, capabilities.minImageCount, capabilities.maxImageCount),
+                // one image more than frames in flight so that acquiring does not wait for the display
+                .minImageCount = capabilities.maxImageCount == 0 ?
+                                 std::max(capabilities.minImageCount + 1, framesInFlight + 1) :
+                                 std::clamp(std::max(capabilities.minImageCount + 1, framesInFlight + 1),
+                                            capabilities.minImageCount, capabilities.maxImageCount),
                 .imageFormat = surfaceFormat.format,
                 .imageColorSpace = surfaceFormat.colorSpace,
                 .imageExtent = extent,
@@ -274,11 +329,10 @@ VulkanRenderer::VulkanRenderer(const std::function<void(VkInstance instance, VkS
 
     // determine records size
     // setup swapchain images
-    {
+    if (surface) {
         uint32_t imageCount;
         vkGetSwapchainImagesKHR(device, swapchain, &imageCount, nullptr);
-        // max frames in flight = 2
-        records.resize(min(2, imageCount));
+        records.resize(std::min(framesInFlight, imageCount));
         swapchainImages.resize(imageCount);
 
         std::vector<VkImage> images(imageCount);
@@ -319,6 +373,21 @@ VulkanRenderer::VulkanRenderer(const std::function<void(VkInstance instance, VkS
         }
     }
 
+    // headless, frames are rendered into images of their own and never presented
+    if (!surface) {
+        uint32_t width, height;
+        getWindowSize(&width, &height);
+        renderArea.extent = {width, height};
+        swapchainImageFormat = VK_FORMAT_B8G8R8A8_SRGB;
+        records.resize(framesInFlight);
+        for (uint32_t i = 0; i < framesInFlight; i++) {
+            const VulkanImage target = createImage(*this, width, height, swapchainImageFormat,
+                                                   VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                                                   VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+            swapchainImages.push_back({target.image, target.view});
+        }
+    }
+
     // Command Pool
     {
         VkCommandPoolCreateInfo createInfo = {
@@ -377,6 +446,20 @@ VulkanRenderer::~VulkanRenderer() {
     for (const auto& record : records) {
         vkWaitForFences(device, 1, &record.inFlightFence, VK_TRUE, UINT64_MAX);
     }
+    for (auto& record : records) {
+        destroy(record.destructions);
+        for (auto handle : record.uploadWaiters) {
+            handle.destroy();
+        }
+    }
+    destroy(pendingDestructions);
+    for (auto handle : pendingUploadWaiters) {
+        handle.destroy();
+    }
+    for (const auto& upload : pendingUploads) {
+        vkDestroyBuffer(device, upload.staging, nullptr);
+        memoryPool.free(device, upload.stagingMemory);
+    }
 
     while (!resourceStack.empty()) {
         auto freeFunc = resourceStack.top();
@@ -385,28 +468,187 @@ VulkanRenderer::~VulkanRenderer() {
     }
 }
 
-void VulkanRenderer::nextFrame(const std::forward_list<std::function<void(VkCommandBuffer)>>& renderingList) {
+void VulkanRenderer::sampleLatency(Record& record) {
+    const float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() -
+                                                              *record.inputTime).count();
+    latency.averageMs += (ms - latency.averageMs) / static_cast<float>(++latency.count);
+    latency.maxMs = std::max(latency.maxMs, ms);
+    record.inputTime.reset();
+}
+
+void VulkanRenderer::waitForFrame() {
+    if (frameWaited) {
+        return;
+    }
+    Record& record = records[currentFrame];
+    vkWaitForFences(device, 1, &record.inFlightFence, VK_TRUE, UINT64_MAX);
+    vkResetFences(device, 1, &record.inFlightFence);
+    completedFrames = std::max(completedFrames, record.frameNumber);
+    if (record.inputTime) {
+        sampleLatency(record);
+    }
+    destroy(record.destructions);
+    finishedUploadWaiters.swap(record.uploadWaiters);
+    // other frames may have finished meanwhile, the sooner they are seen the closer the sample
+    for (auto& other : records) {
+        if ((other.inputTime || !other.destructions.empty() || !other.uploadWaiters.empty()) &&
+            vkGetFenceStatus(device, other.inFlightFence) == VK_SUCCESS) {
+            completedFrames = std::max(completedFrames, other.frameNumber);
+            if (other.inputTime) {
+                sampleLatency(other);
+            }
+            destroy(other.destructions);
+            finishedUploadWaiters.insert(finishedUploadWaiters.end(), other.uploadWaiters.begin(),
+                                         other.uploadWaiters.end());
+            other.uploadWaiters.clear();
+        }
+    }
+    frameWaited = true;
+    // resumed last, the tasks may queue uploads for this frame
+    for (auto handle : finishedUploadWaiters) {
+        handle.resume();
+    }
+    finishedUploadWaiters.clear();
+}
+
+void VulkanRenderer::markInput(std::chrono::steady_clock::time_point time) {
+    if (!pendingInputTime || time < *pendingInputTime) {
+        pendingInputTime = time;
+    }
+}
+
+FrameLatency VulkanRenderer::takeLatency() {
+    return std::exchange(latency, {});
+}
+
+void VulkanRenderer::destroyLater(const DeferredDestruction& destruction) {
+    pendingDestructions.push_back(destruction);
+}
+
+void VulkanRenderer::uploadLater(const ImageUpload& upload) {
+    pendingUploads.push_back(upload);
+}
+
+void VulkanRenderer::recordUploads(VkCommandBuffer commandBuffer) {
+    if (pendingUploads.empty()) {
+        return;
+    }
+    uploadBarriers.clear();
+    for (const auto& upload : pendingUploads) {
+        uploadBarriers.push_back({
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .srcAccessMask = 0,
+                .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .oldLayout = upload.oldLayout,
+                .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = upload.image,
+                .subresourceRange = {
+                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                        .baseMipLevel = 0,
+                        .levelCount = 1,
+                        .baseArrayLayer = 0,
+                        .layerCount = 1,
+                },
+        });
+    }
+    // earlier frames may still sample the images
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+                         static_cast<uint32_t>(uploadBarriers.size()), uploadBarriers.data());
+
+    for (const auto& upload : pendingUploads) {
+        VkBufferImageCopy region{
+                .bufferOffset = 0,
+                .bufferRowLength = 0,
+                .bufferImageHeight = 0,
+                .imageSubresource = {
+                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                        .mipLevel = 0,
+                        .baseArrayLayer = 0,
+                        .layerCount = 1,
+                },
+                .imageOffset = upload.offset,
+                .imageExtent = upload.extent,
+        };
+        vkCmdCopyBufferToImage(commandBuffer, upload.staging, upload.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
+                               &region);
+
+        DeferredDestruction buffer{.type = DeferredDestruction::Type::Buffer};
+        buffer.buffer = upload.staging;
+        destroyLater(buffer);
+        DeferredDestruction memory{.type = DeferredDestruction::Type::Allocation};
+        memory.allocation = upload.stagingMemory;
+        destroyLater(memory);
+    }
+
+    for (auto& barrier : uploadBarriers) {
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr,
+                         0, nullptr, static_cast<uint32_t>(uploadBarriers.size()), uploadBarriers.data());
+    pendingUploads.clear();
+}
+
+void VulkanRenderer::destroy(std::vector<DeferredDestruction>& destructions) {
+    for (const auto& destruction : destructions) {
+        switch (destruction.type) {
+            case DeferredDestruction::Type::Buffer:
+                vkDestroyBuffer(device, destruction.buffer, nullptr);
+                break;
+            case DeferredDestruction::Type::Image:
+                vkDestroyImage(device, destruction.image, nullptr);
+                break;
+            case DeferredDestruction::Type::ImageView:
+                vkDestroyImageView(device, destruction.imageView, nullptr);
+                break;
+            case DeferredDestruction::Type::Sampler:
+                vkDestroySampler(device, destruction.sampler, nullptr);
+                break;
+            case DeferredDestruction::Type::Allocation:
+                memoryPool.free(device, destruction.allocation);
+                break;
+        }
+    }
+    // keeps the capacity for the frames to come
+    destructions.clear();
+}
+
+void VulkanRenderer::nextFrame(const std::forward_list<std::function<void(VkCommandBuffer)>>& renderingList,
+                               const std::forward_list<std::function<void(VkCommandBuffer)>>& preRenderingList) {
+    waitForFrame();
+    frameWaited = false;
     auto &[
             commandBuffer,
             inFlightFence,
             imageAvailableSemaphore,
-            renderFinishedSemaphore
+            renderFinishedSemaphore,
+            frameNumber,
+            inputTime,
+            destructions,
+            uploadWaiters
     ] = records[currentFrame];
 
-    vkWaitForFences(device, 1, &inFlightFence, VK_TRUE, UINT64_MAX);
-    vkResetFences(device, 1, &inFlightFence);
-
-    uint32_t imageIndex;
-    VkResult result = vkAcquireNextImageKHR(device, swapchain, UINT64_MAX,
-                                            imageAvailableSemaphore, VK_NULL_HANDLE,
-                                            &imageIndex);
-    auto &[swapchainImage, swapchainImageView] = swapchainImages[imageIndex];
-
-    if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-        throw std::runtime_error("OUT OF DATE");
-    } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
-        throw std::runtime_error("failed to acquire swap chain swapchainImage!");
+    // headless renderers have an image per record
+    uint32_t imageIndex = currentFrame;
+    if (surface) {
+        VkResult result = vkAcquireNextImageKHR(device, swapchain, UINT64_MAX,
+                                                imageAvailableSemaphore, VK_NULL_HANDLE,
+                                                &imageIndex);
+        if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+            throw std::runtime_error("OUT OF DATE");
+        } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+            throw std::runtime_error("failed to acquire swap chain swapchainImage!");
+        } else if (result == VK_SUBOPTIMAL_KHR) {
+            suboptimalFrames++;
+        }
     }
+    auto &[swapchainImage, swapchainImageView] = swapchainImages[imageIndex];
 
     vkResetCommandBuffer(commandBuffer, 0);
     VkCommandBufferBeginInfo beginInfo {
@@ -415,6 +657,11 @@ void VulkanRenderer::nextFrame(const std::forward_list<std::function<void(VkComm
     };
     vkBeginCommandBuffer(commandBuffer, &beginInfo);
 
+    recordUploads(commandBuffer);
+    for (const auto& queue : preRenderingList) {
+        queue(commandBuffer);
+    }
+
     VkImageMemoryBarrier imageMemoryBarrier {
             .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
             .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
@@ -460,18 +707,7 @@ void VulkanRenderer::nextFrame(const std::forward_list<std::function<void(VkComm
             .pColorAttachments=&colorAttachment,
     };
 
-    VkViewport viewport{
-            .width=static_cast<float>(renderArea.extent.width),
-            .height=static_cast<float>(renderArea.extent.height),
-            .minDepth=0.0f,
-            .maxDepth=1.0f,
-    };
-    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
-
-    VkRect2D scissor{
-            .extent=renderArea.extent
-    };
-    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    setViewport(commandBuffer, renderArea);
 
     vkCmdBeginRendering(commandBuffer, &renderingInfo);
     for (const auto& queue : renderingList) {
@@ -483,7 +719,7 @@ void VulkanRenderer::nextFrame(const std::forward_list<std::function<void(VkComm
             .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
             .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
             .oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-            .newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+            .newLayout = surface ? VK_IMAGE_LAYOUT_PRESENT_SRC_KHR : VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
             .image = swapchainImage,
             .subresourceRange = {
                     .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
@@ -513,31 +749,38 @@ void VulkanRenderer::nextFrame(const std::forward_list<std::function<void(VkComm
     VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
     VkSubmitInfo submitInfo = {
             .sType=VK_STRUCTURE_TYPE_SUBMIT_INFO,
-            .waitSemaphoreCount = 1,
+            .waitSemaphoreCount = surface ? 1u : 0u,
             .pWaitSemaphores = &imageAvailableSemaphore,
             .pWaitDstStageMask = waitStages,
             .commandBufferCount = 1,
             .pCommandBuffers = &commandBuffer,
-            .signalSemaphoreCount = 1,
+            .signalSemaphoreCount = surface ? 1u : 0u,
             .pSignalSemaphores = &renderFinishedSemaphore
     };
     if (vkQueueSubmit(graphicsQueue.queue, 1, &submitInfo, inFlightFence) != VK_SUCCESS) {
         throw std::runtime_error("failed to submit draw command buffer!");
     }
-
-    VkPresentInfoKHR presentInfo = {
-            .sType=VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
-            .waitSemaphoreCount = 1,
-            .pWaitSemaphores = &renderFinishedSemaphore,
-            .swapchainCount = 1,
-            .pSwapchains = &swapchain,
-            .pImageIndices = &imageIndex
-    };
-    result = vkQueuePresentKHR(surfaceQueue.queue, &presentInfo);
-    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
-        throw std::runtime_error("out of date 2");
-    } else if (result != VK_SUCCESS) {
-        throw std::runtime_error("failed to present swap chain swapchainImage!");
+    frameNumber = ++submittedFrames;
+    inputTime = std::exchange(pendingInputTime, std::nullopt);
+    // emptied when the record was waited for, the swap hands its capacity to the next frame
+    destructions.swap(pendingDestructions);
+    uploadWaiters.swap(pendingUploadWaiters);
+
+    if (surface) {
+        VkPresentInfoKHR presentInfo = {
+                .sType=VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+                .waitSemaphoreCount = 1,
+                .pWaitSemaphores = &renderFinishedSemaphore,
+                .swapchainCount = 1,
+                .pSwapchains = &swapchain,
+                .pImageIndices = &imageIndex
+        };
+        VkResult result = vkQueuePresentKHR(surfaceQueue.queue, &presentInfo);
+        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+            throw std::runtime_error("out of date 2");
+        } else if (result != VK_SUCCESS) {
+            throw std::runtime_error("failed to present swap chain swapchainImage!");
+        }
     }
 
     currentFrame = (currentFrame + 1) % static_cast<int>(records.size());
@@ -14,8 +14,64 @@
 #include <stack>
 #include <optional>
 #include <forward_list>
+#include <chrono>
+#include <coroutine>
 
 #include "debug_messenger.h"
+#include "VulkanMemoryPool.h"
+
+/**
+ * How far the CPU may record ahead of the GPU. Every per-frame resource is sized by the frames in flight.
+ */
+enum class LatencyMode {
+    LowLatency, // 1 frame in flight, input is sampled after the previous frame has finished
+    Balanced, // 2 frames
+    Throughput, // 3 frames, the GPU does not wait for the CPU to record
+};
+
+// input to finished frame, since the last takeLatency()
+struct FrameLatency {
+    uint32_t count = 0;
+    float averageMs = 0;
+    float maxMs = 0;
+};
+
+/**
+ * A Vulkan object freed once the frames that may use it have finished. Plain data, so queuing one allocates
+ * nothing once the queues have grown.
+ */
+struct DeferredDestruction {
+    enum class Type : uint8_t {
+        Buffer,
+        Image,
+        ImageView,
+        Sampler,
+        Allocation, // of the renderer's memory pool
+    };
+
+    Type type;
+    union {
+        VkBuffer buffer;
+        VkImage image;
+        VkImageView imageView;
+        VkSampler sampler;
+        MemoryAllocation allocation;
+    };
+};
+
+/**
+ * A copy from a staging buffer into an image, recorded at the start of the next frame before anything of the frame
+ * may read the image. The image is left in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, and the staging buffer and its
+ * memory are freed once the frame has finished.
+ */
+struct ImageUpload {
+    VkBuffer staging;
+    MemoryAllocation stagingMemory;
+    VkImage image;
+    VkImageLayout oldLayout; // VK_IMAGE_LAYOUT_UNDEFINED discards the previous contents
+    VkOffset3D offset;
+    VkExtent3D extent;
+};
 
 class VulkanRenderer {
 private:
@@ -44,9 +100,23 @@ public:
         VkFence inFlightFence;
         VkSemaphore imageAvailableSemaphore;
         VkSemaphore renderFinishedSemaphore;
+        uint64_t frameNumber = 0; // last frame submitted with this record
+        std::optional<std::chrono::steady_clock::time_point> inputTime; // oldest input the frame shows
+        std::vector<DeferredDestruction> destructions; // freed once the frame has finished
+        std::vector<std::coroutine_handle<>> uploadWaiters; // resumed once the frame has finished
     };
 
+    LatencyMode latencyMode;
     int currentFrame = 0;
+    // Frames are numbered from 1. Every frame up to completedFrames has finished on the GPU.
+    uint64_t submittedFrames = 0;
+    uint64_t completedFrames = 0;
+    // acquires that found the swapchain no longer matching the surface exactly
+    uint64_t suboptimalFrames = 0;
+    // device memory of buffers and images made by VulkanUtils
+    VkDeviceSize allocatedMemory = 0;
+    // images and staging buffers, VulkanUtils allocates them here
+    VulkanMemoryPool memoryPool{allocatedMemory};
     std::vector<Record> records;
     std::vector<SwapchainImage> swapchainImages;
 
@@ -59,13 +129,96 @@ public:
     VkDevice device{};
     VkSurfaceKHR surface{};
 
+    /**
+     * @param createSurface empty renders headless, into images of the window size that are never presented
+     */
     explicit VulkanRenderer(
             const std::function<void(VkInstance instance, VkSurfaceKHR* surface)>& createSurface,
-            const std::function<void(uint32_t* width, uint32_t* height)>& getWindowSize
+            const std::function<void(uint32_t* width, uint32_t* height)>& getWindowSize,
+            LatencyMode latencyMode = LatencyMode::Balanced
             );
     ~VulkanRenderer();
 
-    void nextFrame(const std::forward_list<std::function<void(VkCommandBuffer)>>& renderingList);
+    /**
+     * @return records, and so per-frame resources, cycled through. Fewer than the latency mode asks for when
+     * the swapchain has fewer images.
+     */
+    uint32_t getFramesInFlight() const {
+        return static_cast<uint32_t>(records.size());
+    }
+
+    /**
+     * Blocks until the current record's previous frame has finished. nextFrame calls it too; calling it before
+     * sampling input keeps the wait out of the input to screen latency.
+     */
+    void waitForFrame();
+
+    /**
+     * The next frame shows input that arrived at this time. Of several calls before a frame the oldest counts.
+     */
+    void markInput(std::chrono::steady_clock::time_point time);
+
+    /**
+     * Latency is measured until the renderer sees the frame's fence signaled, which comes right before
+     * presentation, so it may be late by up to one frame when the CPU is the bottleneck.
+     */
+    FrameLatency takeLatency();
+
+    /**
+     * Frees the object once the frames in flight, including the one being recorded, have finished, without
+     * waiting for the device. Objects queued together are freed in queue order.
+     */
+    void destroyLater(const DeferredDestruction& destruction);
+
+    /**
+     * Records the copy into the next frame. All copies of a frame share its command buffer and its barriers, so
+     * uploading does not wait for the device.
+     */
+    void uploadLater(const ImageUpload& upload);
+
+    struct UploadAwaiter {
+        std::vector<std::coroutine_handle<>>* waiters;
+
+        bool await_ready() noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            waiters->push_back(handle);
+        }
+
+        void await_resume() noexcept {
+        }
+    };
+
+    /**
+     * co_await resumes the task once the frame that records the uploads queued so far has finished on the GPU,
+     * from waitForFrame. Await on the thread that renders. Tasks still waiting are destroyed with the renderer.
+     */
+    UploadAwaiter uploadsFinished() {
+        return {&pendingUploadWaiters};
+    }
+
+    /**
+     * @param renderingList commands recorded inside the frame's rendering pass
+     * @param preRenderingList commands recorded before the pass begins, e.g. compute dispatches
+     */
+    void nextFrame(const std::forward_list<std::function<void(VkCommandBuffer)>>& renderingList,
+                   const std::forward_list<std::function<void(VkCommandBuffer)>>& preRenderingList = {});
+
+private:
+    bool frameWaited = false;
+    std::optional<std::chrono::steady_clock::time_point> pendingInputTime;
+    std::vector<DeferredDestruction> pendingDestructions; // of the frame being recorded
+    std::vector<ImageUpload> pendingUploads; // for the next frame
+    std::vector<std::coroutine_handle<>> pendingUploadWaiters; // of the next frame's uploads
+    std::vector<std::coroutine_handle<>> finishedUploadWaiters;
+    std::vector<VkImageMemoryBarrier> uploadBarriers;
+    FrameLatency latency;
+
+    void sampleLatency(Record& record);
+    void destroy(std::vector<DeferredDestruction>& destructions);
+    void recordUploads(VkCommandBuffer commandBuffer);
 };
 
 
@@ -0,0 +1,261 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "VulkanTextRenderer.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <cstddef>
+
+struct TextPushConstants {
+    glm::mat4 viewMatrix;
+    glm::vec4 pixelSize; // vec2, one pixel in vulkan units
+};
+
+VulkanTextRenderer::VulkanTextRenderer(VulkanRenderer &renderer, GlyphAtlas &atlas, uint32_t maxGlyphs)
+        : renderer(&renderer),
+          atlas(&atlas),
+          maxGlyphs(maxGlyphs) {
+    VkDevice device = renderer.device;
+
+    // Atlas image, uploaded whole once and then by dirty rows
+    VulkanImage image = createImage(renderer, GlyphAtlas::ATLAS_SIZE, GlyphAtlas::ATLAS_SIZE, VK_FORMAT_R8_UNORM,
+                                    VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+    atlasImage = image.image;
+    atlas.takeDirtyRows();
+    uploadImage(renderer, atlasImage, VK_IMAGE_LAYOUT_UNDEFINED, atlas.getPixels().data(), atlas.getPixels().size(),
+                {0, 0, 0}, {GlyphAtlas::ATLAS_SIZE, GlyphAtlas::ATLAS_SIZE, 1});
+
+    VkSampler sampler;
+    {
+        VkSamplerCreateInfo samplerInfo{
+                .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+                .magFilter = VK_FILTER_LINEAR,
+                .minFilter = VK_FILTER_LINEAR,
+                .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+                .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                .anisotropyEnable = VK_FALSE,
+                .compareEnable = VK_FALSE,
+                .minLod = 0,
+                .maxLod = 0,
+                .unnormalizedCoordinates = VK_FALSE,
+        };
+        if (vkCreateSampler(device, &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create texture sampler!");
+        }
+        renderer.resourceStack.emplace([=]() {
+            vkDestroySampler(device, sampler, nullptr);
+        });
+    }
+
+    // Per-frame instance buffers
+    for (size_t i = 0; i < renderer.getFramesInFlight(); i++) {
+        instanceBuffers.push_back(createBuffer(renderer, maxGlyphs * sizeof(GlyphInstance),
+                                               VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                               VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+    }
+    instanceBufferVersions.resize(renderer.getFramesInFlight(), version);
+
+    // Descriptor set layout
+    VkDescriptorSetLayout descriptorSetLayout;
+    {
+        VkDescriptorSetLayoutBinding binding{
+                .binding = 0,
+                .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+        };
+        VkDescriptorSetLayoutCreateInfo layoutInfo{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+                .bindingCount = 1,
+                .pBindings = &binding,
+        };
+        if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor set layout!");
+        }
+        renderer.resourceStack.emplace([=]() {
+            vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+        });
+    }
+
+    // Descriptor set
+    {
+        VkDescriptorPoolSize poolSize{
+                .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .descriptorCount = 1,
+        };
+        VkDescriptorPoolCreateInfo poolInfo{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+                .maxSets = 1,
+                .poolSizeCount = 1,
+                .pPoolSizes = &poolSize,
+        };
+        VkDescriptorPool descriptorPool;
+        if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor pool!");
+        }
+        renderer.resourceStack.emplace([=]() {
+            vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+        });
+
+        VkDescriptorSetAllocateInfo allocInfo{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+                .descriptorPool = descriptorPool,
+                .descriptorSetCount = 1,
+                .pSetLayouts = &descriptorSetLayout,
+        };
+        if (vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate descriptor sets!");
+        }
+
+        VkDescriptorImageInfo imageInfo{
+                .sampler = sampler,
+                .imageView = image.view,
+                .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        };
+        VkWriteDescriptorSet write{
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = descriptorSet,
+                .dstBinding = 0,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .pImageInfo = &imageInfo,
+        };
+        vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+    }
+
+    // Pipeline layout
+    {
+        VkPushConstantRange range{
+                .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+                .offset = 0,
+                .size = sizeof(TextPushConstants)
+        };
+        VkPipelineLayoutCreateInfo createInfo{
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+                .setLayoutCount = 1,
+                .pSetLayouts = &descriptorSetLayout,
+                .pushConstantRangeCount = 1,
+                .pPushConstantRanges = &range,
+        };
+        if (vkCreatePipelineLayout(device, &createInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+        renderer.resourceStack.emplace([=, layout = pipelineLayout]() {
+            vkDestroyPipelineLayout(device, layout, nullptr);
+        });
+    }
+
+    pipeline = createGraphicsPipeline(renderer, {
+            .vertexShaderPath = "../shaders/text_vert.spv",
+            .fragmentShaderPath = "../shaders/text_frag.spv",
+            .layout = pipelineLayout,
+            .bindings = {
+                    VkVertexInputBindingDescription{
+                            .binding = 0,
+                            .stride = sizeof(GlyphInstance),
+                            .inputRate = VK_VERTEX_INPUT_RATE_INSTANCE
+                    },
+            },
+            .attributes = {
+                    VkVertexInputAttributeDescription{
+                            .location = 0,
+                            .binding = 0,
+                            .format = VK_FORMAT_R32G32_SFLOAT,
+                            .offset = offsetof(GlyphInstance, anchor),
+                    },
+                    VkVertexInputAttributeDescription{
+                            .location = 1,
+                            .binding = 0,
+                            .format = VK_FORMAT_R32G32_SFLOAT,
+                            .offset = offsetof(GlyphInstance, offset),
+                    },
+                    VkVertexInputAttributeDescription{
+                            .location = 2,
+                            .binding = 0,
+                            .format = VK_FORMAT_R32G32_SFLOAT,
+                            .offset = offsetof(GlyphInstance, size),
+                    },
+                    VkVertexInputAttributeDescription{
+                            .location = 3,
+                            .binding = 0,
+                            .format = VK_FORMAT_R32_UINT,
+                            .offset = offsetof(GlyphInstance, color),
+                    },
+                    VkVertexInputAttributeDescription{
+                            .location = 4,
+                            .binding = 0,
+                            .format = VK_FORMAT_R32G32B32A32_SFLOAT,
+                            .offset = offsetof(GlyphInstance, uv),
+                    },
+            },
+            .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP,
+    });
+}
+
+void VulkanTextRenderer::uploadAtlas() {
+    auto [begin, end] = atlas->takeDirtyRows();
+    if (begin == end) {
+        return;
+    }
+    // rows are whole, so the region is contiguous in the atlas pixels
+    const uint8_t *data = atlas->getPixels().data() + static_cast<size_t>(begin) * GlyphAtlas::ATLAS_SIZE;
+    uploadImage(*renderer, atlasImage, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, data,
+                static_cast<VkDeviceSize>(end - begin) * GlyphAtlas::ATLAS_SIZE,
+                {0, static_cast<int32_t>(begin), 0}, {GlyphAtlas::ATLAS_SIZE, end - begin, 1});
+}
+
+void VulkanTextRenderer::setLabels(const std::vector<TextLabel> &labels) {
+    instances.clear();
+    for (const auto &label: labels) {
+        const ShapedRun &run = atlas->shape(label.text, label.font, label.size);
+        if (instances.size() + run.glyphs.size() > maxGlyphs) {
+            break;
+        }
+        for (const auto &shaped: run.glyphs) {
+            instances.push_back({
+                    .anchor = label.anchor,
+                    .offset = shaped.offset,
+                    .size = shaped.size,
+                    .color = label.color,
+                    .padding = 0,
+                    .uv = atlas->getGlyph(shaped.glyph).uv,
+            });
+        }
+    }
+    version++;
+    uploadAtlas();
+}
+
+void VulkanTextRenderer::render(VkCommandBuffer commandBuffer, View &view) {
+    if (instances.empty()) {
+        return;
+    }
+
+    // the frame's fence has been waited for, so its instance buffer is free to write
+    const VulkanBuffer &instanceBuffer = instanceBuffers[renderer->currentFrame];
+    if (instanceBufferVersions[renderer->currentFrame] != version) {
+        memcpy(instanceBuffer.mapped, instances.data(), instances.size() * sizeof(GlyphInstance));
+        instanceBufferVersions[renderer->currentFrame] = version;
+    }
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0,
+                            nullptr);
+    VkDeviceSize offset = 0;
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &instanceBuffer.buffer, &offset);
+
+    const WindowVec windowSize = view.getWindowSize();
+    TextPushConstants pushConstants{
+            view.getViewMatrix(),
+            glm::vec4(2 / windowSize.x, 2 / windowSize.y, 0, 0)
+    };
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(TextPushConstants),
+                       &pushConstants);
+    vkCmdDraw(commandBuffer, 4, static_cast<uint32_t>(instances.size()), 0, 0);
+}
@@ -0,0 +1,69 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_VULKANTEXTRENDERER_H
+#define MAPENGINE_VULKANTEXTRENDERER_H
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <string>
+
+#include "VulkanRenderer.h"
+#include "VulkanUtils.h"
+#include "GlyphAtlas.h"
+#include "View.h"
+
+struct TextLabel {
+    std::string text;
+    uint32_t font;
+    float size; // pixels
+    MapVec anchor;
+    uint32_t color; // RGBA8, red in the lowest byte
+};
+
+/**
+ * Draws labels from a signed distance field glyph atlas, every glyph of the frame in one instanced draw.
+ *
+ * Glyph instances are anchored in map units with pixel offsets, so they are only rebuilt when the labels
+ * change. Pan, zoom and rotation only change the view matrix.
+ */
+class VulkanTextRenderer {
+    VulkanRenderer *renderer;
+    GlyphAtlas *atlas;
+    uint32_t maxGlyphs;
+
+    VkPipeline pipeline{};
+    VkPipelineLayout pipelineLayout{};
+    VkDescriptorSet descriptorSet{};
+    VkImage atlasImage{};
+
+    std::vector<VulkanBuffer> instanceBuffers; // one per frame in flight
+    std::vector<uint64_t> instanceBufferVersions;
+
+    struct GlyphInstance {
+        glm::vec2 anchor;
+        glm::vec2 offset;
+        glm::vec2 size;
+        uint32_t color;
+        uint32_t padding;
+        glm::vec4 uv;
+    };
+    std::vector<GlyphInstance> instances;
+    uint64_t version = 0;
+
+    void uploadAtlas();
+
+public:
+    VulkanTextRenderer(VulkanRenderer &renderer, GlyphAtlas &atlas, uint32_t maxGlyphs = 65536);
+
+    /**
+     * Replaces the labels drawn from the next frame on. Uploads glyphs rasterized for them.
+     */
+    void setLabels(const std::vector<TextLabel> &labels);
+
+    void render(VkCommandBuffer commandBuffer, View &view);
+};
+
+
+#endif //MAPENGINE_VULKANTEXTRENDERER_H
@@ -0,0 +1,230 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "VulkanTextureTable.h"
+
+#include <stdexcept>
+#include <numeric>
+
+#include <stb_image.h>
+
+VulkanTextureTable::VulkanTextureTable(VulkanRenderer &renderer, uint32_t capacity) : renderer(&renderer) {
+    VkDevice device = renderer.device;
+
+    {
+        VkPhysicalDeviceVulkan12Properties properties12{
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES,
+        };
+        VkPhysicalDeviceProperties2 properties{
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+                .pNext = &properties12,
+        };
+        vkGetPhysicalDeviceProperties2(renderer.physicalDevice, &properties);
+        this->capacity = std::min({capacity, properties12.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                                   properties12.maxDescriptorSetUpdateAfterBindSampledImages});
+    }
+    images.resize(this->capacity);
+    freeSlots.resize(this->capacity);
+    // lowest slots are handed out first
+    std::iota(freeSlots.rbegin(), freeSlots.rend(), 0);
+
+    VkSampler sampler;
+    {
+        VkSamplerCreateInfo samplerInfo{
+                .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+                .magFilter = VK_FILTER_LINEAR,
+                .minFilter = VK_FILTER_LINEAR,
+                .mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+                .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                .mipLodBias = 0,
+                .anisotropyEnable = VK_FALSE,
+                .compareEnable = VK_FALSE,
+                .compareOp = VK_COMPARE_OP_ALWAYS,
+                .minLod = 0,
+                .maxLod = 0,
+                .borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
+                .unnormalizedCoordinates = VK_FALSE,
+        };
+        if (vkCreateSampler(device, &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create texture sampler!");
+        }
+        renderer.resourceStack.emplace([=]() {
+            vkDestroySampler(device, sampler, nullptr);
+        });
+    }
+
+    // Descriptor set layout, binding 0 is the immutable sampler and binding 1 the image array
+    {
+        std::array<VkDescriptorSetLayoutBinding, 2> bindings = {
+                VkDescriptorSetLayoutBinding{
+                        .binding = 0,
+                        .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER,
+                        .descriptorCount = 1,
+                        .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+                        .pImmutableSamplers = &sampler,
+                },
+                VkDescriptorSetLayoutBinding{
+                        .binding = 1,
+                        .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                        .descriptorCount = this->capacity,
+                        .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+                },
+        };
+        std::array<VkDescriptorBindingFlags, 2> bindingFlags = {
+                0,
+                VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT,
+        };
+        VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+                .bindingCount = static_cast<uint32_t>(bindingFlags.size()),
+                .pBindingFlags = bindingFlags.data(),
+        };
+        VkDescriptorSetLayoutCreateInfo layoutInfo{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+                .pNext = &flagsInfo,
+                .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+                .bindingCount = static_cast<uint32_t>(bindings.size()),
+                .pBindings = bindings.data(),
+        };
+        if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor set layout!");
+        }
+        renderer.resourceStack.emplace([=, layout = descriptorSetLayout]() {
+            vkDestroyDescriptorSetLayout(device, layout, nullptr);
+        });
+    }
+
+    // Descriptor set
+    {
+        std::array<VkDescriptorPoolSize, 2> poolSizes = {
+                VkDescriptorPoolSize{
+                        .type = VK_DESCRIPTOR_TYPE_SAMPLER,
+                        .descriptorCount = 1,
+                },
+                VkDescriptorPoolSize{
+                        .type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                        .descriptorCount = this->capacity,
+                },
+        };
+        VkDescriptorPoolCreateInfo poolInfo{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+                .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+                .maxSets = 1,
+                .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+                .pPoolSizes = poolSizes.data(),
+        };
+        VkDescriptorPool descriptorPool;
+        if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor pool!");
+        }
+        renderer.resourceStack.emplace([=]() {
+            vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+        });
+
+        VkDescriptorSetAllocateInfo allocInfo{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+                .descriptorPool = descriptorPool,
+                .descriptorSetCount = 1,
+                .pSetLayouts = &descriptorSetLayout,
+        };
+        if (vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate descriptor sets!");
+        }
+    }
+}
+
+VulkanTextureTable::~VulkanTextureTable() {
+    vkDeviceWaitIdle(renderer->device);
+    for (const auto &image: images) {
+        if (image.image) {
+            destroyImage(*renderer, image);
+        }
+    }
+}
+
+void VulkanTextureTable::recycle() {
+    while (!released.empty() && released.front().frame <= renderer->completedFrames) {
+        freeSlots.push_back(released.front().slot);
+        released.pop_front();
+    }
+}
+
+uint32_t VulkanTextureTable::add(const void *pixels, uint32_t width, uint32_t height) {
+    recycle();
+    if (freeSlots.empty()) {
+        throw std::runtime_error("texture table is full!");
+    }
+    VulkanImage image = createOwnedImage(*renderer, width, height, VK_FORMAT_R8G8B8A8_SRGB,
+                                         VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+    try {
+        uploadImageLater(*renderer, image.image, VK_IMAGE_LAYOUT_UNDEFINED, pixels, VkDeviceSize{width} * height * 4,
+                         {0, 0, 0}, {width, height, 1});
+    } catch (...) {
+        destroyImage(*renderer, image);
+        throw;
+    }
+    return adopt(image);
+}
+
+uint32_t VulkanTextureTable::adopt(const VulkanImage &image) {
+    recycle();
+    if (freeSlots.empty()) {
+        destroyImage(*renderer, image);
+        throw std::runtime_error("texture table is full!");
+    }
+    const uint32_t slot = freeSlots.back();
+    freeSlots.pop_back();
+    images[slot] = image;
+
+    // no pending frame samples a free slot, so it may be written while the set is bound
+    VkDescriptorImageInfo imageInfo{
+            .imageView = image.view,
+            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+    };
+    VkWriteDescriptorSet write{
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = descriptorSet,
+            .dstBinding = 1,
+            .dstArrayElement = slot,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .pImageInfo = &imageInfo,
+    };
+    vkUpdateDescriptorSets(renderer->device, 1, &write, 0, nullptr);
+    return slot;
+}
+
+uint32_t VulkanTextureTable::load(const char *path) {
+    int width, height, channels;
+    stbi_uc *pixels = stbi_load(path, &width, &height, &channels, STBI_rgb_alpha);
+    if (!pixels) {
+        throw std::runtime_error("failed to load texture image!");
+    }
+    try {
+        const uint32_t slot = add(pixels, static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+        stbi_image_free(pixels);
+        return slot;
+    } catch (...) {
+        stbi_image_free(pixels);
+        throw;
+    }
+}
+
+void VulkanTextureTable::release(uint32_t slot) {
+    // the frame being recorded may already reference the slot
+    destroyImageLater(*renderer, images[slot]);
+    images[slot] = {};
+    released.push_back({slot, renderer->submittedFrames + 1});
+}
+
+VkDescriptorSetLayout VulkanTextureTable::getDescriptorSetLayout() const {
+    return descriptorSetLayout;
+}
+
+void VulkanTextureTable::bind(VkCommandBuffer commandBuffer, VkPipelineLayout layout, uint32_t set) const {
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, set, 1, &descriptorSet, 0,
+                            nullptr);
+}
@@ -0,0 +1,86 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_VULKANTEXTURETABLE_H
+#define MAPENGINE_VULKANTEXTURETABLE_H
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <deque>
+
+#include "VulkanRenderer.h"
+#include "VulkanUtils.h"
+
+/**
+ * Bindless textures. One descriptor set holds a sampler and a large partially bound array of sampled images,
+ * and shaders pick the texture with a slot index from their instance data.
+ *
+ * Slots are written with update-after-bind, so adding a texture needs no new descriptor set and no rebind.
+ * A released slot keeps its image, and stays unused, until every frame that may still sample it has finished.
+ */
+class VulkanTextureTable {
+    struct Released {
+        uint32_t slot;
+        uint64_t frame; // last frame that may sample the slot
+    };
+
+    VulkanRenderer *renderer;
+    uint32_t capacity;
+    VkDescriptorSetLayout descriptorSetLayout{};
+    VkDescriptorSet descriptorSet{};
+
+    std::vector<VulkanImage> images; // by slot
+    std::vector<uint32_t> freeSlots;
+    std::deque<Released> released; // in frame order
+
+    void recycle();
+
+public:
+    /**
+     * @param capacity slots, clamped to the device's update-after-bind limits
+     */
+    explicit VulkanTextureTable(VulkanRenderer &renderer, uint32_t capacity = 4096);
+    ~VulkanTextureTable();
+
+    VulkanTextureTable(const VulkanTextureTable &) = delete;
+    VulkanTextureTable &operator=(const VulkanTextureTable &) = delete;
+
+    /**
+     * Uploads RGBA8 sRGB pixels in the next frame, before it may sample the slot.
+     *
+     * @return slot of the texture
+     */
+    uint32_t add(const void *pixels, uint32_t width, uint32_t height);
+
+    /**
+     * Takes over an image made with createOwnedImage. It must be in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+     * whenever a frame samples it.
+     *
+     * @return slot of the texture
+     */
+    uint32_t adopt(const VulkanImage &image);
+
+    /**
+     * Loads an image file with stb_image.
+     *
+     * @return slot of the texture
+     */
+    uint32_t load(const char *path);
+
+    /**
+     * Frees the slot once the frames in flight, including the one being recorded, are done with it.
+     */
+    void release(uint32_t slot);
+
+    uint32_t getCapacity() const {
+        return capacity;
+    }
+
+    VkDescriptorSetLayout getDescriptorSetLayout() const;
+
+    void bind(VkCommandBuffer commandBuffer, VkPipelineLayout layout, uint32_t set) const;
+};
+
+
+#endif //MAPENGINE_VULKANTEXTURETABLE_H
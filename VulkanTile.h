@@ -6,34 +6,141 @@
 #define MAPENGINE_VULKANTILE_H
 
 #include "VulkanRenderer.h"
+#include "VulkanUtils.h"
+#include "VulkanTextureTable.h"
+#include "View.h"
 
 #include <glm/glm.hpp>
 #include <vulkan/vulkan.h>
+#include <array>
 #include <stdexcept>
-#include <fstream>
+#include <unordered_map>
+#include <vector>
 
-#include <stb_image.h>
+// raster layers a tile draw blends, the tile's own texture and its overlays
+static const uint32_t MAX_RASTER_LAYERS = 4;
+// overlay slot of a tile the layer has no texture for
+static const uint32_t NO_TEXTURE = UINT32_MAX;
 
-static const long MAX_FRAMES_IN_FLIGHT = 2;
+enum class RasterBlendMode : uint32_t {
+    Normal,
+    Multiply,
+    Screen,
+    Overlay,
+};
 
-class VulkanTile {
-    // TODO: optimoi niin, että vain yksi instanssi koko systeemissä
-    VkPipeline graphicsPipeline{};
-    VkPipelineLayout graphicsPipelineLayout{};
-    VkBuffer vertexBuffer{};
+// how the texture of a tile maps onto it
+enum class TileProjection : uint32_t {
+    WebMercator, // the map's own grid, one texture per tile
+    Geodetic, // EPSG:4326 tiles of GeodeticGrid, reprojected per fragment, one per texture slot of a tile
+};
+
+struct RasterLayerStyle {
+    float opacity = 1;
+    RasterBlendMode blend = RasterBlendMode::Normal;
+};
 
-    VkImageView textureImageView;
-    VkSampler textureSampler;
-    VkImage textureImage;
-    VkDeviceMemory textureImageMemory;
+/**
+ * Raster tiles, culled on the GPU and drawn with one indirect draw. Each tile may bring overlays of other raster
+ * layers of the same grid, which the fragment shader blends over its texture in the same draw.
+ *
+ * Tiles of another projection are drawn into the map tiles they cover, the fragment shader finds where each
+ * fragment lies in them. Their textures take every slot of a tile, which then has no overlays.
+ */
+class VulkanTile {
+    VulkanBuffer vertexBuffer;
 
     VulkanRenderer* renderer;
-    VkDescriptorSet descriptorSets[MAX_FRAMES_IN_FLIGHT];
+    VulkanTextureTable* textures;
+
+    // GPU-driven path, candidates are per frame in flight and the cull output per frame and view
+    uint32_t maxTiles;
+    uint32_t maxViews;
+    VkPipeline cullPipeline{};
+    VkPipelineLayout cullPipelineLayout{};
+    VkPipeline instancedPipeline{};
+    VkPipelineLayout instancedPipelineLayout{};
+    std::vector<VkDescriptorSet> cullDescriptorSets;
+    std::vector<VulkanBuffer> candidateBuffers;
+    std::vector<VulkanBuffer> instanceBuffers;
+    std::vector<VulkanBuffer> indirectBuffers;
+    std::vector<uint64_t> candidateBufferVersions;
+
+    struct TileCandidate {
+        glm::vec2 center;
+        float tileSide;
+        uint32_t layer;
+        glm::uvec4 textures;
+        // part of the textures the tile shows, all of them unless they are an ancestor's
+        glm::vec2 textureOffset;
+        float textureScale;
+        uint32_t textureLayer;
+    };
+    std::vector<TileCandidate> candidates;
+    std::unordered_map<TileKey, uint32_t> candidateIndices;
+    std::vector<TileVec> shownTiles;
+    // shown tiles that are not candidates, drawn from their nearest ancestor among the candidates
+    std::vector<TileCandidate> fallbacks;
+    std::vector<TileKey> fallbackKeys;
+    uint64_t candidatesVersion = 0;
+    std::array<RasterLayerStyle, MAX_RASTER_LAYERS> styles{};
+    TileProjection projection = TileProjection::WebMercator;
+
+    void updateFallbacks();
 
 public:
-    explicit VulkanTile(VulkanRenderer& renderer);
+    struct Candidate {
+        TileVec tile;
+        uint32_t texture; // slot in the texture table
+        // of the layers above, blended in order
+        std::array<uint32_t, MAX_RASTER_LAYERS - 1> overlays{NO_TEXTURE, NO_TEXTURE, NO_TEXTURE};
+    };
+
+    /**
+     * @param textures table the candidates' textures live in
+     * @param maxTiles capacity of the GPU-driven path
+     * @param maxViews views drawn per frame, each culls the shared candidates on its own
+     * @param alphaBlending blends the tiles over what is drawn before them, for overlay layers
+     */
+    VulkanTile(VulkanRenderer& renderer, VulkanTextureTable& textures, uint32_t maxTiles = 16384,
+               uint32_t maxViews = 1, bool alphaBlending = false);
+
+    /**
+     * Tiles the GPU-driven path culls from, e.g. every resident tile. At most maxTiles.
+     */
+    void setCandidates(const std::vector<Candidate>& tiles);
+
+    /**
+     * Tiles the views select this frame, View::getTiles(). Those that are not candidates yet are drawn from their
+     * nearest ancestor among the candidates, magnifying its part of the textures.
+     */
+    void setShownTiles(const std::vector<TileVec>& tiles);
+
+    /**
+     * @param layer 0 for the tiles' own textures, 1 and up for their overlays
+     */
+    void setLayerStyle(uint32_t layer, RasterLayerStyle style);
+
+    /**
+     * @param projection of the textures the candidates bring
+     */
+    void setProjection(TileProjection projection) {
+        this->projection = projection;
+    }
+
+    /**
+     * Selects the candidates and fallbacks the view shows on the GPU, the same tiles as View::getTiles() up to the
+     * view's max layer, and writes the frame's instance buffer and indirect draw. Records outside the rendering
+     * pass.
+     *
+     * @param viewSlot which of the maxViews views this is, its output is kept apart from the others
+     */
+    void cull(VkCommandBuffer commandBuffer, View& view, uint32_t viewSlot = 0);
 
-    void render(VkCommandBuffer commandBuffer, float cx, float cy, float tileSide, const glm::mat4& viewMatrix);
+    /**
+     * Draws the tiles cull() kept with one indirect draw, each sampling its own texture and overlays.
+     */
+    void renderCulled(VkCommandBuffer commandBuffer, View& view, uint32_t viewSlot = 0);
 };
 
 
@@ -0,0 +1,95 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "VulkanTileCache.h"
+#include "GeodeticGrid.h"
+
+#include <utility>
+
+VulkanTileCache::VulkanTileCache(VulkanTextureTable &textures, uint32_t capacity)
+        : textures(&textures), capacity(capacity) {
+    entries.reserve(capacity);
+}
+
+VulkanTileCache::~VulkanTileCache() {
+    for (const auto &[key, entry]: entries) {
+        textures->release(entry.texture);
+    }
+}
+
+bool VulkanTileCache::contains(const TileKey &key) const {
+    return entries.contains(key);
+}
+
+void VulkanTileCache::insert(const TileVec &tile, const TileImage &image) {
+    if (entries.contains(tile.key())) {
+        return;
+    }
+    adopt(tile, textures->add(image.pixels.data(), image.width, image.height));
+}
+
+std::optional<TileKey> VulkanTileCache::adopt(const TileVec &tile, uint32_t texture) {
+    std::optional<TileKey> evictedKey;
+    if (entries.size() >= capacity) {
+        auto evicted = entries.find(uses.back());
+        evictedKey = evicted->first;
+        textures->release(evicted->second.texture);
+        entries.erase(evicted);
+        uses.pop_back();
+    }
+    const TileKey key = tile.key();
+    uses.push_front(key);
+    entries.emplace(key, Entry{tile, texture, uses.begin()});
+    changed = true;
+    return evictedKey;
+}
+
+bool VulkanTileCache::use(const TileKey &key) {
+    auto entry = entries.find(key);
+    stats.count(entry != entries.end());
+    if (entry == entries.end()) {
+        return false;
+    }
+    uses.splice(uses.begin(), uses, entry->second.use);
+    return true;
+}
+
+std::optional<uint32_t> VulkanTileCache::getTexture(const TileKey &key) const {
+    auto entry = entries.find(key);
+    if (entry == entries.end()) {
+        return std::nullopt;
+    }
+    return entry->second.texture;
+}
+
+bool VulkanTileCache::takeChanged() {
+    return std::exchange(changed, false);
+}
+
+std::vector<VulkanTile::Candidate> VulkanTileCache::getCandidates() const {
+    std::vector<VulkanTile::Candidate> candidates;
+    candidates.reserve(entries.size());
+    for (const auto &[key, entry]: entries) {
+        candidates.push_back({entry.tile, entry.texture});
+    }
+    return candidates;
+}
+
+std::vector<VulkanTile::Candidate> VulkanTileCache::getGeodeticCandidates() const {
+    std::unordered_map<TileKey, VulkanTile::Candidate> mapTiles;
+    for (const auto &[key, entry]: entries) {
+        const uint32_t slot = geodeticSlot(key);
+        for (const TileKey &mapTile: mapTilesShowing(key)) {
+            auto candidate = mapTiles.try_emplace(mapTile, VulkanTile::Candidate{
+                    View::tileAt(mapTile.layer, mapTile.row, mapTile.column), NO_TEXTURE}).first;
+            (slot == 0 ? candidate->second.texture : candidate->second.overlays[slot - 1]) = entry.texture;
+        }
+    }
+    std::vector<VulkanTile::Candidate> candidates;
+    candidates.reserve(mapTiles.size());
+    for (const auto &[key, candidate]: mapTiles) {
+        candidates.push_back(candidate);
+    }
+    return candidates;
+}
@@ -0,0 +1,88 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_VULKANTILECACHE_H
+#define MAPENGINE_VULKANTILECACHE_H
+
+#include <list>
+#include <optional>
+#include <unordered_map>
+
+#include "VulkanTextureTable.h"
+#include "VulkanTile.h"
+#include "TileSource.h"
+#include "TileRamCache.h"
+
+/**
+ * Tiles resident on the GPU, each in its own texture table slot. When full, the tile the views have not used
+ * for the longest time is evicted.
+ */
+class VulkanTileCache {
+    struct Entry {
+        TileVec tile;
+        uint32_t texture;
+        std::list<TileKey>::iterator use;
+    };
+
+    VulkanTextureTable *textures;
+    uint32_t capacity;
+    std::unordered_map<TileKey, Entry> entries;
+    std::list<TileKey> uses; // most recently used first
+    bool changed = false;
+
+public:
+    TileTierStats stats;
+
+    /**
+     * @param capacity tiles. The table needs room beyond it for the slots that evicted tiles hold until the
+     * frames in flight finish.
+     */
+    VulkanTileCache(VulkanTextureTable &textures, uint32_t capacity);
+    ~VulkanTileCache();
+
+    VulkanTileCache(const VulkanTileCache &) = delete;
+    VulkanTileCache &operator=(const VulkanTileCache &) = delete;
+
+    bool contains(const TileKey &key) const;
+
+    /**
+     * Uploads the tile, evicting the least recently used one if the cache is full.
+     */
+    void insert(const TileVec &tile, const TileImage &image);
+
+    /**
+     * Takes over a texture table slot holding the tile, which must not be resident yet.
+     *
+     * @return tile evicted to make room
+     */
+    std::optional<TileKey> adopt(const TileVec &tile, uint32_t texture);
+
+    /**
+     * Marks a resident tile as used now, and counts the lookup in stats.
+     *
+     * @return true if the tile is resident
+     */
+    bool use(const TileKey &key);
+
+    /**
+     * @return texture table slot of a resident tile
+     */
+    std::optional<uint32_t> getTexture(const TileKey &key) const;
+
+    /**
+     * @return true if tiles were added or evicted since the last call
+     */
+    bool takeChanged();
+
+    std::vector<VulkanTile::Candidate> getCandidates() const;
+
+    /**
+     * For a cache of EPSG:4326 tiles, see GeodeticGrid.h. Their keys are what matters of the tiles inserted.
+     *
+     * @return map tiles showing the resident tiles, each with theirs in its texture slots
+     */
+    std::vector<VulkanTile::Candidate> getGeodeticCandidates() const;
+};
+
+#endif //MAPENGINE_VULKANTILECACHE_H
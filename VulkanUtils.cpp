@@ -0,0 +1,501 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#include "VulkanUtils.h"
+
+#include <stdexcept>
+#include <fstream>
+#include <cstring>
+
+uint32_t findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties) {
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+        if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("failed to find suitable memory type!");
+}
+
+VkShaderModule createShaderModule(VkDevice device, const char *path) {
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open file!");
+    }
+    auto fileSize = file.tellg();
+    std::vector<char> shaderCode(fileSize);
+    file.seekg(0);
+    file.read(shaderCode.data(), fileSize);
+    file.close();
+
+    VkShaderModuleCreateInfo shaderModuleCreateInfo = {
+            .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+            .codeSize = static_cast<size_t>(fileSize),
+            .pCode = reinterpret_cast<const uint32_t *>(shaderCode.data())
+    };
+    VkShaderModule shaderModule;
+    if (vkCreateShaderModule(device, &shaderModuleCreateInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shader module!");
+    }
+    return shaderModule;
+}
+
+VulkanBuffer createBuffer(VulkanRenderer &renderer, VkDeviceSize size, VkBufferUsageFlags usage,
+                          VkMemoryPropertyFlags properties) {
+    VkDevice device = renderer.device;
+    VulkanBuffer result{.size = size};
+
+    VkBufferCreateInfo createInfo = {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            .flags = 0,
+            .size = size,
+            .usage = usage,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    if (vkCreateBuffer(device, &createInfo, nullptr, &result.buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create buffer");
+    }
+    renderer.resourceStack.emplace([=]() {
+        vkDestroyBuffer(device, result.buffer, nullptr);
+    });
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(device, result.buffer, &memoryRequirements);
+
+    VkMemoryAllocateInfo allocateInfo = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .allocationSize = memoryRequirements.size,
+            .memoryTypeIndex = findMemoryType(renderer.physicalDevice, memoryRequirements.memoryTypeBits, properties)
+    };
+    if (vkAllocateMemory(device, &allocateInfo, nullptr, &result.memory) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate memory");
+    }
+    renderer.allocatedMemory += allocateInfo.allocationSize;
+    renderer.resourceStack.emplace([=, &renderer]() {
+        vkFreeMemory(device, result.memory, nullptr);
+        renderer.allocatedMemory -= allocateInfo.allocationSize;
+    });
+    vkBindBufferMemory(device, result.buffer, result.memory, 0);
+
+    if (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        vkMapMemory(device, result.memory, 0, VK_WHOLE_SIZE, 0, &result.mapped);
+    }
+    return result;
+}
+
+struct StagingBuffer {
+    VkBuffer buffer;
+    MemoryAllocation memory;
+};
+
+static StagingBuffer createStagingBuffer(VulkanRenderer &renderer, const void *data, VkDeviceSize size) {
+    VkDevice device = renderer.device;
+
+    VkBufferCreateInfo createInfo = {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            .size = size,
+            .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    StagingBuffer staging{};
+    if (vkCreateBuffer(device, &createInfo, nullptr, &staging.buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create buffer");
+    }
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(device, staging.buffer, &memoryRequirements);
+    try {
+        staging.memory = renderer.memoryPool.allocate(
+                device, memoryRequirements,
+                findMemoryType(renderer.physicalDevice, memoryRequirements.memoryTypeBits,
+                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
+                true, true);
+    } catch (...) {
+        vkDestroyBuffer(device, staging.buffer, nullptr);
+        throw;
+    }
+    vkBindBufferMemory(device, staging.buffer, staging.memory.memory, staging.memory.offset);
+    memcpy(staging.memory.mapped, data, size);
+    return staging;
+}
+
+static void destroyStagingBuffer(VulkanRenderer &renderer, const StagingBuffer &staging) {
+    vkDestroyBuffer(renderer.device, staging.buffer, nullptr);
+    renderer.memoryPool.free(renderer.device, staging.memory);
+}
+
+void uploadBuffer(VulkanRenderer &renderer, const VulkanBuffer &dst, const void *data, VkDeviceSize size,
+                  VkDeviceSize offset) {
+    StagingBuffer staging = createStagingBuffer(renderer, data, size);
+
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands(renderer);
+    VkBufferCopy copyRegion{
+            .srcOffset = 0,
+            .dstOffset = offset,
+            .size = size,
+    };
+    vkCmdCopyBuffer(commandBuffer, staging.buffer, dst.buffer, 1, &copyRegion);
+    endSingleTimeCommands(renderer, commandBuffer);
+
+    destroyStagingBuffer(renderer, staging);
+}
+
+VulkanImage createOwnedImage(VulkanRenderer &renderer, uint32_t width, uint32_t height, VkFormat format,
+                             VkImageUsageFlags usage) {
+    VkDevice device = renderer.device;
+    VulkanImage result;
+
+    VkImageCreateInfo imageInfo{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .flags = 0,
+            .imageType = VK_IMAGE_TYPE_2D,
+            .format = format,
+            .extent = {
+                    .width = width,
+                    .height = height,
+                    .depth = 1,
+            },
+            .mipLevels = 1,
+            .arrayLayers = 1,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usage = usage,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+    if (vkCreateImage(device, &imageInfo, nullptr, &result.image) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create image!");
+    }
+
+    // suballocated, a dedicated allocation per tile would run into maxMemoryAllocationCount
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device, result.image, &memRequirements);
+    try {
+        result.memory = renderer.memoryPool.allocate(
+                device, memRequirements,
+                findMemoryType(renderer.physicalDevice, memRequirements.memoryTypeBits,
+                               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT), false);
+    } catch (...) {
+        vkDestroyImage(device, result.image, nullptr);
+        throw;
+    }
+    vkBindImageMemory(device, result.image, result.memory.memory, result.memory.offset);
+
+    VkImageViewCreateInfo viewInfo{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .image = result.image,
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = format,
+            .subresourceRange = {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .baseMipLevel = 0,
+                    .levelCount = 1,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+            }
+    };
+    if (vkCreateImageView(device, &viewInfo, nullptr, &result.view) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create image view!");
+    }
+    return result;
+}
+
+void destroyImage(VulkanRenderer &renderer, const VulkanImage &image) {
+    vkDestroyImageView(renderer.device, image.view, nullptr);
+    vkDestroyImage(renderer.device, image.image, nullptr);
+    renderer.memoryPool.free(renderer.device, image.memory);
+}
+
+void destroyImageLater(VulkanRenderer &renderer, const VulkanImage &image) {
+    DeferredDestruction view{.type = DeferredDestruction::Type::ImageView};
+    view.imageView = image.view;
+    renderer.destroyLater(view);
+    DeferredDestruction handle{.type = DeferredDestruction::Type::Image};
+    handle.image = image.image;
+    renderer.destroyLater(handle);
+    DeferredDestruction memory{.type = DeferredDestruction::Type::Allocation};
+    memory.allocation = image.memory;
+    renderer.destroyLater(memory);
+}
+
+VulkanImage createImage(VulkanRenderer &renderer, uint32_t width, uint32_t height, VkFormat format,
+                        VkImageUsageFlags usage) {
+    VulkanImage result = createOwnedImage(renderer, width, height, format, usage);
+    renderer.resourceStack.emplace([&renderer, result]() {
+        destroyImage(renderer, result);
+    });
+    return result;
+}
+
+void uploadImage(VulkanRenderer &renderer, VkImage image, VkImageLayout oldLayout, const void *data,
+                 VkDeviceSize size, VkOffset3D offset, VkExtent3D extent) {
+    StagingBuffer staging = createStagingBuffer(renderer, data, size);
+
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands(renderer);
+    // earlier frames may still sample the image
+    imageBarrier(commandBuffer, image,
+                 oldLayout, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+    VkBufferImageCopy region{
+            .bufferOffset = 0,
+            .bufferRowLength = 0,
+            .bufferImageHeight = 0,
+            .imageSubresource = {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .mipLevel = 0,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+            },
+            .imageOffset = offset,
+            .imageExtent = extent,
+    };
+    vkCmdCopyBufferToImage(commandBuffer, staging.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    imageBarrier(commandBuffer, image,
+                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                 VK_ACCESS_SHADER_READ_BIT);
+    endSingleTimeCommands(renderer, commandBuffer);
+
+    destroyStagingBuffer(renderer, staging);
+}
+
+void uploadImageLater(VulkanRenderer &renderer, VkImage image, VkImageLayout oldLayout, const void *data,
+                      VkDeviceSize size, VkOffset3D offset, VkExtent3D extent) {
+    StagingBuffer staging = createStagingBuffer(renderer, data, size);
+    renderer.uploadLater({staging.buffer, staging.memory, image, oldLayout, offset, extent});
+}
+
+void imageBarrier(VkCommandBuffer commandBuffer, VkImage image,
+                  VkImageLayout oldLayout, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess,
+                  VkImageLayout newLayout, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess) {
+    VkImageMemoryBarrier barrier{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask = srcAccess,
+            .dstAccessMask = dstAccess,
+            .oldLayout = oldLayout,
+            .newLayout = newLayout,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = image,
+            .subresourceRange = {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .baseMipLevel = 0,
+                    .levelCount = 1,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+            }
+    };
+    vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+VkCommandBuffer beginSingleTimeCommands(VulkanRenderer &renderer) {
+    VkCommandBufferAllocateInfo allocInfo{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = renderer.commandPool,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1,
+    };
+    VkCommandBuffer commandBuffer;
+    vkAllocateCommandBuffers(renderer.device, &allocInfo, &commandBuffer);
+
+    VkCommandBufferBeginInfo beginInfo{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    return commandBuffer;
+}
+
+void endSingleTimeCommands(VulkanRenderer &renderer, VkCommandBuffer commandBuffer) {
+    vkEndCommandBuffer(commandBuffer);
+
+    VkSubmitInfo submitInfo{
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .commandBufferCount = 1,
+            .pCommandBuffers = &commandBuffer,
+    };
+    vkQueueSubmit(renderer.graphicsQueue.queue, 1, &submitInfo, VK_NULL_HANDLE);
+    vkQueueWaitIdle(renderer.graphicsQueue.queue);
+
+    vkFreeCommandBuffers(renderer.device, renderer.commandPool, 1, &commandBuffer);
+}
+
+VkPipeline createGraphicsPipeline(VulkanRenderer &renderer, const GraphicsPipelineInfo &info) {
+    VkDevice device = renderer.device;
+    VkShaderModule vertexShaderModule = createShaderModule(device, info.vertexShaderPath);
+    VkShaderModule fragmentShaderModule = createShaderModule(device, info.fragmentShaderPath);
+
+    std::array<VkPipelineShaderStageCreateInfo, 2> stages = {
+            VkPipelineShaderStageCreateInfo{
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                    .stage = VK_SHADER_STAGE_VERTEX_BIT,
+                    .module = vertexShaderModule,
+                    .pName = "main"
+            },
+            VkPipelineShaderStageCreateInfo{
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                    .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+                    .module = fragmentShaderModule,
+                    .pName = "main"
+            },
+    };
+
+    VkPipelineVertexInputStateCreateInfo vertexInputState{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+            .vertexBindingDescriptionCount = static_cast<uint32_t>(info.bindings.size()),
+            .pVertexBindingDescriptions = info.bindings.data(),
+            .vertexAttributeDescriptionCount = static_cast<uint32_t>(info.attributes.size()),
+            .pVertexAttributeDescriptions = info.attributes.data(),
+    };
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+            .topology = info.topology,
+            .primitiveRestartEnable = VK_FALSE
+    };
+
+    VkPipelineViewportStateCreateInfo viewportState{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+            .viewportCount = 1,
+            .scissorCount = 1
+    };
+
+    VkPipelineRasterizationStateCreateInfo rasterizer{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+            .depthClampEnable = VK_FALSE,
+            .rasterizerDiscardEnable = VK_FALSE,
+            .polygonMode = VK_POLYGON_MODE_FILL,
+            .cullMode = VK_CULL_MODE_NONE,
+            .frontFace = VK_FRONT_FACE_CLOCKWISE,
+            .depthBiasEnable = VK_FALSE,
+            .lineWidth = 1.0f,
+    };
+
+    VkPipelineMultisampleStateCreateInfo multisampling{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+            .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+            .sampleShadingEnable = VK_FALSE,
+    };
+
+    VkPipelineColorBlendAttachmentState colorBlendAttachment{
+            .blendEnable = info.alphaBlending ? VK_TRUE : VK_FALSE,
+            .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
+            .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+            .colorBlendOp = VK_BLEND_OP_ADD,
+            .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+            .dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+            .alphaBlendOp = VK_BLEND_OP_ADD,
+            .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT |
+                              VK_COLOR_COMPONENT_A_BIT,
+    };
+    VkPipelineColorBlendStateCreateInfo colorBlending{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+            .logicOpEnable = VK_FALSE,
+            .attachmentCount = 1,
+            .pAttachments = &colorBlendAttachment,
+    };
+
+    std::vector<VkDynamicState> dynamicStates = {
+            VK_DYNAMIC_STATE_VIEWPORT,
+            VK_DYNAMIC_STATE_SCISSOR
+    };
+    VkPipelineDynamicStateCreateInfo dynamicState{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+            .dynamicStateCount = static_cast<uint32_t>(dynamicStates.size()),
+            .pDynamicStates = dynamicStates.data()
+    };
+
+    VkPipelineRenderingCreateInfo renderingCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+            .colorAttachmentCount = 1,
+            .pColorAttachmentFormats = &renderer.swapchainImageFormat,
+    };
+
+    VkGraphicsPipelineCreateInfo graphicsPipelineCreateInfo = {
+            .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+            .pNext = &renderingCreateInfo,
+            .stageCount = static_cast<uint32_t>(stages.size()),
+            .pStages = stages.data(),
+            .pVertexInputState = &vertexInputState,
+            .pInputAssemblyState = &inputAssembly,
+            .pViewportState = &viewportState,
+            .pRasterizationState = &rasterizer,
+            .pMultisampleState = &multisampling,
+            .pColorBlendState = &colorBlending,
+            .pDynamicState = &dynamicState,
+            .layout = info.layout,
+            .renderPass = VK_NULL_HANDLE,
+            .basePipelineHandle = VK_NULL_HANDLE
+    };
+    VkPipeline pipeline;
+    VkResult result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &graphicsPipelineCreateInfo, nullptr,
+                                                &pipeline);
+
+    vkDestroyShaderModule(device, vertexShaderModule, nullptr);
+    vkDestroyShaderModule(device, fragmentShaderModule, nullptr);
+
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create graphics pipeline!");
+    }
+    renderer.resourceStack.emplace([=]() {
+        vkDestroyPipeline(device, pipeline, nullptr);
+    });
+    return pipeline;
+}
+
+VkPipeline createComputePipeline(VulkanRenderer &renderer, const char *shaderPath, VkPipelineLayout layout) {
+    VkDevice device = renderer.device;
+    VkShaderModule shaderModule = createShaderModule(device, shaderPath);
+
+    VkComputePipelineCreateInfo createInfo{
+            .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+            .stage = {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                    .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                    .module = shaderModule,
+                    .pName = "main"
+            },
+            .layout = layout,
+    };
+    VkPipeline pipeline;
+    VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &createInfo, nullptr, &pipeline);
+
+    vkDestroyShaderModule(device, shaderModule, nullptr);
+
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create compute pipeline!");
+    }
+    renderer.resourceStack.emplace([=]() {
+        vkDestroyPipeline(device, pipeline, nullptr);
+    });
+    return pipeline;
+}
+
+void memoryBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess,
+                   VkPipelineStageFlags dstStage, VkAccessFlags dstAccess) {
+    VkMemoryBarrier barrier{
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = srcAccess,
+            .dstAccessMask = dstAccess,
+    };
+    vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void setViewport(VkCommandBuffer commandBuffer, VkRect2D area) {
+    VkViewport viewport{
+            .x=static_cast<float>(area.offset.x),
+            .y=static_cast<float>(area.offset.y),
+            .width=static_cast<float>(area.extent.width),
+            .height=static_cast<float>(area.extent.height),
+            .minDepth=0.0f,
+            .maxDepth=1.0f,
+    };
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    vkCmdSetScissor(commandBuffer, 0, 1, &area);
+}
@@ -0,0 +1,116 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+#ifndef MAPENGINE_VULKANUTILS_H
+#define MAPENGINE_VULKANUTILS_H
+
+#include <vulkan/vulkan.h>
+#include <vector>
+
+#include "VulkanRenderer.h"
+
+struct VulkanBuffer {
+    VkBuffer buffer{};
+    VkDeviceMemory memory{};
+    void *mapped{}; // host visible buffers stay mapped
+    VkDeviceSize size{};
+};
+
+struct VulkanImage {
+    VkImage image{};
+    MemoryAllocation memory{}; // of the renderer's memory pool
+    VkImageView view{};
+};
+
+struct GraphicsPipelineInfo {
+    const char *vertexShaderPath;
+    const char *fragmentShaderPath;
+    VkPipelineLayout layout;
+    std::vector<VkVertexInputBindingDescription> bindings;
+    std::vector<VkVertexInputAttributeDescription> attributes;
+    VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+    bool alphaBlending = true;
+};
+
+uint32_t findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties);
+
+VkShaderModule createShaderModule(VkDevice device, const char *path);
+
+/**
+ * Creates a buffer that lives as long as the renderer.
+ */
+VulkanBuffer createBuffer(VulkanRenderer &renderer, VkDeviceSize size, VkBufferUsageFlags usage,
+                          VkMemoryPropertyFlags properties);
+
+/**
+ * Copies data to a device local buffer through a temporary staging buffer. Blocks until done.
+ */
+void uploadBuffer(VulkanRenderer &renderer, const VulkanBuffer &dst, const void *data, VkDeviceSize size,
+                  VkDeviceSize offset = 0);
+
+/**
+ * Creates a device local 2D image and its view that live as long as the renderer.
+ */
+VulkanImage createImage(VulkanRenderer &renderer, uint32_t width, uint32_t height, VkFormat format,
+                        VkImageUsageFlags usage);
+
+/**
+ * Like createImage, but the caller frees it with destroyImage.
+ */
+VulkanImage createOwnedImage(VulkanRenderer &renderer, uint32_t width, uint32_t height, VkFormat format,
+                             VkImageUsageFlags usage);
+
+void destroyImage(VulkanRenderer &renderer, const VulkanImage &image);
+
+/**
+ * Like destroyImage, once the frames that may use the image have finished.
+ */
+void destroyImageLater(VulkanRenderer &renderer, const VulkanImage &image);
+
+/**
+ * Copies pixels to a region of an image through a temporary staging buffer and leaves the image in
+ * VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL. Blocks until done.
+ *
+ * @param oldLayout VK_IMAGE_LAYOUT_UNDEFINED discards the previous contents
+ */
+void uploadImage(VulkanRenderer &renderer, VkImage image, VkImageLayout oldLayout, const void *data,
+                 VkDeviceSize size, VkOffset3D offset, VkExtent3D extent);
+
+/**
+ * Like uploadImage, but the copy is recorded into the next frame, see VulkanRenderer::uploadLater. Only copies the
+ * pixels to a staging buffer now.
+ */
+void uploadImageLater(VulkanRenderer &renderer, VkImage image, VkImageLayout oldLayout, const void *data,
+                      VkDeviceSize size, VkOffset3D offset, VkExtent3D extent);
+
+void imageBarrier(VkCommandBuffer commandBuffer, VkImage image,
+                  VkImageLayout oldLayout, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess,
+                  VkImageLayout newLayout, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+
+VkCommandBuffer beginSingleTimeCommands(VulkanRenderer &renderer);
+
+void endSingleTimeCommands(VulkanRenderer &renderer, VkCommandBuffer commandBuffer);
+
+/**
+ * Pipeline for VulkanRenderer's dynamic rendering pass. Lives as long as the renderer.
+ */
+VkPipeline createGraphicsPipeline(VulkanRenderer &renderer, const GraphicsPipelineInfo &info);
+
+/**
+ * Lives as long as the renderer.
+ */
+VkPipeline createComputePipeline(VulkanRenderer &renderer, const char *shaderPath, VkPipelineLayout layout);
+
+/**
+ * Sets viewport and scissor to one area of the render target, e.g. to draw a view into its part of the window.
+ */
+void setViewport(VkCommandBuffer commandBuffer, VkRect2D area);
+
+/**
+ * Makes writes of srcStage visible to dstStage, for resources kept in one layout.
+ */
+void memoryBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess,
+                   VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+
+#endif //MAPENGINE_VULKANUTILS_H
@@ -2,87 +2,690 @@
 #define STB_IMAGE_IMPLEMENTATION
 
 #include <GLFW/glfw3.h>
+#include <stb_image.h>
 
 #include <glm/ext/matrix_transform.hpp>
 
 #include <iostream>
 #include <stdexcept>
 #include <chrono>
+#include <cmath>
 #include <forward_list>
+#include <random>
+#include <memory>
+#include <list>
+#include <unordered_map>
+#include <string_view>
+#include <thread>
+#include <algorithm>
 
 #include "VulkanRenderer.h"
 #include "VulkanTile.h"
+#include "VulkanTextureTable.h"
+#include "VulkanTileCache.h"
+#include "TileArchive.h"
+#include "MappedImageSource.h"
+#include "HttpTileSource.h"
+#include "TileLoader.h"
+#include "TileRamCache.h"
+#include "VulkanMarkerLayer.h"
+#include "VulkanPolylineLayer.h"
+#include "VulkanHeatmapLayer.h"
+#include "VulkanHillshadeLayer.h"
+#include "GeodeticGrid.h"
+#include "ThreadPool.h"
+#include "Task.h"
+#include "TaskExecutor.h"
+#include "RTree.h"
+#include "GlyphAtlas.h"
+#include "VulkanTextRenderer.h"
+#include "LabelPlacer.h"
 #include "View.h"
 #include "Input.h"
+#include "Metrics.h"
 
+// decoded tiles uploaded per frame, the rest wait for the next frames
+static const size_t MAX_TILE_UPLOADS_PER_FRAME = 16;
+// uploads the GPU has not finished yet, bounds the staging memory when several frames are in flight
+static const size_t MAX_TILE_UPLOADS_IN_FLIGHT = 32;
+// layers requested from tile servers
+static const uint32_t HTTP_TILE_LAYERS = 20;
+// overview in the bottom right corner, pixels
+static const uint32_t MINIMAP_WIDTH = 384;
+static const uint32_t MINIMAP_HEIGHT = 216;
+static const int32_t MINIMAP_MARGIN = 16;
+// map width the minimap shows, relative to the main view
+static const float MINIMAP_ZOOM_OUT = 16;
+// shaded elevation tiles kept on the GPU, their slots are taken from the imagery
+static const uint32_t HILLSHADE_TILES = 1024;
+// degrees above the horizon
+static const float LIGHT_ALTITUDE = 45;
+// candidates kept without a tile source, the least recently used are dropped first
+static const size_t MAX_RESIDENT_TILES = 4096;
 
-void main_throws() {
-    glfwInit();
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+struct Options {
+    // tile archive made by PyramidBuilder, a PPM image to map directly or a tile server URL template,
+    // nullptr shows ../texture.jpg on every tile
+    const char *tilePath = nullptr;
+    // of the tiles at tilePath, EPSG:4326 ones are reprojected as they are drawn
+    TileProjection tileProjection = TileProjection::WebMercator;
+    // elevation tiles of the same grid, in any form tilePath takes, shaded over the imagery
+    const char *elevationPath = nullptr;
+    ElevationEncoding elevationEncoding = ElevationEncoding::TerrainRgb;
+    LatencyMode latencyMode = LatencyMode::Balanced;
+    // written every second in the Prometheus text format
+    const char *metricsPath = nullptr;
+    // input of the session is recorded here
+    const char *recordPath = nullptr;
+    // recorded session to replay headless instead of opening a window
+    const char *replayPath = nullptr;
+    // replay frames as fast as they render instead of at the recorded pace
+    bool maxSpeed = false;
+    // TrueType font of the labels
+    const char *fontPath = "C:/Windows/Fonts/arial.ttf";
+};
 
-    GLFWwindow *window;
-    window = glfwCreateWindow(1920, 1080, "Vulkan", nullptr, nullptr);
+static void printFrameTimes(std::vector<float> frameTimes) {
+    if (frameTimes.empty()) {
+        return;
+    }
+    std::sort(frameTimes.begin(), frameTimes.end());
+    auto percentile = [&](float p) {
+        return frameTimes[std::min(frameTimes.size() - 1, static_cast<size_t>(p * frameTimes.size()))] * 1000;
+    };
+    float total = 0;
+    for (float t: frameTimes) {
+        total += t;
+    }
+    std::cout << "Replayed " << frameTimes.size() << " frames in " << total << " s, frame time ms: average "
+              << total * 1000 / frameTimes.size() << ", p50 " << percentile(.5f) << ", p95 " << percentile(.95f)
+              << ", p99 " << percentile(.99f) << ", max " << frameTimes.back() * 1000 << std::endl;
+}
+
+static std::unique_ptr<TileSource> openTileSource(const char *path) {
+    if (std::string_view(path).starts_with("http://")) {
+        return std::make_unique<HttpTileSource>(path, HTTP_TILE_LAYERS);
+    } else if (std::string_view(path).ends_with(".ppm")) {
+        return std::make_unique<MappedImageSource>(path);
+    } else {
+        return std::make_unique<TileArchive>(path);
+    }
+}
+
+/**
+ * The last stage of a tile load, started once the tile is inserted into its cache and so queued for upload. It
+ * finishes when the frame recording the upload has, and its staging buffer is freed.
+ */
+static Task<> awaitUpload(VulkanRenderer &renderer, size_t &uploading) {
+    uploading++;
+    co_await renderer.uploadsFinished();
+    uploading--;
+}
 
+void main_throws(const Options &options) {
+    const char *tilePath = options.tilePath;
+    // before the window opens, a missing font fails at once
+    GlyphAtlas atlas;
+    const uint32_t font = atlas.addFont(options.fontPath);
+    ThreadPool pool;
+
+    std::optional<InputRecording> replay;
+    GLFWwindow *window = nullptr;
     int windowWidth, windowHeight;
-    glfwGetWindowSize(window, &windowWidth, &windowHeight);
+    if (options.replayPath) {
+        replay = readInputRecording(options.replayPath);
+        windowWidth = static_cast<int>(replay->windowWidth);
+        windowHeight = static_cast<int>(replay->windowHeight);
+    } else {
+        glfwInit();
+        glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+
+        window = glfwCreateWindow(1920, 1080, "Vulkan", nullptr, nullptr);
+        glfwGetWindowSize(window, &windowWidth, &windowHeight);
+    }
+    std::unique_ptr<InputRecorder> recorder;
+    if (options.recordPath) {
+        recorder = std::make_unique<InputRecorder>(options.recordPath, windowWidth, windowHeight);
+    }
+
     View view(0, 0, 0, 2, static_cast<float>(windowWidth), static_cast<float>(windowHeight));
-    handleInput(window, &view);
-
-    VulkanRenderer renderer([=](VkInstance instance, VkSurfaceKHR *surface) {
-        VkResult result;
-        if ((result = glfwCreateWindowSurface(instance, window, nullptr, surface)) != VK_SUCCESS) {
-            std::stringstream ss;
-            ss << "failed to create window surface! code = ";
-            ss << result;
-            throw std::runtime_error(ss.str());
-        } else {
-            std::cout << "Surface created" << std::endl;
+    // follows the main view, its tiles come from the same loader and cache
+    View minimap(0, 0, 0, 2, MINIMAP_WIDTH, MINIMAP_HEIGHT);
+    std::unique_ptr<RTree> markerIndex;
+    std::vector<TileRequest> tileRequests;
+    std::mt19937 flightRandom(2);
+    // degrees clockwise from the top of the map
+    float lightAzimuth = 315;
+    bool lightChanged = false;
+    bool shadingChanged = false;
+    Input input(window, &view, [&](MapVec position, float radius) {
+        if (auto marker = markerIndex ? markerIndex->pick(position, radius) : std::nullopt) {
+            std::cout << "Marker: " << *marker << std::endl;
+        }
+    }, [&](int key) {
+        // F flies to a random place
+        if (key == GLFW_KEY_F) {
+            std::uniform_real_distribution<float> position(-1, 1);
+            std::uniform_real_distribution<float> zoom(-12, -4);
+            tileRequests = view.flyTo(MapVec(position(flightRandom), position(flightRandom)),
+                                      std::exp2(zoom(flightRandom)), 0, 2);
+        } else if (key == GLFW_KEY_L) {
+            // L turns the light of the terrain shading
+            lightAzimuth = std::fmod(lightAzimuth + 45, 360.0f);
+            lightChanged = true;
+        } else if (key == GLFW_KEY_H) {
+            // H switches between hillshade and slope shading
+            shadingChanged = true;
         }
-    }, [=](uint32_t *w, uint32_t *h) {
-        int intWidth, intHeight;
-        glfwGetWindowSize(window, &intWidth, &intHeight);
-        *w = intWidth;
-        *h = intHeight;
     });
+    input.record(recorder.get());
+
+    std::function<void(VkInstance instance, VkSurfaceKHR *surface)> createSurface;
+    if (window) {
+        createSurface = [=](VkInstance instance, VkSurfaceKHR *surface) {
+            VkResult result;
+            if ((result = glfwCreateWindowSurface(instance, window, nullptr, surface)) != VK_SUCCESS) {
+                std::stringstream ss;
+                ss << "failed to create window surface! code = ";
+                ss << result;
+                throw std::runtime_error(ss.str());
+            } else {
+                std::cout << "Surface created" << std::endl;
+            }
+        };
+    }
+    // the window is not resizable
+    VulkanRenderer renderer(createSurface, [=](uint32_t *w, uint32_t *h) {
+        *w = windowWidth;
+        *h = windowHeight;
+    }, options.latencyMode);
+
+    VulkanTextureTable textures(renderer);
+    VulkanTile tile(renderer, textures, 16384, 2);
+    // fetches wait on the disk or the network, each loader runs them on threads of its own so that the shared
+    // pool stays free, as many as the source keeps busy
+    std::forward_list<ThreadPool> loaderPools;
+    std::forward_list<TaskExecutor> loaderExecutors;
+    auto createLoader = [&](TileSource &source, TileRamCache &ramCache) {
+        const unsigned loads = source.getConcurrency();
+        loaderPools.emplace_front(loads);
+        loaderExecutors.emplace_front(loaderPools.front());
+        return std::make_unique<TileLoader>(loaderExecutors.front(), source, &ramCache, loads);
+    };
+    // of both loaders
+    size_t uploading = 0;
+    auto uploadsAllowed = [&]() {
+        return std::min(MAX_TILE_UPLOADS_PER_FRAME, MAX_TILE_UPLOADS_IN_FLIGHT - uploading);
+    };
+    TileRamCache ramCache;
+    std::unique_ptr<TileSource> tileSource;
+    std::unique_ptr<TileLoader> tileLoader;
+    // evictions keep their slots for a few frames
+    const uint32_t evictedSlots = static_cast<uint32_t>(MAX_TILE_UPLOADS_PER_FRAME * 4);
+    VulkanTileCache tileCache(textures, std::min(textures.getCapacity(), 16384U) - evictedSlots -
+                                        (options.elevationPath ? HILLSHADE_TILES + evictedSlots : 0));
+    uint32_t tileTexture = 0;
+    std::unordered_map<TileKey, std::pair<TileVec, std::list<TileKey>::iterator>> residentTiles;
+    std::list<TileKey> residentUses; // most recently used first
+    if (tilePath) {
+        tileSource = openTileSource(tilePath);
+        tileLoader = createLoader(*tileSource, ramCache);
+        tile.setProjection(options.tileProjection);
+        // map tiles of a layer show source tiles of the one above, see GeodeticGrid.h
+        const uint32_t maxLayer = options.tileProjection == TileProjection::Geodetic
+                                  ? tileSource->getLayerCount() : tileSource->getLayerCount() - 1;
+        view.setMaxLayer(maxLayer);
+        minimap.setMaxLayer(maxLayer);
+    } else {
+        tileTexture = textures.load("../texture.jpg");
+    }
+    TileRamCache elevationRamCache;
+    std::unique_ptr<TileSource> elevationSource;
+    std::unique_ptr<TileLoader> elevationLoader;
+    std::unique_ptr<VulkanHillshadeLayer> hillshadeLayer;
+    if (options.elevationPath) {
+        elevationSource = openTileSource(options.elevationPath);
+        elevationLoader = createLoader(*elevationSource, elevationRamCache);
+        hillshadeLayer = std::make_unique<VulkanHillshadeLayer>(renderer, textures, options.elevationEncoding,
+                                                                HILLSHADE_TILES);
+    }
+    // the shading is an overlay of the imagery tiles when every imagery tile may have one, drawn in their pass
+    const bool geodeticTiles = tileSource && options.tileProjection == TileProjection::Geodetic;
+    const bool compositeHillshade = hillshadeLayer && tileSource && !geodeticTiles &&
+                                    elevationSource->getLayerCount() >= tileSource->getLayerCount();
+    if (compositeHillshade) {
+        // the shading carries its opacity in its alpha
+        tile.setLayerStyle(1, {1, RasterBlendMode::Normal});
+        hillshadeLayer->setComposited(true);
+    }
+
+    MarkerSet markers;
+    {
+        std::mt19937 random(0);
+        std::uniform_real_distribution<float> position(-1, 1);
+        std::uniform_int_distribution<uint32_t> color(0, 0xFFFFFF);
+        const size_t markerCount = 1000000;
+        markers.x.resize(markerCount);
+        markers.y.resize(markerCount);
+        markers.color.resize(markerCount);
+        for (size_t i = 0; i < markerCount; i++) {
+            markers.x[i] = position(random);
+            markers.y[i] = position(random);
+            markers.color[i] = 0xFF000000 | color(random);
+        }
+    }
+    {
+        std::vector<MapBox> markerBoxes(markers.x.size());
+        for (size_t i = 0; i < markerBoxes.size(); i++) {
+            MapVec position(markers.x[i], markers.y[i]);
+            markerBoxes[i] = {position, position};
+        }
+        markerIndex = std::make_unique<RTree>(markerBoxes, &pool);
+    }
+
+    const float labelSize = 14;
+    std::vector<std::string> labelTexts;
+    std::vector<LabelCandidate> labelCandidates;
+    for (size_t i = 0; i < markers.x.size(); i += 50) {
+        labelTexts.push_back("Marker " + std::to_string(i));
+        labelCandidates.push_back({
+                .anchor = MapVec(markers.x[i], markers.y[i]),
+                .size = atlas.shape(labelTexts.back(), font, labelSize).size,
+                .priority = static_cast<float>(markers.x.size() - i),
+        });
+    }
+    LabelPlacer labelPlacer(pool, std::move(labelCandidates));
+    VulkanTextRenderer textRenderer(renderer, atlas);
+    std::shared_ptr<const LabelPlacement> shownPlacement;
+
+    VulkanHeatmapLayer heatmapLayer(renderer, static_cast<uint32_t>(markers.x.size()));
+    heatmapLayer.setPoints({markers.x, markers.y, std::vector<float>(markers.x.size(), 1)});
 
-    VulkanTile tile(renderer);
+    VulkanMarkerLayer markerLayer(renderer, pool, std::move(markers));
+
+    PolylineSet tracks;
+    {
+        std::mt19937 random(1);
+        std::uniform_real_distribution<float> start(-.9f, .9f);
+        std::normal_distribution<float> step(0, 1e-4f);
+        std::uniform_int_distribution<uint32_t> length(2, 20000);
+        std::uniform_int_distribution<uint32_t> color(0, 0xFFFFFF);
+        for (int i = 0; i < 1000; i++) {
+            tracks.offsets.push_back(static_cast<uint32_t>(tracks.points.size()));
+            tracks.color.push_back(0xFF000000 | color(random));
+            MapVec position(start(random), start(random));
+            for (uint32_t j = length(random); j > 0; j--) {
+                position += MapVec(step(random), step(random));
+                tracks.points.push_back(position);
+            }
+        }
+        tracks.offsets.push_back(static_cast<uint32_t>(tracks.points.size()));
+    }
+    VulkanPolylineLayer polylineLayer(renderer, pool, tracks);
+
+    MetricsRegistry metrics;
+    Histogram &frameSeconds = metrics.histogram("mapengine_frame_seconds", "Time between frames.",
+                                                {.004, .008, .0167, .0333, .05, .1, .25});
+    Gauge &mainTiles = metrics.gauge("mapengine_visible_tiles", "Tiles getTiles() returned in the last frame.",
+                                     {{"view", "main"}});
+    Gauge &minimapTiles = metrics.gauge("mapengine_visible_tiles", "Tiles getTiles() returned in the last frame.",
+                                        {{"view", "minimap"}});
+    Gauge &inputLatency = metrics.gauge("mapengine_input_latency_seconds",
+                                        "Average input to finished frame latency over the last export interval.");
+    metrics.gaugeCallback("mapengine_gpu_memory_bytes", "Device memory of buffers and images.", [&] {
+        return static_cast<double>(renderer.allocatedMemory);
+    });
+    metrics.counterCallback("mapengine_swapchain_suboptimal_total",
+                            "Frames acquired from a swapchain no longer matching the surface.", [&] {
+                return static_cast<double>(renderer.suboptimalFrames);
+            });
+    if (tileLoader) {
+        for (auto [tier, stats]: {std::pair<const char *, TileTierStats *>{"gpu", &tileCache.stats},
+                                  {"decoded", &ramCache.decodedStats()},
+                                  {"encoded", &ramCache.encodedStats()}}) {
+            metrics.counterCallback("mapengine_tile_cache_hits_total", "Tile lookups found in a cache tier.", [=] {
+                return static_cast<double>(stats->hits.load(std::memory_order_relaxed));
+            }, {{"tier", tier}});
+            metrics.counterCallback("mapengine_tile_cache_misses_total", "Tile lookups missing a cache tier.", [=] {
+                return static_cast<double>(stats->misses.load(std::memory_order_relaxed));
+            }, {{"tier", tier}});
+        }
+        const std::string loadsHelp = "Tiles in each stage of loading.";
+        metrics.gaugeCallback("mapengine_tile_loads", loadsHelp, [&] {
+            return static_cast<double>(tileLoader->getDepths().queued);
+        }, {{"state", "queued"}});
+        metrics.gaugeCallback("mapengine_tile_loads", loadsHelp, [&] {
+            return static_cast<double>(tileLoader->getDepths().loading);
+        }, {{"state", "loading"}});
+        metrics.gaugeCallback("mapengine_tile_loads", loadsHelp, [&] {
+            return static_cast<double>(tileLoader->getDepths().finished);
+        }, {{"state", "waiting_upload"}});
+    }
 
 
     auto fpsStartTime = std::chrono::system_clock::now();
     auto frames = 0;
-    while (!glfwWindowShouldClose(window)) {
+    auto frameTime = std::chrono::steady_clock::now();
+    const auto replayStart = frameTime;
+    size_t replayedEvents = 0;
+    std::vector<float> replayFrameTimes;
+    bool metricsFailing = false; // logged when it starts
+    while (replay ? replayedEvents < replay->events.size() : !glfwWindowShouldClose(window)) {
         frames++;
         auto now = std::chrono::system_clock::now();
         if (std::chrono::duration_cast<std::chrono::milliseconds>(now - fpsStartTime).count() > 1000) {
             fpsStartTime = now;
             std::cout << "Frames: " << frames << std::endl;
+            if (const FrameLatency latency = renderer.takeLatency(); latency.count > 0) {
+                std::cout << "Input latency: average " << latency.averageMs << " ms, max " << latency.maxMs
+                          << " ms" << std::endl;
+                inputLatency.set(latency.averageMs / 1000);
+            }
+            if (tileLoader) {
+                std::cout << "Tile hit ratio: GPU " << tileCache.stats.takeHitRatio() << ", decoded "
+                          << ramCache.decodedStats().takeHitRatio() << ", encoded "
+                          << ramCache.encodedStats().takeHitRatio() << std::endl;
+            }
+            if (options.metricsPath) {
+                // a full disk or a locked file must not end the viewer, the next export tries again
+                try {
+                    metrics.writeFile(options.metricsPath);
+                    metricsFailing = false;
+                } catch (std::runtime_error &error) {
+                    if (!metricsFailing) {
+                        std::cout << error.what() << std::endl;
+                    }
+                    metricsFailing = true;
+                }
+            }
             frames = 0;
         }
-        std::vector<TileVec> tileList = view.getTiles();
+        if (options.latencyMode == LatencyMode::LowLatency && !replay) {
+            // the previous frame is done, input arriving meanwhile makes it into this one
+            renderer.waitForFrame();
+            glfwPollEvents();
+        }
+        {
+            auto previousFrameTime = frameTime;
+            frameTime = std::chrono::steady_clock::now();
+            frameSeconds.observe(std::chrono::duration<double>(frameTime - previousFrameTime).count());
+            // a long wait for events must not turn into one big animation step
+            float dt = std::min(std::chrono::duration<float>(frameTime - previousFrameTime).count(), .1f);
+            if (replay) {
+                if (replayedEvents > 0) {
+                    replayFrameTimes.push_back(std::chrono::duration<float>(frameTime - previousFrameTime).count());
+                }
+                // the events up to the next recorded frame, which brings the dt it had
+                while (replayedEvents < replay->events.size()) {
+                    const InputEvent &event = replay->events[replayedEvents++];
+                    if (!options.maxSpeed) {
+                        std::this_thread::sleep_until(replayStart + std::chrono::microseconds(event.time));
+                    }
+                    input.handle(event);
+                    if (event.type == InputEventType::Frame) {
+                        dt = event.x;
+                        break;
+                    }
+                }
+            } else {
+                input.update(dt);
+            }
+            view.animate(dt);
+            if (auto eventTime = input.takeEventTime()) {
+                renderer.markInput(*eventTime);
+            }
+        }
+        {
+            const ViewSnapshot main = view.snapshot();
+            minimap.jumpTo(main.center, main.size.x * MINIMAP_ZOOM_OUT, main.angle);
+        }
+        labelPlacer.update(view.snapshot());
+        if (auto placement = labelPlacer.getPlacement(); placement != shownPlacement) {
+            std::vector<TextLabel> labels;
+            labels.reserve(placement->placed.size());
+            for (uint32_t id: placement->placed) {
+                labels.push_back({labelTexts[id], font, labelSize, labelPlacer.getCandidate(id).anchor, 0xFFFFFFFF});
+            }
+            textRenderer.setLabels(labels);
+            shownPlacement = std::move(placement);
+        }
+
+        bool tilesChanged = false;
+        std::vector<TileVec> shownTiles; // of both views
+        if (tileLoader) {
+            // visible tiles are due now, tiles along a flight when the flight gets there
+            const auto now = TileLoader::Clock::now();
+            auto requestTile = [&](const TileKey &key, TileLoader::Clock::time_point deadline) {
+                if (key.layer < tileSource->getLayerCount() && !tileCache.contains(key)) {
+                    tileLoader->request(key, deadline);
+                }
+            };
+            // source tiles a map tile shows
+            auto sourceTiles = [&](const TileKey &key) {
+                return geodeticTiles ? geodeticTilesCovering(key) : std::vector<TileKey>{key};
+            };
+            // a tile visible in both views is requested and uploaded once
+            for (View *v: {&view, &minimap}) {
+                const std::vector<TileVec> tiles = v->getTiles();
+                (v == &view ? mainTiles : minimapTiles).set(static_cast<double>(tiles.size()));
+                for (const auto &t: tiles) {
+                    for (const TileKey &key: sourceTiles(t.key())) {
+                        if (!tileCache.use(key)) {
+                            requestTile(key, now);
+                        }
+                    }
+                }
+                shownTiles.insert(shownTiles.end(), tiles.begin(), tiles.end());
+            }
+            for (const auto &request: tileRequests) {
+                const auto deadline = now + std::chrono::duration_cast<TileLoader::Clock::duration>(
+                        std::chrono::duration<float>(request.deadline));
+                for (const TileKey &key: sourceTiles(request.tile.key())) {
+                    requestTile(key, deadline);
+                }
+            }
+
+            // cancelled loads are cached too, the area may be visited again soon
+            for (const auto &loaded: tileLoader->collect(uploadsAllowed())) {
+                const TileKey &key = loaded.key;
+                tileCache.insert(View::tileAt(key.layer, key.row, key.column), loaded.image);
+                awaitUpload(renderer, uploading).start();
+            }
+            tilesChanged = tileCache.takeChanged();
+        } else {
+            // requested tiles stay resident like cached ones would, the GPU culls them
+            bool residentChanged = false;
+            auto useResident = [&](const TileVec &t) {
+                const TileKey key = t.key();
+                if (auto resident = residentTiles.find(key); resident != residentTiles.end()) {
+                    residentUses.splice(residentUses.begin(), residentUses, resident->second.second);
+                    return;
+                }
+                if (residentTiles.size() >= MAX_RESIDENT_TILES) {
+                    residentTiles.erase(residentUses.back());
+                    residentUses.pop_back();
+                }
+                residentUses.push_front(key);
+                residentTiles.emplace(key, std::pair{t, residentUses.begin()});
+                residentChanged = true;
+            };
+            for (const auto &request: tileRequests) {
+                useResident(request.tile);
+            }
+            // the views' tiles last, so that they are the most recently used
+            for (View *v: {&view, &minimap}) {
+                const std::vector<TileVec> tiles = v->getTiles();
+                (v == &view ? mainTiles : minimapTiles).set(static_cast<double>(tiles.size()));
+                for (const auto &t: tiles) {
+                    useResident(t);
+                }
+            }
+            if (residentChanged) {
+                std::vector<VulkanTile::Candidate> candidates;
+                candidates.reserve(residentTiles.size());
+                for (const auto &[key, resident]: residentTiles) {
+                    candidates.push_back({resident.first, tileTexture});
+                }
+                tile.setCandidates(candidates);
+            }
+        }
+        if (hillshadeLayer) {
+            // the minimap loads no elevation
+            const auto now = TileLoader::Clock::now();
+            const std::vector<TileVec> tiles = view.getTiles();
+            for (const auto &t: tiles) {
+                if (t.layer < elevationSource->getLayerCount() && !hillshadeLayer->use(t.key())) {
+                    elevationLoader->request(t.key(), now);
+                }
+            }
+            hillshadeLayer->setShownTiles(tiles);
+            for (const auto &loaded: elevationLoader->collect(uploadsAllowed())) {
+                const TileKey &key = loaded.key;
+                hillshadeLayer->insert(View::tileAt(key.layer, key.row, key.column), loaded.image);
+                awaitUpload(renderer, uploading).start();
+            }
+            if (lightChanged) {
+                hillshadeLayer->setLight(glm::radians(lightAzimuth), glm::radians(LIGHT_ALTITUDE));
+            }
+            if (shadingChanged) {
+                hillshadeLayer->setShading(hillshadeLayer->getShading() == TerrainShading::Hillshade
+                                           ? TerrainShading::Slope : TerrainShading::Hillshade);
+            }
+        }
+        if (compositeHillshade) {
+            tilesChanged |= hillshadeLayer->takeChanged();
+        }
+        if (tilesChanged) {
+            std::vector<VulkanTile::Candidate> candidates = geodeticTiles ? tileCache.getGeodeticCandidates()
+                                                                          : tileCache.getCandidates();
+            if (compositeHillshade) {
+                for (auto &candidate: candidates) {
+                    candidate.overlays[0] = hillshadeLayer->getTexture(candidate.tile.key()).value_or(NO_TEXTURE);
+                }
+            }
+            tile.setCandidates(candidates);
+        }
+        if (tileLoader) {
+            // until the missing tiles arrive, their ancestors are magnified in their place
+            tile.setShownTiles(shownTiles);
+        }
+        lightChanged = false;
+        shadingChanged = false;
+        tileRequests.clear();
+
         std::forward_list<std::function<void(VkCommandBuffer)>> list = {
                 [&](VkCommandBuffer commandBuffer) {
-                    for (const auto &t: tileList) {
-                        tile.render(commandBuffer, t.center.x, t.center.y, t.tileSide, view.getViewMatrix());
+                    tile.renderCulled(commandBuffer, view);
+                },
+                [&](VkCommandBuffer commandBuffer) {
+                    if (hillshadeLayer) {
+                        hillshadeLayer->render(commandBuffer, view);
                     }
                 },
+                [&](VkCommandBuffer commandBuffer) {
+                    heatmapLayer.render(commandBuffer, view);
+                },
+                [&](VkCommandBuffer commandBuffer) {
+                    polylineLayer.render(commandBuffer, view);
+                },
+                [&](VkCommandBuffer commandBuffer) {
+                    markerLayer.render(commandBuffer, view);
+                },
+                [&](VkCommandBuffer commandBuffer) {
+                    textRenderer.render(commandBuffer, view);
+                },
+                [&](VkCommandBuffer commandBuffer) {
+                    // overlays stay in the main view, the minimap only shows tiles
+                    const VkExtent2D extent = renderer.renderArea.extent;
+                    const VkRect2D area{
+                            .offset = {static_cast<int32_t>(extent.width - MINIMAP_WIDTH) - MINIMAP_MARGIN,
+                                       static_cast<int32_t>(extent.height - MINIMAP_HEIGHT) - MINIMAP_MARGIN},
+                            .extent = {MINIMAP_WIDTH, MINIMAP_HEIGHT},
+                    };
+                    const VkClearAttachment clear{
+                            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                            .colorAttachment = 0,
+                            .clearValue = {0.0f, 0.0f, 0.0f, 1.0f},
+                    };
+                    const VkClearRect clearRect{.rect = area, .layerCount = 1};
+                    vkCmdClearAttachments(commandBuffer, 1, &clear, 1, &clearRect);
+                    setViewport(commandBuffer, area);
+                    tile.renderCulled(commandBuffer, minimap, 1);
+                    setViewport(commandBuffer, renderer.renderArea);
+                },
         };
         //angle += 1;
-        renderer.nextFrame(list);
+        std::forward_list<std::function<void(VkCommandBuffer)>> preRenderingList = {
+                [&](VkCommandBuffer commandBuffer) {
+                    tile.cull(commandBuffer, view, 0);
+                    tile.cull(commandBuffer, minimap, 1);
+                },
+                [&](VkCommandBuffer commandBuffer) {
+                    if (hillshadeLayer) {
+                        hillshadeLayer->compute(commandBuffer, view);
+                    }
+                },
+                [&](VkCommandBuffer commandBuffer) {
+                    heatmapLayer.compute(commandBuffer, view);
+                },
+        };
+        renderer.nextFrame(list, preRenderingList);
 
-        // glfwPollEvents();
-        glfwWaitEvents();
+        if (replay) {
+            continue;
+        } else if (input.isAnimating() || view.isFlying() || (tileLoader && tileLoader->isBusy()) ||
+                   (elevationLoader && elevationLoader->isBusy())) {
+            glfwPollEvents();
+        } else {
+            // label placement and tile loads finish in the background, wake up to show them
+            glfwWaitEventsTimeout(0.1);
+        }
     }
 
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    if (window) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    } else {
+        printFrameTimes(std::move(replayFrameTimes));
+    }
 }
 
-int main() {
+// usage: MapEngine [--low-latency | --throughput] [--metrics file] [--record file | --replay file [--max-speed]]
+//                  [--elevation tiles [--terrarium]] [--geodetic] [--font file] [tiles]
+int main(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg(argv[i]);
+        if (arg == "--low-latency") {
+            options.latencyMode = LatencyMode::LowLatency;
+        } else if (arg == "--throughput") {
+            options.latencyMode = LatencyMode::Throughput;
+        } else if (arg == "--metrics" && i + 1 < argc) {
+            options.metricsPath = argv[++i];
+        } else if (arg == "--record" && i + 1 < argc) {
+            options.recordPath = argv[++i];
+        } else if (arg == "--replay" && i + 1 < argc) {
+            options.replayPath = argv[++i];
+        } else if (arg == "--max-speed") {
+            options.maxSpeed = true;
+        } else if (arg == "--elevation" && i + 1 < argc) {
+            options.elevationPath = argv[++i];
+        } else if (arg == "--terrarium") {
+            options.elevationEncoding = ElevationEncoding::Terrarium;
+        } else if (arg == "--geodetic") {
+            options.tileProjection = TileProjection::Geodetic;
+        } else if (arg == "--font" && i + 1 < argc) {
+            options.fontPath = argv[++i];
+        } else {
+            options.tilePath = argv[i];
+        }
+    }
     try {
-        main_throws();
+        main_throws(options);
     } catch (std::exception &exception) {
         std::cout << exception.what() << std::endl;
+        return EXIT_FAILURE;
     }
 
     return EXIT_SUCCESS;
@@ -1,3 +1,16 @@
-C:\VulkanSDK\1.3.239.0\Bin\glslc.exe shader.vert -o vert.spv
-C:\VulkanSDK\1.3.239.0\Bin\glslc.exe shader.frag -o frag.spv
+C:\VulkanSDK\1.3.239.0\Bin\glslc.exe marker.vert -o marker_vert.spv
+C:\VulkanSDK\1.3.239.0\Bin\glslc.exe marker.frag -o marker_frag.spv
+C:\VulkanSDK\1.3.239.0\Bin\glslc.exe text.vert -o text_vert.spv
+C:\VulkanSDK\1.3.239.0\Bin\glslc.exe text.frag -o text_frag.spv
+C:\VulkanSDK\1.3.239.0\Bin\glslc.exe polyline.vert -o polyline_vert.spv
+C:\VulkanSDK\1.3.239.0\Bin\glslc.exe polyline.frag -o polyline_frag.spv
+C:\VulkanSDK\1.3.239.0\Bin\glslc.exe heatmap_splat.comp -o heatmap_splat_comp.spv
+C:\VulkanSDK\1.3.239.0\Bin\glslc.exe heatmap_blur_x.comp -o heatmap_blur_x_comp.spv
+C:\VulkanSDK\1.3.239.0\Bin\glslc.exe heatmap_blur_y.comp -o heatmap_blur_y_comp.spv
+C:\VulkanSDK\1.3.239.0\Bin\glslc.exe heatmap.vert -o heatmap_vert.spv
+C:\VulkanSDK\1.3.239.0\Bin\glslc.exe heatmap.frag -o heatmap_frag.spv
+C:\VulkanSDK\1.3.239.0\Bin\glslc.exe tile_cull.comp -o tile_cull_comp.spv
+C:\VulkanSDK\1.3.239.0\Bin\glslc.exe tile_instanced.vert -o tile_instanced_vert.spv
+C:\VulkanSDK\1.3.239.0\Bin\glslc.exe tile_instanced.frag -o tile_instanced_frag.spv
+C:\VulkanSDK\1.3.239.0\Bin\glslc.exe hillshade.comp -o hillshade_comp.spv
 pause
\ No newline at end of file
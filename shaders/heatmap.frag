@@ -0,0 +1,28 @@
+#version 450
+
+layout(location = 0) in vec3 fragUv;
+layout(location = 1) flat in float fragIntensity;
+
+layout(binding = 0) uniform sampler2D density;
+
+layout(location = 0) out vec4 outColor;
+
+const vec4 ramp[5] = vec4[](
+        vec4(0.0, 0.0, 1.0, 0.0),
+        vec4(0.0, 1.0, 1.0, 0.6),
+        vec4(0.0, 1.0, 0.0, 0.7),
+        vec4(1.0, 1.0, 0.0, 0.8),
+        vec4(1.0, 0.0, 0.0, 0.9)
+);
+
+void main() {
+    // saturates smoothly instead of clipping dense areas
+    float t = 1.0 - exp(-texture(density, fragUv.xy / fragUv.z).r * fragIntensity);
+    float position = t * 4.0;
+    int i = min(int(position), 3);
+    vec4 color = mix(ramp[i], ramp[i + 1], position - float(i));
+    if (color.a <= 0.0) {
+        discard;
+    }
+    outColor = color;
+}
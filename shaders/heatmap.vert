@@ -0,0 +1,19 @@
+#version 450
+
+layout(location = 0) out vec3 fragUv; // homogeneous
+layout(location = 1) flat out float fragIntensity;
+
+layout(push_constant, std430) uniform pc {
+    mat4 vulkanToUv;
+    vec4 intensity;
+};
+
+const vec2 corners[4] = vec2[](vec2(-1, -1), vec2(1, -1), vec2(-1, 1), vec2(1, 1));
+
+void main() {
+    vec2 corner = corners[gl_VertexIndex];
+    gl_Position = vec4(corner, 0.0, 1.0);
+    // a homography, so interpolating the homogeneous corners is exact
+    fragUv = mat3(vulkanToUv) * vec3(corner, 1.0);
+    fragIntensity = intensity.x;
+}
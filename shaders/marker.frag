@@ -0,0 +1,15 @@
+#version 450
+
+layout(location = 0) in vec2 fragCorner;
+layout(location = 1) in vec4 fragColor;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    float distance = length(fragCorner);
+    float alpha = 1.0 - smoothstep(1.0 - fwidth(distance), 1.0, distance);
+    if (alpha <= 0.0) {
+        discard;
+    }
+    outColor = vec4(fragColor.rgb, fragColor.a * alpha);
+}
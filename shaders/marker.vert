@@ -0,0 +1,25 @@
+#version 450
+
+layout(location = 0) in uint pointIndex;
+
+layout(std430, binding = 0) readonly buffer PositionsX { float positionsX[]; };
+layout(std430, binding = 1) readonly buffer PositionsY { float positionsY[]; };
+layout(std430, binding = 2) readonly buffer Colors { uint colors[]; };
+
+layout(location = 0) out vec2 fragCorner;
+layout(location = 1) out vec4 fragColor;
+
+layout(push_constant, std430) uniform pc {
+    mat4 viewMatrix;
+    vec4 markerSize;
+};
+
+const vec2 corners[4] = vec2[](vec2(-1, -1), vec2(1, -1), vec2(-1, 1), vec2(1, 1));
+
+void main() {
+    vec2 corner = corners[gl_VertexIndex];
+    vec4 center = viewMatrix * vec4(positionsX[pointIndex], positionsY[pointIndex], 0.0, 1.0);
+    gl_Position = center + vec4(corner * markerSize.xy * center.w, 0.0, 0.0);
+    fragCorner = corner;
+    fragColor = unpackUnorm4x8(colors[pointIndex]);
+}
@@ -0,0 +1,15 @@
+#version 450
+
+layout(location = 0) in float fragAcross;
+layout(location = 1) in vec4 fragColor;
+layout(location = 2) flat in float fragLineWidth;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    float alpha = clamp(fragLineWidth * 0.5 + 0.5 - abs(fragAcross), 0.0, 1.0);
+    if (alpha <= 0.0) {
+        discard;
+    }
+    outColor = vec4(fragColor.rgb, fragColor.a * alpha);
+}
@@ -0,0 +1,42 @@
+#version 450
+
+layout(location = 0) in uvec3 segment; // first point, second point, track
+
+layout(std430, binding = 0) readonly buffer Points { vec2 points[]; };
+layout(std430, binding = 1) readonly buffer Colors { uint colors[]; };
+
+layout(location = 0) out float fragAcross;
+layout(location = 1) out vec4 fragColor;
+layout(location = 2) flat out float fragLineWidth;
+
+layout(push_constant, std430) uniform pc {
+    mat4 viewMatrix;
+    vec4 windowSize; // z = line width
+};
+
+// x along the segment, y across it
+const vec2 corners[4] = vec2[](vec2(0, -1), vec2(1, -1), vec2(0, 1), vec2(1, 1));
+
+void main() {
+    vec2 corner = corners[gl_VertexIndex];
+    vec2 halfWindow = windowSize.xy * 0.5;
+    // extrude in pixels so the width does not depend on zoom or aspect ratio
+    vec4 clipA = viewMatrix * vec4(points[segment.x], 0.0, 1.0);
+    vec4 clipB = viewMatrix * vec4(points[segment.y], 0.0, 1.0);
+    // a pitched camera divides by w, points behind it are pushed far out instead of flipping over
+    vec2 a = clipA.xy / max(clipA.w, 1e-3) * halfWindow;
+    vec2 b = clipB.xy / max(clipB.w, 1e-3) * halfWindow;
+    vec2 direction = b - a;
+    float len = length(direction);
+    direction = len > 0.0 ? direction / len : vec2(1.0, 0.0);
+    vec2 normal = vec2(-direction.y, direction.x);
+
+    // one extra pixel for antialiasing, square caps hide the gaps at joints
+    float halfWidth = windowSize.z * 0.5 + 1.0;
+    vec2 position = mix(a, b, corner.x) + direction * (corner.x * 2.0 - 1.0) * halfWidth
+            + normal * corner.y * halfWidth;
+    gl_Position = vec4(position / halfWindow, 0.0, 1.0);
+    fragAcross = corner.y * halfWidth;
+    fragColor = unpackUnorm4x8(colors[segment.z]);
+    fragLineWidth = windowSize.z;
+}
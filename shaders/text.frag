@@ -0,0 +1,19 @@
+#version 450
+
+layout(location = 0) in vec2 fragUv;
+layout(location = 1) in vec4 fragColor;
+
+layout(binding = 0) uniform sampler2D atlas;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    // 0.5 is the glyph edge, fwidth keeps it about one pixel wide at any scale
+    float distance = texture(atlas, fragUv).r;
+    float width = fwidth(distance);
+    float alpha = smoothstep(0.5 - width, 0.5 + width, distance);
+    if (alpha <= 0.0) {
+        discard;
+    }
+    outColor = vec4(fragColor.rgb, fragColor.a * alpha);
+}
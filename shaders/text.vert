@@ -0,0 +1,25 @@
+#version 450
+
+layout(location = 0) in vec2 anchor;
+layout(location = 1) in vec2 offset;
+layout(location = 2) in vec2 size;
+layout(location = 3) in uint color;
+layout(location = 4) in vec4 uv;
+
+layout(location = 0) out vec2 fragUv;
+layout(location = 1) out vec4 fragColor;
+
+layout(push_constant, std430) uniform pc {
+    mat4 viewMatrix;
+    vec4 pixelSize;
+};
+
+const vec2 corners[4] = vec2[](vec2(0, 0), vec2(1, 0), vec2(0, 1), vec2(1, 1));
+
+void main() {
+    vec2 corner = corners[gl_VertexIndex];
+    vec4 center = viewMatrix * vec4(anchor, 0.0, 1.0);
+    gl_Position = center + vec4((offset + corner * size) * pixelSize.xy * center.w, 0.0, 0.0);
+    fragUv = mix(uv.xy, uv.zw, corner);
+    fragColor = unpackUnorm4x8(color);
+}
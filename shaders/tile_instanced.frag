@@ -0,0 +1,74 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+const uint NO_TEXTURE = 0xFFFFFFFFu;
+const float PI = 3.14159265358979;
+
+layout(set = 0, binding = 0) uniform sampler tileSampler;
+layout(set = 0, binding = 1) uniform texture2D textures[];
+
+layout(location = 0) in vec2 fragTexCoord;
+layout(location = 1) flat in uvec4 fragTextures;
+layout(location = 2) in vec2 fragMapPosition;
+layout(location = 3) flat in uint fragLayer;
+
+layout(location = 0) out vec4 outColor;
+
+layout(push_constant, std430) uniform pc {
+    mat4 viewMatrix;
+    vec4 opacity; // per raster layer
+    uvec4 blend; // 0 normal, 1 multiply, 2 screen, 3 overlay
+    uint projection; // 0 Web Mercator, 1 EPSG:4326
+};
+
+vec4 sampleLayer(uint slot) {
+    // instances of one draw sample different textures
+    return texture(sampler2D(textures[nonuniformEXT(slot)], tileSampler), fragTexCoord);
+}
+
+// the EPSG:4326 tile under the fragment, among the up to two of the map tile
+vec4 sampleGeodetic() {
+    // source layer and slots as in GeodeticGrid.cpp
+    float rows = float(1u << (max(fragLayer, 1u) - 1u));
+    float latitude = atan(sinh(PI * fragMapPosition.y));
+    vec2 source = vec2((fragMapPosition.x + 1.0) * rows, (0.5 - latitude / PI) * rows);
+    uvec2 cell = uvec2(floor(source));
+    uint slot = fragTextures[(cell.y & 1u) * 2u + (cell.x & 1u)];
+    if (slot == NO_TEXTURE) {
+        return vec4(0.0);
+    }
+    // neighbouring fragments may sample different tiles, so the level cannot come from derivatives
+    return textureLod(sampler2D(textures[nonuniformEXT(slot)], tileSampler), source - vec2(cell), 0.0);
+}
+
+vec3 blendColor(uint mode, vec3 base, vec3 layer) {
+    if (mode == 1) {
+        return base * layer;
+    } else if (mode == 2) {
+        return 1.0 - (1.0 - base) * (1.0 - layer);
+    } else if (mode == 3) {
+        return mix(2.0 * base * layer, 1.0 - 2.0 * (1.0 - base) * (1.0 - layer), step(0.5, base));
+    }
+    return layer;
+}
+
+void main() {
+    if (projection == 1) {
+        outColor = sampleGeodetic();
+        outColor.a *= opacity[0];
+        return;
+    }
+    vec4 color = sampleLayer(fragTextures[0]);
+    color.a *= opacity[0];
+    // overlays of the same tile, blended in one pass instead of a draw per layer
+    for (int i = 1; i < 4; i++) {
+        if (fragTextures[i] == NO_TEXTURE) {
+            continue;
+        }
+        vec4 layer = sampleLayer(fragTextures[i]);
+        float coverage = layer.a * opacity[i];
+        color.rgb = mix(color.rgb, blendColor(blend[i], color.rgb, layer.rgb), coverage);
+        color.a = coverage + color.a * (1.0 - coverage);
+    }
+    outColor = color;
+}
@@ -0,0 +1,25 @@
+#version 450
+
+layout(location = 0) in vec2 vkCoordinate;
+layout(location = 1) in vec2 inTexCoord;
+layout(location = 2) in vec3 tile; // center, side
+layout(location = 3) in uvec4 textureSlots; // own texture, then overlays
+layout(location = 4) in uint textureLayer; // of the tile the textures belong to
+layout(location = 5) in vec3 textureTransform; // offset and scale of the part of the textures the tile shows
+
+layout(location = 0) out vec2 fragTexCoord;
+layout(location = 1) flat out uvec4 fragTextures;
+layout(location = 2) out vec2 fragMapPosition;
+layout(location = 3) flat out uint fragLayer;
+
+layout(push_constant, std430) uniform pc {
+    mat4 viewMatrix;
+};
+
+void main() {
+    fragMapPosition = tile.xy + vkCoordinate * tile.z;
+    gl_Position = viewMatrix * vec4(fragMapPosition, 0.0, 1.0);
+    fragTexCoord = textureTransform.xy + inTexCoord * textureTransform.z;
+    fragTextures = textureSlots;
+    fragLayer = textureLayer;
+}
@@ -0,0 +1,102 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+// Fetches tiles from tests/tile_server.py, which runs it:
+//   HttpTileSourceCheck <server port> <closed port>
+// See the server for how each layer is answered.
+
+// TileSource decodes with it
+#define STB_IMAGE_IMPLEMENTATION
+
+#include <stb_image.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../HttpTileSource.h"
+
+// fetched at once from the delayed layer, more than the connections take without pipelining
+static const uint32_t CONCURRENT_FETCHES = 8;
+
+static int failures = 0;
+
+static void check(bool condition, const std::string &what) {
+    if (!condition) {
+        std::cout << "check: " << what << std::endl;
+        failures++;
+    }
+}
+
+static std::vector<uint8_t> tileBody(const TileKey &key) {
+    const std::string part = "tile " + std::to_string(key.layer) + "/" + std::to_string(key.column) + "/" +
+                             std::to_string(key.row) + ";";
+    std::vector<uint8_t> body;
+    for (int i = 0; i < 50; i++) {
+        body.insert(body.end(), part.begin(), part.end());
+    }
+    return body;
+}
+
+static bool fetches(HttpTileSource &source, const TileKey &key) {
+    try {
+        return source.fetch(key) == tileBody(key);
+    } catch (std::exception &exception) {
+        std::cout << "check: " << exception.what() << std::endl;
+        return false;
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::cout << "usage: HttpTileSourceCheck <server port> <closed port>" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const HttpOptions options{
+            .maxConnections = 2,
+            .pipelineDepth = 4,
+            .timeout = std::chrono::milliseconds(2000),
+            .retries = 2,
+            .backoff = std::chrono::milliseconds(10),
+    };
+    HttpTileSource source("http://127.0.0.1:" + std::string(argv[1]) + "/{z}/{x}/{y}", 6, options);
+
+    check(fetches(source, {0, 0, 0}), "revalidated tile, first fetch");
+    check(fetches(source, {0, 0, 0}), "revalidated tile, answered with 304");
+    check(fetches(source, {1, 0, 0}), "chunked tile");
+    check(fetches(source, {2, 0, 0}), "tile retried after 503");
+    try {
+        check(!source.fetch({3, 0, 0}), "missing tile");
+    } catch (std::exception &exception) {
+        check(false, std::string("missing tile threw ") + exception.what());
+    }
+    check(fetches(source, {5, 0, 0}), "no-store tile, first fetch");
+    check(fetches(source, {5, 0, 0}), "no-store tile, second fetch");
+
+    std::vector<std::thread> threads;
+    std::vector<char> fetched(CONCURRENT_FETCHES);
+    for (uint32_t i = 0; i < CONCURRENT_FETCHES; i++) {
+        threads.emplace_back([&, i]() {
+            fetched[i] = fetches(source, {4, i, 0});
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    for (uint32_t i = 0; i < CONCURRENT_FETCHES; i++) {
+        check(fetched[i], "concurrent tile " + std::to_string(i));
+    }
+
+    HttpTileSource refused("http://127.0.0.1:" + std::string(argv[2]) + "/{z}/{x}/{y}", 6, options);
+    try {
+        refused.fetch({0, 0, 0});
+        check(false, "refused connection did not throw");
+    } catch (std::runtime_error &) {
+    }
+
+    std::cout << "check: " << (failures ? "failed" : "passed") << std::endl;
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,118 @@
+//
+// Created by JaaK on 18.10.2026.
+//
+
+// Loads tiles from a source that holds each fetch until the check lets it go:
+//   TileLoaderCheck
+
+// TileSource decodes with it
+#define STB_IMAGE_IMPLEMENTATION
+
+#include <stb_image.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "../TileLoader.h"
+#include "../TileRamCache.h"
+#include "../ThreadPool.h"
+#include "../TaskExecutor.h"
+
+static int failures = 0;
+
+static void check(bool condition, const std::string &what) {
+    if (!condition) {
+        std::cout << "check: " << what << std::endl;
+        failures++;
+    }
+}
+
+// fetches wait until released, decoding only counts
+class GatedSource : public TileSource {
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool released = false;
+    unsigned fetching = 0;
+
+public:
+    mutable std::atomic<unsigned> decodes{0};
+
+    uint32_t getLayerCount() const override {
+        return 1;
+    }
+
+    std::optional<std::vector<uint8_t>> fetch(const TileKey &key) override {
+        std::unique_lock lock(mutex);
+        fetching++;
+        changed.notify_all();
+        changed.wait(lock, [this]() { return released; });
+        return std::vector<uint8_t>{1, 2, 3};
+    }
+
+    std::optional<TileImage> decode(const std::vector<uint8_t> &bytes) const override {
+        decodes++;
+        return TileImage{1, 1, {0, 0, 0, 255}};
+    }
+
+    void waitForFetch() {
+        std::unique_lock lock(mutex);
+        changed.wait(lock, [this]() { return fetching > 0; });
+    }
+
+    void release() {
+        std::lock_guard lock(mutex);
+        released = true;
+        changed.notify_all();
+    }
+};
+
+// until the load is delivered or dropped
+static void waitForLoad(TileLoader &loader) {
+    for (int i = 0; i < 500 && loader.isBusy() && loader.getDepths().finished == 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+int main() {
+    ThreadPool pool(2);
+    TaskExecutor executor(pool);
+
+    {
+        // cancelled after the fetch started, what was fetched is cached but not decoded
+        GatedSource source;
+        TileRamCache ramCache;
+        TileLoader loader(executor, source, &ramCache, 1);
+        const TileKey key{0, 0, 0};
+        loader.request(key, TileLoader::Clock::now());
+        source.waitForFetch();
+        loader.cancel(key);
+        source.release();
+        waitForLoad(loader);
+        check(!loader.isBusy(), "cancelled load finished");
+        check(ramCache.getEncoded(key) != nullptr, "cancelled load cached the fetched tile");
+        check(ramCache.getDecoded(key) == nullptr, "cancelled load decoded");
+        check(source.decodes == 0, "cancelled load decoded");
+        check(loader.collect().empty(), "cancelled load delivered");
+    }
+    {
+        GatedSource source;
+        TileRamCache ramCache;
+        TileLoader loader(executor, source, &ramCache, 1);
+        const TileKey key{0, 0, 0};
+        source.release();
+        loader.request(key, TileLoader::Clock::now());
+        waitForLoad(loader);
+        check(ramCache.getEncoded(key) != nullptr, "load cached the fetched tile");
+        check(ramCache.getDecoded(key) != nullptr, "load cached the decoded tile");
+        const auto results = loader.collect();
+        check(results.size() == 1 && !results[0].cancelled, "load delivered");
+    }
+
+    std::cout << "check: " << (failures ? "failed" : "passed") << std::endl;
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
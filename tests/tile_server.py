@@ -0,0 +1,145 @@
+#
+# Created by JaaK on 18.10.2026.
+#
+
+# Stand-in tile server for HttpTileSourceCheck:
+#   python tile_server.py <HttpTileSourceCheck executable>
+# Serves on an ephemeral port, runs the check against it and exits with its status, or 1 when the server saw
+# something else than the check should have caused. The layer of a tile picks how it is answered:
+#   0  ETag and Cache-Control: no-cache, revalidated with a 304
+#   1  chunked body
+#   2  503 on the first request for each tile, then the tile
+#   3  404
+#   4  answered after a delay, so that concurrent fetches pipeline
+#   5  ETag and Cache-Control: no-store, never revalidated
+
+import socket
+import subprocess
+import sys
+import threading
+import time
+
+PIPELINE_DELAY = .2
+CHUNK_SIZE = 7
+
+
+def tile_body(layer, column, row):
+    # the check computes the same bytes
+    return ("tile %d/%d/%d;" % (layer, column, row)).encode() * 50
+
+
+class Server:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.requests = {}  # path to count
+        self.conditional = {}  # path to count of requests with If-None-Match
+        self.pipelined = 0  # requests sent before the previous one on the connection was answered
+        self.listener = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.listener.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.listener.bind(("127.0.0.1", 0))
+        self.listener.listen(64)
+        self.port = self.listener.getsockname()[1]
+        threading.Thread(target=self.accept, daemon=True).start()
+
+    def accept(self):
+        while True:
+            connection, _ = self.listener.accept()
+            threading.Thread(target=self.serve, args=(connection,), daemon=True).start()
+
+    def serve(self, connection):
+        buffer = b""
+        try:
+            while True:
+                while b"\r\n\r\n" not in buffer:
+                    data = connection.recv(65536)
+                    if not data:
+                        return
+                    buffer += data
+                head, buffer = buffer.split(b"\r\n\r\n", 1)
+                lines = head.decode().split("\r\n")
+                path = lines[0].split(" ")[1]
+                headers = {}
+                for line in lines[1:]:
+                    name, _, value = line.partition(":")
+                    headers[name.strip().lower()] = value.strip()
+                response = self.respond(path, headers)
+                # whatever arrived before the answer was sent was pipelined behind this request
+                connection.setblocking(False)
+                try:
+                    while True:
+                        data = connection.recv(65536)
+                        if not data:
+                            break
+                        buffer += data
+                except BlockingIOError:
+                    pass
+                connection.setblocking(True)
+                if b"\r\n\r\n" in buffer:
+                    with self.lock:
+                        self.pipelined += 1
+                connection.sendall(response)
+        except (ConnectionError, OSError):
+            pass
+        finally:
+            connection.close()
+
+    def respond(self, path, headers):
+        layer, column, row = (int(part) for part in path.strip("/").split("/"))
+        with self.lock:
+            count = self.requests[path] = self.requests.get(path, 0) + 1
+            if "if-none-match" in headers:
+                self.conditional[path] = self.conditional.get(path, 0) + 1
+        body = tile_body(layer, column, row)
+        if layer == 0:
+            if headers.get("if-none-match") == '"v1"':
+                return b'HTTP/1.1 304 Not Modified\r\nETag: "v1"\r\nCache-Control: no-cache\r\n\r\n'
+            return self.ok(body, b'ETag: "v1"\r\nCache-Control: no-cache\r\n')
+        if layer == 1:
+            chunks = b"".join(b"%x\r\n%s\r\n" % (len(body[i:i + CHUNK_SIZE]), body[i:i + CHUNK_SIZE])
+                              for i in range(0, len(body), CHUNK_SIZE))
+            return b"HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n" + chunks + b"0\r\n\r\n"
+        if layer == 2 and count == 1:
+            return b"HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n"
+        if layer == 3:
+            return b"HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n"
+        if layer == 4:
+            time.sleep(PIPELINE_DELAY)
+        if layer == 5:
+            return self.ok(body, b'ETag: "v1"\r\nCache-Control: no-store\r\n')
+        return self.ok(body, b"")
+
+    @staticmethod
+    def ok(body, headers):
+        return b"HTTP/1.1 200 OK\r\nContent-Length: %d\r\n%s\r\n%s" % (len(body), headers, body)
+
+
+def main():
+    if len(sys.argv) < 2:
+        print("usage: tile_server.py <HttpTileSourceCheck executable>")
+        return 1
+    server = Server()
+    # a port nobody listens on, for the refused connections
+    closed = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    closed.bind(("127.0.0.1", 0))
+    closedPort = closed.getsockname()[1]
+    closed.close()
+
+    status = subprocess.call([sys.argv[1], str(server.port), str(closedPort)])
+
+    failures = []
+    if server.conditional.get("/0/0/0", 0) < 1:
+        failures.append("no conditional request for the no-cache tile")
+    if server.requests.get("/2/0/0", 0) != 2:
+        failures.append("the tile answered with 503 was requested %d times" % server.requests.get("/2/0/0", 0))
+    if server.pipelined == 0:
+        failures.append("no request was pipelined")
+    if server.conditional.get("/5/0/0", 0) != 0:
+        failures.append("the no-store tile was revalidated")
+    for failure in failures:
+        print("server: " + failure)
+    print("server: %d requests, %d pipelined" % (sum(server.requests.values()), server.pipelined))
+    return status or (1 if failures else 0)
+
+
+if __name__ == "__main__":
+    sys.exit(main())